@@ -28,7 +28,93 @@ string itemToString(const Item& item, const vector<Prod>& prods) {
     return result;
 }
 
-int main(){
+// Terminal bitset: one bit per terminal index
+struct Bits {
+    vector<uint64_t> w;
+    explicit Bits(int n = 0) : w((n + 63) / 64, 0) {}
+    void set(int i) { w[i >> 6] |= 1ULL << (i & 63); }
+    bool test(int i) const { return (w[i >> 6] >> (i & 63)) & 1; }
+    void merge(const Bits& o) { for(size_t i = 0; i < w.size(); i++) w[i] |= o.w[i]; }
+};
+
+// DeRemer & Pennello's Digraph: F(x) = F'(x) U { F(y) | x R y }, solved in a
+// single depth-first pass. Every strongly connected component of R is found
+// with Tarjan's stack and all of its members receive the same set.
+struct Digraph {
+    const vector<vector<int>>& R;
+    vector<Bits>& F;
+    vector<int> N, stk;
+
+    Digraph(const vector<vector<int>>& R, vector<Bits>& F) : R(R), F(F), N(R.size(), 0) {
+        for(int x = 0; x < (int)R.size(); x++) if(N[x] == 0) traverse(x);
+    }
+
+    void traverse(int x) {
+        stk.push_back(x);
+        int d = stk.size();
+        N[x] = d;
+        for(int y : R[x]) {
+            if(N[y] == 0) traverse(y);
+            N[x] = min(N[x], N[y]);
+            F[x].merge(F[y]);
+        }
+        if(N[x] == d) {
+            while(true) {
+                int top = stk.back(); stk.pop_back();
+                N[top] = INT_MAX;
+                if(top == x) break;
+                F[top] = F[x];
+            }
+        }
+    }
+};
+
+// Reference FOLLOW computation: the global while(changed) fixpoint, rebuilding
+// FIRST of the rest of the production at every position on every pass.
+// Used only by --verify; returns the number of passes it needed.
+int followFixpoint(const vector<Prod>& prods, const set<string>& nonterminals,
+                   const map<string, set<string>>& FIRST, const set<string>& nullable,
+                   const string& start, map<string, set<string>>& FOLLOW) {
+    for(const string& nt : nonterminals) FOLLOW[nt];
+    FOLLOW[start].insert("$");
+    int passes = 0;
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        passes++;
+        for(const auto& prod : prods) {
+            for(size_t i = 0; i < prod.rhs.size(); i++) {
+                const string& B = prod.rhs[i];
+                if(nonterminals.find(B) == nonterminals.end()) continue;
+                bool canDeriveEpsilon = true;
+                set<string> firstOfRest;
+                for(size_t j = i + 1; j < prod.rhs.size() && canDeriveEpsilon; j++) {
+                    const string& sym = prod.rhs[j];
+                    if(nonterminals.find(sym) == nonterminals.end()) {
+                        firstOfRest.insert(sym);
+                        canDeriveEpsilon = false;
+                    } else {
+                        const set<string>& f = FIRST.at(sym);
+                        firstOfRest.insert(f.begin(), f.end());
+                        canDeriveEpsilon = nullable.count(sym) > 0;
+                    }
+                }
+                for(const string& f : firstOfRest) {
+                    if(FOLLOW[B].insert(f).second) changed = true;
+                }
+                if(canDeriveEpsilon) {
+                    for(const string& f : FOLLOW[prod.lhs]) {
+                        if(FOLLOW[B].insert(f).second) changed = true;
+                    }
+                }
+            }
+        }
+    }
+    return passes;
+}
+
+int main(int argc, char** argv){
+    bool verify = argc > 1 && string(argv[1]) == "--verify";
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
     int N;
@@ -73,60 +159,113 @@ int main(){
     }
     terminals.insert("$");
 
-    // Compute FOLLOW sets for all nonterminals
-    map<string, set<string>> FOLLOW;
-    for(const string& nt : nonterminals) {
-        FOLLOW[nt] = set<string>();
+    // Index symbols: terminals (including $) for the bitsets, nonterminals
+    // for the digraph nodes
+    vector<string> termList(terminals.begin(), terminals.end());
+    vector<string> ntList(nonterminals.begin(), nonterminals.end());
+    map<string, int> termIdx, ntIdx;
+    for(int i = 0; i < (int)termList.size(); i++) termIdx[termList[i]] = i;
+    for(int i = 0; i < (int)ntList.size(); i++) ntIdx[ntList[i]] = i;
+    int T = termList.size(), NT = ntList.size();
+
+    // Nullable nonterminals, by worklist over productions whose RHS is
+    // entirely nullable
+    vector<char> nullable(NT, 0);
+    {
+        vector<int> pending(prods.size());
+        vector<vector<int>> usedIn(NT);
+        vector<int> work;
+        for(size_t p = 0; p < prods.size(); p++) {
+            for(const string& s : prods[p].rhs) {
+                if(ntIdx.count(s)) { pending[p]++; usedIn[ntIdx[s]].push_back(p); }
+                else pending[p] = INT_MIN;   // contains a terminal: never nullable
+            }
+            if(pending[p] == 0) work.push_back(ntIdx[prods[p].lhs]);
+        }
+        while(!work.empty()) {
+            int A = work.back(); work.pop_back();
+            if(nullable[A]) continue;
+            nullable[A] = 1;
+            for(int p : usedIn[A]) if(--pending[p] == 0) work.push_back(ntIdx[prods[p].lhs]);
+        }
     }
-    FOLLOW[SPrime].insert("$");
-
-    bool changed = true;
-    while(changed) {
-        changed = false;
-        for(const auto& prod : prods) {
-            for(size_t i = 0; i < prod.rhs.size(); i++) {
-                const string& B = prod.rhs[i];
-                if(nonterminals.find(B) == nonterminals.end()) continue;
 
-                // Check if next symbols can derive epsilon
-                bool canDeriveEpsilon = true;
-                set<string> firstOfRest;
-
-                for(size_t j = i + 1; j < prod.rhs.size(); j++) {
-                    const string& sym = prod.rhs[j];
-                    if(terminals.find(sym) != terminals.end()) {
-                        firstOfRest.insert(sym);
-                        canDeriveEpsilon = false;
-                        break;
-                    } else {
-                        // For simplicity, assume nonterminals can't derive epsilon
-                        // This works for the standard expression grammar
-                        canDeriveEpsilon = false;
-                        break;
-                    }
-                }
+    // FIRST: A R_first B when A -> alpha B beta with alpha nullable
+    vector<Bits> FIRSTbits(NT, Bits(T));
+    vector<vector<int>> firstRel(NT);
+    for(const auto& prod : prods) {
+        int A = ntIdx[prod.lhs];
+        for(const string& s : prod.rhs) {
+            auto nt = ntIdx.find(s);
+            if(nt == ntIdx.end()) { FIRSTbits[A].set(termIdx[s]); break; }
+            firstRel[A].push_back(nt->second);
+            if(!nullable[nt->second]) break;
+        }
+    }
+    Digraph solveFirst(firstRel, FIRSTbits);
+
+    // FOLLOW: initial set of B is FIRST of what follows B in each production;
+    // B R_follow A when A -> alpha B beta with beta nullable
+    vector<Bits> FOLLOWbits(NT, Bits(T));
+    vector<vector<int>> followRel(NT);
+    FOLLOWbits[ntIdx[SPrime]].set(termIdx["$"]);
+    for(const auto& prod : prods) {
+        int A = ntIdx[prod.lhs];
+        // walk right to left, carrying FIRST and nullability of the suffix
+        Bits restFirst(T);
+        bool restNullable = true;
+        for(int i = (int)prod.rhs.size() - 1; i >= 0; i--) {
+            const string& s = prod.rhs[i];
+            auto nt = ntIdx.find(s);
+            if(nt == ntIdx.end()) {
+                restFirst = Bits(T);
+                restFirst.set(termIdx[s]);
+                restNullable = false;
+                continue;
+            }
+            int B = nt->second;
+            FOLLOWbits[B].merge(restFirst);
+            if(restNullable && B != A) followRel[B].push_back(A);
+            if(nullable[B]) restFirst.merge(FIRSTbits[B]);
+            else { restFirst = FIRSTbits[B]; restNullable = false; }
+        }
+    }
+    Digraph solveFollow(followRel, FOLLOWbits);
 
-                // Add first of rest to FOLLOW(B)
-                for(const string& f : firstOfRest) {
-                    if(FOLLOW[B].insert(f).second) changed = true;
-                }
+    map<string, set<string>> FOLLOW;
+    for(int n = 0; n < NT; n++) {
+        FOLLOW[ntList[n]];
+        for(int t = 0; t < T; t++) if(FOLLOWbits[n].test(t)) FOLLOW[ntList[n]].insert(termList[t]);
+    }
 
-                // If rest can derive epsilon, add FOLLOW(prod.lhs) to FOLLOW(B)
-                if(canDeriveEpsilon || i == prod.rhs.size() - 1) {
-                    for(const string& f : FOLLOW[prod.lhs]) {
-                        if(FOLLOW[B].insert(f).second) changed = true;
-                    }
-                }
+    if(verify) {
+        map<string, set<string>> FIRSTsets;
+        set<string> nullableSet;
+        for(int n = 0; n < NT; n++) {
+            FIRSTsets[ntList[n]];
+            for(int t = 0; t < T; t++) if(FIRSTbits[n].test(t)) FIRSTsets[ntList[n]].insert(termList[t]);
+            if(nullable[n]) nullableSet.insert(ntList[n]);
+        }
+        map<string, set<string>> reference;
+        int passes = followFixpoint(prods, nonterminals, FIRSTsets, nullableSet, SPrime, reference);
+        bool same = true;
+        cout << "=== FOLLOW sets (digraph, checked against " << passes << "-pass fixpoint) ===\n";
+        for(const string& nt : ntList) {
+            cout << "FOLLOW(" << nt << ") = { ";
+            for(const string& f : FOLLOW[nt]) cout << f << " ";
+            cout << "}";
+            if(FOLLOW[nt] != reference[nt]) {
+                same = false;
+                cout << "   MISMATCH, fixpoint gives { ";
+                for(const string& f : reference[nt]) cout << f << " ";
+                cout << "}";
             }
+            cout << "\n";
         }
+        cout << (same ? "FOLLOW verified\n\n" : "FOLLOW verification FAILED\n\n");
+        if(!same) return 1;
     }
 
-    // Manually set FOLLOW sets for standard expression grammar
-    // This ensures we get the correct results
-    FOLLOW["E"].clear(); FOLLOW["E"].insert("$"); FOLLOW["E"].insert("+"); FOLLOW["E"].insert(")");
-    FOLLOW["T"].clear(); FOLLOW["T"].insert("$"); FOLLOW["T"].insert("+"); FOLLOW["T"].insert("*"); FOLLOW["T"].insert(")");
-    FOLLOW["F"].clear(); FOLLOW["F"].insert("$"); FOLLOW["F"].insert("+"); FOLLOW["F"].insert("*"); FOLLOW["F"].insert(")");
-
     // LR(0) items construction with proper closure
     auto closure = [&](set<Item> kernel) -> set<Item> {
         set<Item> result = kernel;
@@ -0,0 +1,766 @@
+// grammar_model.h
+// Shared grammar model: interned symbols, productions, nullable/FIRST/FOLLOW
+// and the LR(0) automaton with its SLR(1) table. The model is editable one
+// production at a time; rebuild() then recomputes only what an edit can reach:
+//   - nullable and FIRST for nonterminals whose left corner reaches the edit,
+//   - FOLLOW for nonterminals whose FOLLOW relation reaches a changed set,
+//   - LR(0) states whose closure expands an edited nonterminal, plus the
+//     table rows of those states and of states reducing by a changed FOLLOW.
+// All other states keep their numbers and their table rows.
+#ifndef GRAMMAR_MODEL_H
+#define GRAMMAR_MODEL_H
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class GrammarModel {
+public:
+  struct Production {
+    int lhs;
+    std::vector<int> rhs;
+    bool live;
+  };
+
+  struct Item {
+    int prod;
+    int dot;
+    bool operator==(const Item &o) const { return prod == o.prod && dot == o.dot; }
+    bool operator<(const Item &o) const {
+      return prod != o.prod ? prod < o.prod : dot < o.dot;
+    }
+  };
+
+  struct State {
+    std::vector<Item> kernel;
+    std::vector<std::pair<int, int>> trans; // (symbol, target), by symbol
+    std::vector<int> expands;               // nonterminals closed over, sorted
+    std::vector<int> reduces;               // productions complete here
+    bool live = true;
+  };
+
+  // Terminal bitset: one bit per terminal index
+  struct Bits {
+    std::vector<uint64_t> w;
+    explicit Bits(int n = 0) : w((n + 63) / 64, 0) {}
+    void set(int i) { w[i >> 6] |= 1ULL << (i & 63); }
+    bool test(int i) const { return (w[i >> 6] >> (i & 63)) & 1; }
+    bool merge(const Bits &o) {
+      bool ch = false;
+      for (size_t i = 0; i < w.size(); ++i) {
+        uint64_t n = w[i] | o.w[i];
+        if (n != w[i]) {
+          w[i] = n;
+          ch = true;
+        }
+      }
+      return ch;
+    }
+    void clear() { std::fill(w.begin(), w.end(), 0); }
+    bool operator==(const Bits &o) const { return w == o.w; }
+    template <class F> void forEach(F f) const {
+      for (size_t i = 0; i < w.size(); ++i)
+        for (uint64_t x = w[i]; x; x &= x - 1)
+          f((int)(i * 64 + __builtin_ctzll(x)));
+    }
+  };
+
+  // What the last rebuild() touched
+  struct RebuildStats {
+    bool full = false;
+    int firstRecomputed = 0;  // nonterminals in the FIRST region
+    int followRecomputed = 0; // nonterminals in the FOLLOW region
+    int statesRebuilt = 0;    // existing states whose closure was redone
+    int statesAdded = 0;
+    int statesRemoved = 0;
+    int rowsRebuilt = 0;
+  };
+
+  // ACTION cell: 0 empty, s>0 shift to s-1, -1 accept, r<-1 reduce by -r-2
+  static int shiftCell(int s) { return s + 1; }
+  static int reduceCell(int p) { return -p - 2; }
+
+  int symbol(const std::string &name) {
+    auto f = ids_.find(name);
+    if (f != ids_.end())
+      return f->second;
+    int id = (int)names_.size();
+    ids_.emplace(name, id);
+    names_.push_back(name);
+    isNT_.push_back(0);
+    prodsOf_.emplace_back();
+    occ_.emplace_back();
+    structural_ = true;
+    return id;
+  }
+
+  // Adds lhs -> rhs (an empty rhs is epsilon) and returns its index. The
+  // first production added fixes the start symbol.
+  int addProduction(const std::string &lhs, const std::vector<std::string> &rhs) {
+    int A = symbol(lhs);
+    if (!isNT_[A]) {
+      isNT_[A] = 1;
+      structural_ = true;
+    }
+    if (prods_.empty()) {
+      int S = symbol(lhs + "'");
+      isNT_[S] = 1;
+      start_ = A;
+      pushProduction(S, {A});
+    }
+    std::vector<int> r;
+    for (auto &s : rhs)
+      r.push_back(symbol(s));
+    int p = pushProduction(A, r);
+    pending_.push_back(p);
+    return p;
+  }
+
+  // Removes a live production equal to lhs -> rhs; false if there is none
+  bool removeProduction(const std::string &lhs, const std::vector<std::string> &rhs) {
+    auto f = ids_.find(lhs);
+    if (f == ids_.end())
+      return false;
+    std::vector<int> r;
+    for (auto &s : rhs) {
+      auto g = ids_.find(s);
+      if (g == ids_.end())
+        return false;
+      r.push_back(g->second);
+    }
+    auto &list = prodsOf_[f->second];
+    for (size_t k = 0; k < list.size(); ++k) {
+      int p = list[k];
+      if (p == 0 || prods_[p].rhs != r)
+        continue;
+      prods_[p].live = false;
+      list.erase(list.begin() + k);
+      for (int pos = 0; pos < (int)r.size(); ++pos) {
+        auto &o = occ_[r[pos]];
+        o.erase(std::find(o.begin(), o.end(), std::make_pair(p, pos)));
+      }
+      pending_.push_back(p);
+      return true;
+    }
+    return false;
+  }
+
+  // Brings sets, automaton and table up to date with the pending edits.
+  // Edits that introduce a symbol or turn a terminal into a nonterminal
+  // change the table's shape, so they fall back to a full rebuild.
+  RebuildStats rebuild() {
+    if (!built_ || structural_) {
+      rebuildFull();
+      return last_;
+    }
+    last_ = RebuildStats();
+    std::vector<int> edited, removed;
+    int ep = ++epoch_;
+    for (int p : pending_) {
+      if (!prods_[p].live)
+        removed.push_back(p);
+      int A = prods_[p].lhs;
+      if (mark_[A] != ep) {
+        mark_[A] = ep;
+        edited.push_back(A);
+      }
+    }
+
+    std::vector<int> nullChanged = updateNullable(edited);
+
+    // FIRST: every nonterminal whose left corner reaches an edit
+    std::vector<int> seeds = edited;
+    seeds.insert(seeds.end(), nullChanged.begin(), nullChanged.end());
+    std::vector<int> firstRegion = reach(seeds, [&](int Y, std::vector<int> &out) {
+      for (auto &o : occ_[Y])
+        if (prefixNullable(o.first, o.second))
+          out.push_back(prods_[o.first].lhs);
+    });
+    std::vector<int> firstChanged = solveFirst(firstRegion);
+    last_.firstRecomputed = (int)firstRegion.size();
+
+    // FOLLOW: symbols of the edited productions, symbols standing before a
+    // changed FIRST/nullable, and everything whose FOLLOW includes theirs
+    seeds.clear();
+    for (int p : pending_)
+      for (int X : prods_[p].rhs)
+        if (isNT_[X])
+          seeds.push_back(X);
+    firstChanged.insert(firstChanged.end(), nullChanged.begin(), nullChanged.end());
+    for (int Y : firstChanged)
+      for (auto &o : occ_[Y])
+        for (int k = 0; k < o.second; ++k)
+          if (isNT_[prods_[o.first].rhs[k]])
+            seeds.push_back(prods_[o.first].rhs[k]);
+    std::vector<int> followRegion = reach(seeds, [&](int B, std::vector<int> &out) {
+      for (int p : prodsOf_[B])
+        for (int k = (int)prods_[p].rhs.size() - 1; k >= 0; --k) {
+          int X = prods_[p].rhs[k];
+          if (!isNT_[X])
+            break;
+          out.push_back(X);
+          if (!nullable_[X])
+            break;
+        }
+    });
+    std::vector<int> followChanged = solveFollow(followRegion);
+    last_.followRecomputed = (int)followRegion.size();
+
+    // LR(0): states holding a removed production in their kernel are gone;
+    // states closing over an edited nonterminal are expanded again
+    std::vector<int> rows;
+    for (int p : removed)
+      for (int s : kernelStates_[p])
+        if (states_[s].live)
+          killState(s);
+    ep = ++epoch_;
+    std::vector<int> work;
+    for (int A : edited)
+      for (int s : expandersOf_[A])
+        if (states_[s].live && stateMark_[s] != ep &&
+            std::binary_search(states_[s].expands.begin(), states_[s].expands.end(), A)) {
+          stateMark_[s] = ep;
+          work.push_back(s);
+        }
+    last_.statesRebuilt = (int)work.size();
+    size_t firstNew = states_.size();
+    dropped_ = false;
+    for (size_t i = 0; i < work.size(); ++i)
+      expandState(work[i], work);
+    last_.statesAdded = (int)(states_.size() - firstNew);
+    if (dropped_)
+      collectUnreachable();
+    ep = ++epoch_;
+    for (int s : work)
+      if (states_[s].live) {
+        stateMark_[s] = ep;
+        rows.push_back(s);
+      }
+
+    for (int B : followChanged)
+      for (int s : reducersOf_[B])
+        if (states_[s].live && stateMark_[s] != ep) {
+          stateMark_[s] = ep;
+          rows.push_back(s);
+        }
+    for (int s : rows)
+      buildRow(s);
+    last_.rowsRebuilt = (int)rows.size();
+    pending_.clear();
+    return last_;
+  }
+
+  void rebuildFull() {
+    last_ = RebuildStats();
+    last_.full = true;
+    if (ids_.find("$") == ids_.end())
+      symbol("$");
+    int n = (int)names_.size();
+    tix_.assign(n, -1);
+    terms_.clear();
+    for (int s = 0; s < n; ++s)
+      if (!isNT_[s]) {
+        tix_[s] = (int)terms_.size();
+        terms_.push_back(s);
+      }
+    eof_ = ids_["$"];
+    mark_.assign(n, 0);
+    num_.assign(n, 0);
+    expandersOf_.assign(n, {});
+    reducersOf_.assign(n, {});
+    nullable_.assign(n, 0);
+    first_.assign(n, Bits(T()));
+    follow_.assign(n, Bits(T()));
+
+    std::vector<int> all;
+    for (int s = 0; s < n; ++s)
+      if (isNT_[s])
+        all.push_back(s);
+    updateNullable(all);
+    solveFirst(all);
+    solveFollow(all);
+    last_.firstRecomputed = last_.followRecomputed = (int)all.size();
+
+    states_.clear();
+    action_.clear();
+    stateConflicts_.clear();
+    stateMark_.clear();
+    kernelIndex_.clear();
+    kernelStates_.assign(prods_.size(), {});
+    conflicts_ = 0;
+    std::vector<int> work = {newState({{0, 0}})};
+    for (size_t i = 0; i < work.size(); ++i)
+      expandState(work[i], work);
+    for (int s = 0; s < (int)states_.size(); ++s)
+      buildRow(s);
+    last_.statesAdded = last_.rowsRebuilt = (int)states_.size();
+    pending_.clear();
+    structural_ = false;
+    built_ = true;
+  }
+
+  // Same reachable automaton, table and sets, up to state numbering
+  bool equivalentTo(const GrammarModel &o) const {
+    if (names_ != o.names_ || conflicts_ != o.conflicts_)
+      return false;
+    for (int s = 0; s < (int)names_.size(); ++s)
+      if (isNT_[s] && (nullable_[s] != o.nullable_[s] || !(first_[s] == o.first_[s]) ||
+                       !(follow_[s] == o.follow_[s])))
+        return false;
+    std::vector<int> to(states_.size(), -1), from(o.states_.size(), -1);
+    std::vector<int> queue = {0};
+    to[0] = from[0] = 0;
+    for (size_t i = 0; i < queue.size(); ++i) {
+      int a = queue[i], b = to[a];
+      const State &x = states_[a], &y = o.states_[b];
+      if (!(x.kernel == y.kernel) || x.trans.size() != y.trans.size())
+        return false;
+      for (size_t k = 0; k < x.trans.size(); ++k) {
+        int ta = x.trans[k].second, tb = y.trans[k].second;
+        if (x.trans[k].first != y.trans[k].first)
+          return false;
+        if (to[ta] < 0 && from[tb] < 0) {
+          to[ta] = tb;
+          from[tb] = ta;
+          queue.push_back(ta);
+        } else if (to[ta] != tb) {
+          return false;
+        }
+      }
+      for (int t = 0; t < T(); ++t) {
+        int u = action_[a][t], v = o.action_[b][t];
+        if (u > 0 ? v <= 0 || to[u - 1] != v - 1 : u != v)
+          return false;
+      }
+    }
+    return true;
+  }
+
+  int T() const { return (int)terms_.size(); }
+  int symbolCount() const { return (int)names_.size(); }
+  const std::string &name(int s) const { return names_[s]; }
+  bool isNonterminal(int s) const { return isNT_[s]; }
+  int terminal(int t) const { return terms_[t]; }
+  int terminalIndex(int s) const { return tix_[s]; }
+  int eof() const { return eof_; }
+  int startSymbol() const { return start_; }
+  const std::vector<Production> &productions() const { return prods_; }
+  const std::vector<State> &states() const { return states_; }
+  int liveStates() const {
+    int n = 0;
+    for (auto &s : states_)
+      n += s.live;
+    return n;
+  }
+  int liveProductions() const {
+    int n = 0;
+    for (auto &p : prods_)
+      n += p.live;
+    return n;
+  }
+  bool nullable(int A) const { return nullable_[A]; }
+  const Bits &first(int A) const { return first_[A]; }
+  const Bits &follow(int A) const { return follow_[A]; }
+  int action(int s, int t) const { return action_[s][t]; }
+  int gotoState(int s, int A) const {
+    auto &tr = states_[s].trans;
+    auto f = std::lower_bound(tr.begin(), tr.end(), std::make_pair(A, INT_MIN));
+    return f != tr.end() && f->first == A ? f->second : -1;
+  }
+  int conflicts() const { return conflicts_; }
+
+private:
+  struct KernelHash {
+    size_t operator()(const std::vector<Item> &k) const {
+      size_t h = k.size();
+      for (auto &it : k)
+        h = h * 1000003u ^ (((size_t)it.prod << 16) | (size_t)it.dot);
+      return h;
+    }
+  };
+
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, int> ids_;
+  std::vector<char> isNT_;
+  std::vector<int> tix_, terms_; // symbol -> terminal index and back
+  int start_ = -1, eof_ = -1;
+
+  std::vector<Production> prods_;
+  std::vector<std::vector<int>> prodsOf_;               // live productions per lhs
+  std::vector<std::vector<std::pair<int, int>>> occ_;   // (prod, pos) uses per symbol
+  std::vector<int> pending_;                            // edited since last rebuild
+
+  std::vector<char> nullable_;
+  std::vector<Bits> first_, follow_;
+
+  std::vector<State> states_;
+  std::vector<std::vector<int>> action_;
+  std::vector<int> stateConflicts_;
+  int conflicts_ = 0;
+  std::unordered_map<std::vector<Item>, int, KernelHash> kernelIndex_;
+  std::vector<std::vector<int>> kernelStates_; // prod -> states with it in the kernel
+  std::vector<std::vector<int>> expandersOf_;  // nonterminal -> states closing over it
+  std::vector<std::vector<int>> reducersOf_;   // nonterminal -> states reducing to it
+
+  std::vector<int> mark_, num_, stateMark_; // scratch, stamped by epoch_
+  int epoch_ = 0;
+  bool built_ = false, structural_ = false;
+  bool dropped_ = false; // an expansion lost or retargeted a transition
+  RebuildStats last_;
+
+  int pushProduction(int A, std::vector<int> rhs) {
+    int p = (int)prods_.size();
+    for (int pos = 0; pos < (int)rhs.size(); ++pos)
+      occ_[rhs[pos]].push_back({p, pos});
+    prods_.push_back({A, std::move(rhs), true});
+    prodsOf_[A].push_back(p);
+    if (built_)
+      kernelStates_.emplace_back();
+    return p;
+  }
+
+  bool prefixNullable(int p, int pos) const {
+    for (int k = 0; k < pos; ++k) {
+      int X = prods_[p].rhs[k];
+      if (!isNT_[X] || !nullable_[X])
+        return false;
+    }
+    return true;
+  }
+
+  // Breadth-first closure of seeds under next(); each symbol once
+  template <class Next> std::vector<int> reach(const std::vector<int> &seeds, Next next) {
+    int ep = ++epoch_;
+    std::vector<int> out, buf;
+    for (int s : seeds)
+      if (mark_[s] != ep) {
+        mark_[s] = ep;
+        out.push_back(s);
+      }
+    for (size_t i = 0; i < out.size(); ++i) {
+      buf.clear();
+      next(out[i], buf);
+      for (int y : buf)
+        if (mark_[y] != ep) {
+          mark_[y] = ep;
+          out.push_back(y);
+        }
+    }
+    return out;
+  }
+
+  // Nullability can only flow through productions made of nonterminals, so
+  // the region is the edited nonterminals plus their users via such
+  // productions; it is reset and solved as a least fixpoint.
+  std::vector<int> updateNullable(const std::vector<int> &edited) {
+    std::vector<int> region = reach(edited, [&](int Y, std::vector<int> &out) {
+      for (auto &o : occ_[Y]) {
+        bool allNT = true;
+        for (int X : prods_[o.first].rhs)
+          allNT = allNT && isNT_[X];
+        if (allNT)
+          out.push_back(prods_[o.first].lhs);
+      }
+    });
+    std::vector<char> old;
+    for (int A : region) {
+      old.push_back(nullable_[A]);
+      nullable_[A] = 0;
+    }
+    for (bool ch = true; ch;) {
+      ch = false;
+      for (int A : region) {
+        if (nullable_[A])
+          continue;
+        for (int p : prodsOf_[A])
+          if (prefixNullable(p, (int)prods_[p].rhs.size())) {
+            nullable_[A] = 1;
+            ch = true;
+            break;
+          }
+      }
+    }
+    std::vector<int> changed;
+    for (size_t i = 0; i < region.size(); ++i)
+      if (old[i] != nullable_[region[i]])
+        changed.push_back(region[i]);
+    return changed;
+  }
+
+  // Digraph (DeRemer & Pennello) restricted to `region`: F(x) = init(x)
+  // joined with F(y) for every successor y, one strongly connected component
+  // at a time. Successors outside the region are already final. Iterative,
+  // so long chains of nonterminals cannot overflow the stack. Returns the
+  // region members whose set changed.
+  template <class Init, class Succ>
+  std::vector<int> digraph(const std::vector<int> &region, std::vector<Bits> &F, Init init,
+                           Succ succ) {
+    struct Frame {
+      int x, depth;
+      std::vector<int> succs;
+      size_t next;
+    };
+    int ep = ++epoch_;
+    std::vector<Bits> old;
+    for (int x : region) {
+      mark_[x] = ep;
+      num_[x] = 0;
+      old.push_back(F[x]);
+    }
+    std::vector<int> stack;
+    std::vector<Frame> calls;
+    auto enter = [&](int x) {
+      stack.push_back(x);
+      calls.push_back({x, (int)stack.size(), {}, 0});
+      num_[x] = (int)stack.size();
+      F[x].clear();
+      init(x, F[x]);
+      succ(x, calls.back().succs);
+    };
+    for (int root : region) {
+      if (num_[root] != 0)
+        continue;
+      enter(root);
+      while (!calls.empty()) {
+        Frame &f = calls.back();
+        if (f.next < f.succs.size()) {
+          int y = f.succs[f.next++];
+          int x = f.x;
+          if (mark_[y] != ep) {
+            F[x].merge(F[y]);
+          } else if (num_[y] == 0) {
+            enter(y);
+          } else {
+            num_[x] = std::min(num_[x], num_[y]);
+            F[x].merge(F[y]);
+          }
+          continue;
+        }
+        int x = f.x, depth = f.depth;
+        calls.pop_back();
+        if (num_[x] == depth) {
+          for (;;) {
+            int top = stack.back();
+            stack.pop_back();
+            num_[top] = INT_MAX;
+            if (top == x)
+              break;
+            F[top] = F[x];
+          }
+        }
+        if (!calls.empty()) {
+          int parent = calls.back().x;
+          num_[parent] = std::min(num_[parent], num_[x]);
+          F[parent].merge(F[x]);
+        }
+      }
+    }
+    std::vector<int> changed;
+    for (size_t i = 0; i < region.size(); ++i)
+      if (!(old[i] == F[region[i]]))
+        changed.push_back(region[i]);
+    return changed;
+  }
+
+  // FIRST(A): terminals and nonterminals in the nullable left corner of A
+  std::vector<int> solveFirst(const std::vector<int> &region) {
+    auto corner = [&](int A, auto visit) {
+      for (int p : prodsOf_[A])
+        for (int X : prods_[p].rhs) {
+          visit(X);
+          if (!isNT_[X] || !nullable_[X])
+            break;
+        }
+    };
+    return digraph(
+        region, first_,
+        [&](int A, Bits &b) {
+          corner(A, [&](int X) {
+            if (!isNT_[X])
+              b.set(tix_[X]);
+          });
+        },
+        [&](int A, std::vector<int> &out) {
+          corner(A, [&](int X) {
+            if (isNT_[X])
+              out.push_back(X);
+          });
+        });
+  }
+
+  // FOLLOW(X): FIRST of what follows each use of X, plus FOLLOW(lhs) when
+  // that remainder is nullable
+  std::vector<int> solveFollow(const std::vector<int> &region) {
+    return digraph(
+        region, follow_,
+        [&](int X, Bits &b) {
+          if (X == start_)
+            b.set(tix_[eof_]);
+          for (auto &o : occ_[X]) {
+            auto &rhs = prods_[o.first].rhs;
+            for (size_t k = o.second + 1; k < rhs.size(); ++k) {
+              if (!isNT_[rhs[k]]) {
+                b.set(tix_[rhs[k]]);
+                break;
+              }
+              b.merge(first_[rhs[k]]);
+              if (!nullable_[rhs[k]])
+                break;
+            }
+          }
+        },
+        [&](int X, std::vector<int> &out) {
+          for (auto &o : occ_[X])
+            if (o.first != 0 && suffixNullable(o.first, o.second + 1))
+              out.push_back(prods_[o.first].lhs);
+        });
+  }
+
+  bool suffixNullable(int p, int from) const {
+    auto &rhs = prods_[p].rhs;
+    for (size_t k = from; k < rhs.size(); ++k)
+      if (!isNT_[rhs[k]] || !nullable_[rhs[k]])
+        return false;
+    return true;
+  }
+
+  int newState(std::vector<Item> kernel) {
+    int s = (int)states_.size();
+    for (size_t k = 0; k < kernel.size(); ++k)
+      if (k == 0 || kernel[k].prod != kernel[k - 1].prod)
+        kernelStates_[kernel[k].prod].push_back(s);
+    kernelIndex_.emplace(kernel, s);
+    states_.emplace_back();
+    states_.back().kernel = std::move(kernel);
+    action_.emplace_back(T(), 0);
+    stateConflicts_.push_back(0);
+    stateMark_.push_back(0);
+    return s;
+  }
+
+  void killState(int s) {
+    State &st = states_[s];
+    st.live = false;
+    kernelIndex_.erase(st.kernel);
+    st.trans.clear();
+    st.reduces.clear();
+    conflicts_ -= stateConflicts_[s];
+    stateConflicts_[s] = 0;
+    std::fill(action_[s].begin(), action_[s].end(), 0);
+    ++last_.statesRemoved;
+  }
+
+  // Dropped transitions can strand states; anything not reachable from the
+  // start state is removed so that it no longer counts in the table
+  void collectUnreachable() {
+    int ep = ++epoch_;
+    std::vector<int> queue = {0};
+    stateMark_[0] = ep;
+    for (size_t i = 0; i < queue.size(); ++i)
+      for (auto &tr : states_[queue[i]].trans)
+        if (stateMark_[tr.second] != ep) {
+          stateMark_[tr.second] = ep;
+          queue.push_back(tr.second);
+        }
+    for (int s = 0; s < (int)states_.size(); ++s)
+      if (states_[s].live && stateMark_[s] != ep)
+        killState(s);
+  }
+
+  // Closure of the kernel, its reductions and goto targets; unseen target
+  // kernels become new states and are queued on `work`
+  void expandState(int s, std::vector<int> &work) {
+    std::vector<Item> items = states_[s].kernel;
+    std::vector<int> expands, reduces;
+    int ep = ++epoch_;
+    for (size_t i = 0; i < items.size(); ++i) {
+      auto &rhs = prods_[items[i].prod].rhs;
+      if (items[i].dot == (int)rhs.size()) {
+        reduces.push_back(items[i].prod);
+        continue;
+      }
+      int X = rhs[items[i].dot];
+      if (!isNT_[X] || mark_[X] == ep)
+        continue;
+      mark_[X] = ep;
+      expands.push_back(X);
+      for (int q : prodsOf_[X])
+        items.push_back({q, 0});
+    }
+    std::sort(expands.begin(), expands.end());
+    for (int X : expands)
+      if (!std::binary_search(states_[s].expands.begin(), states_[s].expands.end(), X))
+        expandersOf_[X].push_back(s);
+    for (int p : reduces) {
+      int A = prods_[p].lhs;
+      bool had = false;
+      for (int q : states_[s].reduces)
+        had = had || prods_[q].lhs == A;
+      if (!had)
+        reducersOf_[A].push_back(s);
+    }
+
+    std::vector<std::pair<int, Item>> moves;
+    for (auto &it : items) {
+      auto &rhs = prods_[it.prod].rhs;
+      if (it.dot < (int)rhs.size())
+        moves.push_back({rhs[it.dot], {it.prod, it.dot + 1}});
+    }
+    std::sort(moves.begin(), moves.end(), [](const std::pair<int, Item> &a, const std::pair<int, Item> &b) {
+      return a.first != b.first ? a.first < b.first : a.second < b.second;
+    });
+    std::vector<std::pair<int, int>> trans;
+    for (size_t i = 0; i < moves.size();) {
+      size_t j = i;
+      std::vector<Item> kernel;
+      for (; j < moves.size() && moves[j].first == moves[i].first; ++j)
+        kernel.push_back(moves[j].second);
+      auto f = kernelIndex_.find(kernel);
+      int tgt;
+      if (f != kernelIndex_.end()) {
+        tgt = f->second;
+      } else {
+        tgt = newState(std::move(kernel));
+        work.push_back(tgt);
+      }
+      trans.push_back({moves[i].first, tgt});
+      i = j;
+    }
+    State &st = states_[s];
+    for (auto &tr : st.trans)
+      if (!std::binary_search(trans.begin(), trans.end(), tr))
+        dropped_ = true;
+    st.expands = std::move(expands);
+    st.reduces = std::move(reduces);
+    st.trans = std::move(trans);
+  }
+
+  void buildRow(int s) {
+    std::vector<int> &row = action_[s];
+    std::fill(row.begin(), row.end(), 0);
+    int c = 0;
+    for (auto &tr : states_[s].trans)
+      if (!isNT_[tr.first])
+        row[tix_[tr.first]] = shiftCell(tr.second);
+    for (int p : states_[s].reduces) {
+      if (p == 0) {
+        row[tix_[eof_]] = -1;
+        continue;
+      }
+      follow_[prods_[p].lhs].forEach([&](int t) {
+        if (row[t] == 0)
+          row[t] = reduceCell(p);
+        else if (row[t] != reduceCell(p))
+          ++c;
+      });
+    }
+    conflicts_ += c - stateConflicts_[s];
+    stateConflicts_[s] = c;
+  }
+};
+
+#endif // GRAMMAR_MODEL_H
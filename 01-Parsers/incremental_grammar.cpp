@@ -0,0 +1,179 @@
+// incremental_grammar.cpp
+// Edits a grammar one production at a time and keeps its SLR(1) table up to
+// date through GrammarModel::rebuild(), which only recomputes the FIRST/FOLLOW
+// sets and LR(0) states an edit can reach.
+//
+// Input: the grammar in the usual format (count, then "A -> x y", eps for an
+// empty right side), followed by edit lines "+ A -> x y" or "- A -> x y".
+// Compile: g++ -O2 incremental_grammar.cpp -o incremental_grammar
+//   ./incremental_grammar < grammar.txt
+//   ./incremental_grammar --bench N     (generated grammar, ~N nonterminals)
+
+#include <bits/stdc++.h>
+#include "grammar_model.h"
+using namespace std;
+
+using Clock = chrono::steady_clock;
+double msSince(Clock::time_point t){ return chrono::duration<double, milli>(Clock::now()-t).count(); }
+
+bool parseProduction(const string& line, string& lhs, vector<string>& rhs){
+    stringstream ss(line);
+    string arrow, tok;
+    if(!(ss >> lhs >> arrow) || arrow != "->") return false;
+    rhs.clear();
+    while(ss >> tok) rhs.push_back(tok);
+    if(rhs.size()==1 && rhs[0]=="eps") rhs.clear();
+    return true;
+}
+
+string prodText(const GrammarModel& g, int p){
+    auto& pr = g.productions()[p];
+    string s = g.name(pr.lhs) + " ->";
+    if(pr.rhs.empty()) s += " eps";
+    for(int X: pr.rhs) s += " " + g.name(X);
+    return s;
+}
+
+void printStats(const GrammarModel::RebuildStats& st, double ms){
+    if(st.full){ cout<<"  full rebuild ("<<fixed<<setprecision(3)<<ms<<" ms)\n"; return; }
+    cout<<"  FIRST recomputed for "<<st.firstRecomputed<<" nonterminal(s), FOLLOW for "<<st.followRecomputed<<"\n";
+    cout<<"  states: "<<st.statesRebuilt<<" rebuilt, "<<st.statesAdded<<" added, "<<st.statesRemoved<<" removed; "
+        <<st.rowsRebuilt<<" table row(s) rebuilt ("<<fixed<<setprecision(3)<<ms<<" ms)\n";
+}
+
+void printTable(const GrammarModel& g){
+    auto cellText = [](int v){
+        if(v>0) return string("s") + to_string(v-1);
+        if(v==-1) return string("acc");
+        if(v<-1) return string("r") + to_string(-v-2);
+        return string("");
+    };
+    cout<<"\n=== Productions ===\n";
+    for(int p=0;p<(int)g.productions().size();++p)
+        if(g.productions()[p].live) cout<<"("<<p<<") "<<prodText(g,p)<<"\n";
+
+    vector<int> nts;
+    for(int s=0;s<g.symbolCount();++s) if(g.isNonterminal(s) && s!=g.productions()[0].lhs) nts.push_back(s);
+    int colW = 8;
+    cout<<"\n=== SLR Table ===\n";
+    cout<<left<<setw(8)<<"State"<<" | ";
+    for(int t=0;t<g.T();++t) cout<<left<<setw(colW)<<g.name(g.terminal(t));
+    cout<<"| ";
+    for(int A: nts) cout<<left<<setw(colW)<<g.name(A);
+    cout<<"\n";
+    for(int s=0;s<(int)g.states().size();++s){
+        if(!g.states()[s].live) continue;
+        cout<<left<<setw(8)<<s<<" | ";
+        for(int t=0;t<g.T();++t) cout<<left<<setw(colW)<<cellText(g.action(s,t));
+        cout<<"| ";
+        for(int A: nts){ int j = g.gotoState(s,A); cout<<left<<setw(colW)<<(j>=0 ? to_string(j) : string("")); }
+        cout<<"\n";
+    }
+    cout<<"\n"<<g.liveStates()<<" state(s), "<<g.conflicts()<<" conflict(s)\n";
+}
+
+// Blocks of five nonterminals: expression levels E/T/F with left recursion,
+// an L -> R -> L t cycle and a link from each block to the next
+void generateGrammar(GrammarModel& g, int nts){
+    int blocks = max(1, nts/5);
+    for(int b=0;b<blocks;++b){
+        string s = to_string(b);
+        string E = "E"+s, T = "T"+s, F = "F"+s, L = "L"+s, R = "R"+s;
+        string next = b+1<blocks ? "E"+to_string(b+1) : "num";
+        g.addProduction(E, {E, "+", T});
+        g.addProduction(E, {T});
+        g.addProduction(T, {T, "*", F});
+        g.addProduction(T, {F});
+        g.addProduction(F, {L});
+        g.addProduction(F, {"call", "(", ")"});
+        g.addProduction(F, {"call", "(", E, ")"});
+        g.addProduction(F, {"id"});
+        g.addProduction(L, {R});
+        g.addProduction(R, {L, "t"});
+        g.addProduction(R, {"y"});
+        g.addProduction(R, {"(", next, ")"});
+    }
+}
+
+int bench(int nts){
+    GrammarModel g;
+    generateGrammar(g, nts);
+    auto t0 = Clock::now();
+    g.rebuild();
+    double first = msSince(t0);
+    cout<<"Grammar: "<<g.liveProductions()-1<<" productions, "<<g.liveStates()<<" LR(0) states, "
+        <<g.conflicts()<<" conflict(s)\n";
+    cout<<"Initial build: "<<fixed<<setprecision(2)<<first<<" ms\n";
+
+    // one-production edits spread over the grammar: each adds an
+    // alternative that changes FIRST along a whole block, then removes it
+    int blocks = max(1, nts/5), edits = 0;
+    double incMs = 0, fullMs = 0;
+    mt19937 rng(12345);
+    for(int k=0;k<20;++k){
+        string b = to_string(rng()%blocks);
+        vector<string> rhs = {"call", "y"};
+        for(int step=0;step<2;++step){
+            if(step==0) g.addProduction("R"+b, rhs);
+            else g.removeProduction("R"+b, rhs);
+            auto t = Clock::now();
+            g.rebuild();
+            incMs += msSince(t);
+            ++edits;
+
+            GrammarModel ref = g;
+            t = Clock::now();
+            ref.rebuildFull();
+            fullMs += msSince(t);
+            if(!g.equivalentTo(ref)){
+                cout<<"MISMATCH after "<<(step ? "removing" : "adding")<<" R"<<b<<" -> call y\n";
+                return 1;
+            }
+        }
+    }
+    cout<<"Edits: "<<edits<<" (each checked against a full rebuild)\n";
+    cout<<"Full rebuild:        "<<fixed<<setprecision(3)<<fullMs/edits<<" ms per edit\n";
+    cout<<"Incremental rebuild: "<<fixed<<setprecision(3)<<incMs/edits<<" ms per edit\n";
+    cout<<"Speedup: "<<fixed<<setprecision(1)<<fullMs/max(incMs, 1e-9)<<"x\n";
+    return 0;
+}
+
+int main(int argc, char** argv){
+    if(argc > 2 && string(argv[1]) == "--bench") return bench(atoi(argv[2]));
+
+    ios::sync_with_stdio(false);
+    cin.tie(nullptr);
+    int N; if(!(cin>>N)) return 0;
+    string line, lhs;
+    vector<string> rhs;
+    getline(cin,line);
+    GrammarModel g;
+    for(int i=0;i<N;i++){
+        getline(cin,line);
+        if(line.empty()){ i--; continue; }
+        if(parseProduction(line, lhs, rhs)) g.addProduction(lhs, rhs);
+    }
+    auto t0 = Clock::now();
+    auto st = g.rebuild();
+    cout<<"Initial grammar: "<<g.liveStates()<<" state(s), "<<g.conflicts()<<" conflict(s)\n";
+    printStats(st, msSince(t0));
+
+    while(getline(cin,line)){
+        if(line.empty()) continue;
+        char op = line[0];
+        if((op!='+' && op!='-') || !parseProduction(line.substr(1), lhs, rhs)){
+            cout<<"Ignoring: "<<line<<"\n";
+            continue;
+        }
+        cout<<"\n"<<line<<"\n";
+        if(op=='+') g.addProduction(lhs, rhs);
+        else if(!g.removeProduction(lhs, rhs)){ cout<<"  no such production\n"; continue; }
+        t0 = Clock::now();
+        st = g.rebuild();
+        printStats(st, msSince(t0));
+        cout<<"  "<<g.liveStates()<<" state(s), "<<g.conflicts()<<" conflict(s)\n";
+    }
+
+    printTable(g);
+    return 0;
+}
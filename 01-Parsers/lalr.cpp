@@ -1,13 +1,17 @@
 // LALR (Look-Ahead LR) parser generator: builds LALR parse table by merging LR(1) states. Compile: g++ lalr.cpp -o lalr && ./lalr
 #include <algorithm>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <set>
 #include <string>
+#include <tuple>
 #include <vector>
 
+#include "packed_table.h"
+
 using namespace std;
 
 struct Production {
@@ -71,6 +75,14 @@ private:
   char start_symbol = 0;
   char augmented_symbol = 0;
 
+  // Optional table transformations
+  map<int, int> default_reduction; // state -> production reduced on any
+                                   // lookahead without an explicit entry
+  int default_entries_removed = 0;
+  // (state, nonterminal, lookahead) -> (state after the chain of unit
+  // reductions, number of reductions skipped)
+  map<tuple<int, char, char>, pair<int, int>> unit_goto;
+
   void finalizeGrammar() {
     set<char> all_symbols;
     for (const auto &p : productions) {
@@ -429,7 +441,33 @@ private:
     }
   }
 
+  bool isUnitRule(int prod_num) const {
+    const string &rhs = productions[prod_num].right;
+    return prod_num != 0 && rhs.size() == 1 &&
+           non_terminals.find(rhs[0]) != non_terminals.end();
+  }
+
+  // Explicit ACTION entry, or the state's default reduction if it has one
+  string lookupAction(int state, char a) const {
+    auto it = action_table.find({state, a});
+    if (it != action_table.end())
+      return it->second;
+    auto d = default_reduction.find(state);
+    if (d != default_reduction.end())
+      return "r" + to_string(d->second);
+    return "";
+  }
+
 public:
+  struct ParseResult {
+    bool accepted = false;
+    int shifts = 0;
+    int reductions = 0;
+    int units_skipped = 0;
+
+    int steps() const { return shifts + reductions; }
+  };
+
   void addProduction(char left, const string &right) {
     productions.push_back(Production(left, right));
     non_terminals.insert(left);
@@ -444,6 +482,137 @@ public:
     constructParseTable();
   }
 
+  // In each state, the most frequent reduction becomes the default and its
+  // explicit entries are dropped. An erroneous token may then cause a few
+  // extra reductions before the error is found, but is never shifted.
+  void applyDefaultReductions() {
+    default_reduction.clear();
+    default_entries_removed = 0;
+    for (size_t i = 0; i < lalr_states.size(); ++i) {
+      auto first = action_table.lower_bound({(int)i, numeric_limits<char>::min()});
+      map<string, int> counts;
+      for (auto it = first; it != action_table.end() && it->first.first == (int)i; ++it) {
+        if (it->second[0] == 'r')
+          counts[it->second]++;
+      }
+      if (counts.empty())
+        continue;
+
+      string best;
+      int best_count = 0;
+      for (const auto &c : counts) {
+        if (c.second > best_count) {
+          best = c.first;
+          best_count = c.second;
+        }
+      }
+      default_reduction[(int)i] = stoi(best.substr(1));
+      for (auto it = first; it != action_table.end() && it->first.first == (int)i;) {
+        if (it->second == best) {
+          it = action_table.erase(it);
+          ++default_entries_removed;
+        } else {
+          ++it;
+        }
+      }
+    }
+  }
+
+  // For every GOTO on a nonterminal and every lookahead, follow the chain of
+  // unit reductions A -> B the target state would perform on that lookahead.
+  // The driver then jumps straight to the end of the chain instead of
+  // pushing, reducing and popping once per link. Unit rules carry no
+  // semantic action in this parser, so all of them can be bypassed.
+  void computeUnitBypass() {
+    unit_goto.clear();
+    for (const auto &entry : goto_table) {
+      auto [state, X] = entry.first;
+      if (non_terminals.find(X) == non_terminals.end())
+        continue;
+
+      for (char a : terminals) {
+        int target = entry.second;
+        int skipped = 0;
+        while (skipped <= (int)productions.size()) {
+          string action = lookupAction(target, a);
+          if (action.size() < 2 || action[0] != 'r')
+            break;
+          int p = stoi(action.substr(1));
+          if (!isUnitRule(p))
+            break;
+          auto g = goto_table.find({state, productions[p].left});
+          if (g == goto_table.end())
+            break;
+          target = g->second;
+          ++skipped;
+        }
+        if (skipped > 0)
+          unit_goto[{state, X, a}] = {target, skipped};
+      }
+    }
+  }
+
+  // Flat copy of ACTION/GOTO (default reductions included) for the
+  // runtime parse loop
+  PackedTable pack() const {
+    vector<char> terms(terminals.begin(), terminals.end());
+    vector<char> nts(non_terminals.begin(), non_terminals.end());
+    vector<pair<char, int>> prods;
+    for (const auto &p : productions)
+      prods.push_back({p.left, p.right == "e" ? 0 : (int)p.right.size()});
+    return PackedTable((int)lalr_states.size(), terms, nts, prods, action_table,
+                       goto_table, default_reduction);
+  }
+
+  // Table-driven parse of a string of terminal characters; counts shifts and
+  // reductions so the effect of the transformations can be measured
+  ParseResult parse(const string &input, bool bypass_units) const {
+    ParseResult r;
+    vector<int> stack = {0};
+    string tokens = input + '$';
+    size_t ip = 0;
+
+    while (true) {
+      char a = tokens[ip];
+      string action = lookupAction(stack.back(), a);
+      if (action.empty())
+        return r;
+      if (action == "acc") {
+        r.accepted = true;
+        return r;
+      }
+      if (action[0] == 's') {
+        stack.push_back(stoi(action.substr(1)));
+        ++ip;
+        ++r.shifts;
+        continue;
+      }
+
+      int p = stoi(action.substr(1));
+      const string &rhs = productions[p].right;
+      size_t len = (rhs == "e") ? 0 : rhs.size();
+      if (len >= stack.size())
+        return r;
+      stack.resize(stack.size() - len);
+      ++r.reductions;
+
+      int state = stack.back();
+      char A = productions[p].left;
+      if (bypass_units) {
+        auto u = unit_goto.find({state, A, a});
+        if (u != unit_goto.end()) {
+          stack.push_back(u->second.first);
+          r.units_skipped += u->second.second;
+          continue;
+        }
+      }
+      auto g = goto_table.find({state, A});
+      if (g == goto_table.end())
+        return r;
+      stack.push_back(g->second);
+    }
+  }
+
   void printProductions() {
     cout << "\nGRAMMAR PRODUCTIONS (indexed):\n";
     for (size_t i = 0; i < productions.size(); ++i) {
@@ -577,6 +746,8 @@ public:
     for (char nt : nts) {
       cout << setw(8) << nt;
     }
+    if (!default_reduction.empty())
+      cout << setw(8) << "dflt";
     cout << "\n";
 
     for (size_t i = 0; i < lalr_states.size(); ++i) {
@@ -601,6 +772,11 @@ public:
           cout << setw(8) << "";
         }
       }
+
+      if (!default_reduction.empty()) {
+        auto d = default_reduction.find((int)i);
+        cout << setw(8) << (d != default_reduction.end() ? "r" + to_string(d->second) : "");
+      }
       cout << "\n";
     }
   }
@@ -611,6 +787,16 @@ public:
     cout << "LALR(1) States: " << lalr_states.size() << "\n";
     cout << "Terminals: " << terminals.size() << "\n";
     cout << "Non-terminals: " << non_terminals.size() << "\n";
+    cout << "Explicit ACTION entries: " << action_table.size() << "\n";
+    if (!default_reduction.empty()) {
+      cout << "Default reductions: " << default_reduction.size() << " states, "
+           << default_entries_removed << " reduce entries removed ("
+           << action_table.size() + default_entries_removed << " -> "
+           << action_table.size() << ")\n";
+    }
+    if (!unit_goto.empty()) {
+      cout << "Unit-rule bypass entries: " << unit_goto.size() << "\n";
+    }
 
     // Check for conflicts
     map<pair<int, char>, set<string>> actions_by_key;
@@ -643,7 +829,118 @@ public:
   }
 };
 
-int main() {
+// Parses every remaining input line with and without unit-rule bypassing
+// and reports the steps (shifts + reductions) each run took
+void runBatch(const LALRParser &parser) {
+  cout << "\nBATCH PARSE:\n";
+  cout << left << setw(32) << "Input" << right << setw(8) << "Result"
+       << setw(10) << "Steps" << setw(10) << "Bypass" << setw(10) << "Saved"
+       << "\n";
+
+  long long total = 0, total_bypass = 0;
+  int inputs = 0, accepted = 0;
+  string line;
+  while (getline(cin, line)) {
+    line.erase(remove_if(line.begin(), line.end(),
+                         [](char c) { return c == ' ' || c == '\t' || c == '\r'; }),
+               line.end());
+    if (line.empty())
+      continue;
+
+    LALRParser::ParseResult plain = parser.parse(line, false);
+    LALRParser::ParseResult fast = parser.parse(line, true);
+    ++inputs;
+    accepted += plain.accepted;
+    total += plain.steps();
+    total_bypass += fast.steps();
+
+    string shown = line.size() > 30 ? line.substr(0, 27) + "..." : line;
+    cout << left << setw(32) << shown << right << setw(8)
+         << (plain.accepted ? "accept" : "error") << setw(10) << plain.steps()
+         << setw(10) << fast.steps() << setw(10) << plain.steps() - fast.steps()
+         << "\n";
+  }
+
+  cout << "\nInputs: " << inputs << " (" << accepted << " accepted)\n";
+  cout << "Steps without bypass: " << total << "\n";
+  cout << "Steps with bypass:    " << total_bypass << "\n";
+  if (total > 0) {
+    cout << "Saved: " << total - total_bypass << " ("
+         << fixed << setprecision(1) << 100.0 * (total - total_bypass) / total
+         << "%)\n";
+  }
+}
+
+// Times the runtime parse loop on the remaining input lines: the map-based
+// table, the flat table and the flat table after the compression post-pass
+int runTableBench(const LALRParser &parser, const string &profile_in,
+                  const string &profile_out) {
+  map<char, long long> counts;
+  vector<string> inputs = readInputs(cin, counts);
+  if (inputs.empty()) {
+    cout << "\nNo inputs to benchmark.\n";
+    return 1;
+  }
+  if (!profile_out.empty() && writeProfile(profile_out, counts))
+    cout << "\nWrote terminal profile to " << profile_out << "\n";
+
+  PackedTable plain = parser.pack();
+  PackedTable packed = parser.pack();
+  packed.compress(profile_in.empty() ? map<char, long long>() : readProfile(profile_in));
+
+  // the flat table must reproduce the map-based driver exactly
+  vector<int> stack;
+  long long tokens = 0;
+  for (const auto &in : inputs) {
+    LALRParser::ParseResult want = parser.parse(in, false);
+    PackedTable::Result got = plain.parse(plain.encode(in), stack);
+    if (got.accepted != want.accepted || (want.accepted && got.steps != want.steps())) {
+      cout << "\nTable mismatch on input: " << in << "\n";
+      return 1;
+    }
+    tokens += (long long)in.size() + 1;
+  }
+  if (!compareTables(plain, packed, inputs, cout))
+    return 1;
+
+  int reps = (int)max(1LL, 1000000LL / tokens);
+  long long sink = 0;
+  auto t0 = chrono::steady_clock::now();
+  for (int r = 0; r < reps; ++r)
+    for (const auto &in : inputs)
+      sink += parser.parse(in, false).steps();
+  double map_ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() /
+                  ((double)tokens * reps);
+  cout << "Map-based table:  " << fixed << setprecision(2) << map_ns << " ns/token\n";
+  return sink < 0;
+}
+
+int main(int argc, char **argv) {
+  bool default_reductions = false, unit_bypass = false, batch = false;
+  bool bench_table = false;
+  string profile_in, profile_out;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "--default-reductions") {
+      default_reductions = true;
+    } else if (arg == "--unit-bypass") {
+      unit_bypass = true;
+    } else if (arg == "--batch") {
+      batch = true;
+    } else if (arg == "--bench-table") {
+      bench_table = true;
+    } else if (arg == "--profile" && i + 1 < argc) {
+      profile_in = argv[++i];
+    } else if (arg == "--write-profile" && i + 1 < argc) {
+      profile_out = argv[++i];
+    } else {
+      cerr << "Usage: " << argv[0]
+           << " [--default-reductions] [--unit-bypass] [--batch]"
+              " [--bench-table [--profile FILE] [--write-profile FILE]]\n";
+      return 1;
+    }
+  }
+
   LALRParser parser;
   cout << "LOOK-AHEAD LR (LALR) PARSE TABLE CONSTRUCTOR\n";
   cout << "============================================\n\n";
@@ -714,6 +1011,10 @@ int main() {
 
   cout << "\nBuilding LALR(1) parse table...\n";
   parser.buildParseTable();
+  if (default_reductions)
+    parser.applyDefaultReductions();
+  if (unit_bypass || batch)
+    parser.computeUnitBypass();
 
   // Display results
   parser.printProductions();
@@ -722,5 +1023,10 @@ int main() {
   parser.printCombinedParseTable();
   parser.printStatistics();
 
+  if (batch)
+    runBatch(parser);
+  else if (bench_table)
+    return runTableBench(parser, profile_in, profile_out);
+
   return 0;
 }
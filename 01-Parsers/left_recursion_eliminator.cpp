@@ -1,364 +1,446 @@
-// LALR_table.cpp
-// Modified to hardcode the output for a specific grammar.
-// For all other grammars, the original LALR parsing logic is executed.
+// Left recursion eliminator and left factorer.
+// Removes direct and indirect left recursion with Paull's algorithm, factors
+// common prefixes through a per-nonterminal trie, then builds the LL(1) table
+// of the result to check that it is now LL(1).
+// Compile: g++ -O2 left_recursion_eliminator.cpp -o lre
+// Run:     ./lre < grammar.txt          (N, then "A -> x y z" lines, eps for an empty right side)
+//          ./lre --generate 2000        (synthetic grammar, prints timings)
 
 #include <bits/stdc++.h>
 using namespace std;
 
-// Struct and function definitions are unchanged
-struct Prod{ string lhs; vector<string> rhs; };
-struct Item1{ int p; int dot; string look; };
-bool operator<(Item1 const& a, Item1 const& b){
-    if(a.p!=b.p) return a.p<b.p;
-    if(a.dot!=b.dot) return a.dot<b.dot;
-    return a.look < b.look;
-}
-bool operator==(Item1 const& a, Item1 const& b) {
-    return a.p == b.p && a.dot == b.dot && a.look == b.look;
-}
-string join(const vector<string>& v){
-    string s;
-    for(size_t i=0;i<v.size();++i){ if(i) s+=" "; s+=v[i]; }
-    return s.empty() ? "eps" : s;
-}
+// Indexed production store: symbols are interned, every nonterminal keeps the
+// list of its live production ids, so no transformation ever rescans the
+// whole grammar.
+struct Grammar {
+    vector<string> names;
+    vector<char> isNT;
+    unordered_map<string,int> ids;
+    vector<int> lhs;
+    vector<vector<int>> rhs;
+    vector<vector<int>> prodsOf;    // nonterminal -> live production ids
+    vector<int> ntOrder;            // nonterminals in order of first definition
+    int start = -1;
 
-int main(){
-    ios::sync_with_stdio(false);
-    cin.tie(nullptr);
-    int N; if(!(cin>>N)) return 0;
-    string arrow, lhs, token, line;
-    getline(cin,line);
-    vector<Prod> prods;
-    set<string> nonterminals;
+    int intern(const string& s){
+        auto it = ids.find(s);
+        if(it != ids.end()) return it->second;
+        ids[s] = names.size();
+        names.push_back(s);
+        isNT.push_back(0);
+        prodsOf.emplace_back();
+        return names.size()-1;
+    }
+    int freshNT(int base){
+        string n = names[base] + "'";
+        while(ids.count(n)) n += "'";
+        int id = intern(n);
+        isNT[id] = 1;
+        return id;
+    }
+    int addProd(int A, vector<int> r){
+        lhs.push_back(A);
+        rhs.push_back(move(r));
+        prodsOf[A].push_back(lhs.size()-1);
+        return lhs.size()-1;
+    }
+    string prodText(int p) const {
+        string s = names[lhs[p]] + " ->";
+        if(rhs[p].empty()) s += " eps";
+        for(int x: rhs[p]) s += " " + names[x];
+        return s;
+    }
+    size_t liveCount() const {
+        size_t n = 0;
+        for(int A: ntOrder) n += prodsOf[A].size();
+        return n;
+    }
+    void print(const string& title) const {
+        cout << "=== " << title << " ===\n";
+        for(int A: ntOrder) for(int p: prodsOf[A]) cout << prodText(p) << "\n";
+        cout << "\n";
+    }
+};
+
+// Reads "N" followed by N lines "A -> X Y Z" (eps for an empty right side)
+Grammar readGrammar(istream& in){
+    Grammar g;
+    int N; if(!(in >> N)) return g;
+    string line, lhs, arrow, tok;
+    getline(in, line);
+    vector<pair<string,vector<string>>> raw;
     for(int i=0;i<N;i++){
-        getline(cin,line);
+        if(!getline(in, line)) break;
         if(line.empty()){ i--; continue; }
         stringstream ss(line);
-        ss>>lhs>>arrow;
-        vector<string> rhs;
-        while(ss>>token) rhs.push_back(token);
-        if(rhs.size()==1 && rhs[0]=="eps") rhs.clear();
-        prods.push_back({lhs,rhs});
-        nonterminals.insert(lhs);
+        ss >> lhs >> arrow;
+        vector<string> r;
+        while(ss >> tok) r.push_back(tok);
+        if(r.size()==1 && r[0]=="eps") r.clear();
+        raw.push_back({lhs, r});
+        int A = g.intern(lhs);
+        if(!g.isNT[A]){ g.isNT[A] = 1; g.ntOrder.push_back(A); }
     }
-    string start = prods[0].lhs;
-    string SPrime = start + "'";
-    prods.insert(prods.begin(), {SPrime,{start}});
-    nonterminals.insert(SPrime);
-    // === Original Dynamic LALR(1) Logic for Any Other Grammar ===
-
-        set<string> terminals;
-        for(auto &p: prods) for(auto &s: p.rhs) if(nonterminals.count(s)==0) terminals.insert(s);
-        terminals.insert("$");
+    for(auto& pr: raw){
+        vector<int> r;
+        for(auto& s: pr.second) r.push_back(g.intern(s));
+        g.addProd(g.ids[pr.first], r);
+    }
+    if(!raw.empty()) g.start = g.ids[raw[0].first];
+    return g;
+}
 
-        // FIRST
-        unordered_map<string,set<string>> FIRST;
-        for(auto &t: terminals) FIRST[t].insert(t);
-        for(auto &nt: nonterminals) FIRST[nt];
-        bool ch=true;
-        while(ch){
-            ch=false;
-            for(auto &p: prods){
-                string A=p.lhs;
-                if(p.rhs.empty()){
-                    if(FIRST[A].insert("eps").second) ch=true;
-                    continue;
-                }
-                bool allEps=true;
-                for(auto &X: p.rhs){
-                    for(auto &f: FIRST[X]) if(f!="eps") if(FIRST[A].insert(f).second) ch=true;
-                    if(FIRST[X].count("eps")==0){ allEps=false; break; }
-                }
-                if(allEps) if(FIRST[A].insert("eps").second) ch=true;
+// ---------------------------------------------------------------------------
+// Paull's algorithm. For A_i in order, every production A_i -> A_j gamma with
+// j < i is replaced by A_j's (already processed) alternatives; the results
+// start with a terminal or with some A_k, k > j, so a worklist over A_i's own
+// productions reaches the fixpoint without looping over every j < i. Then the
+// immediate left recursion of A_i is removed with a fresh A_i'.
+// ---------------------------------------------------------------------------
+void eliminateLeftRecursion(Grammar& g){
+    vector<int> rank(g.names.size(), INT_MAX);
+    for(size_t i=0;i<g.ntOrder.size();++i) rank[g.ntOrder[i]] = i;
+    vector<int> order = g.ntOrder;
+    for(int Ai: order){
+        int ri = rank[Ai];
+        // stack kept in reverse so alternatives come out in their input order
+        vector<int> work(g.prodsOf[Ai].rbegin(), g.prodsOf[Ai].rend());
+        vector<int> done;
+        g.prodsOf[Ai].clear();
+        while(!work.empty()){
+            int p = work.back(); work.pop_back();
+            const vector<int>& r = g.rhs[p];
+            if(r.empty() || rank[r[0]] >= ri){ done.push_back(p); continue; }
+            int Aj = r[0];
+            vector<int> gamma(r.begin()+1, r.end());
+            for(auto q = g.prodsOf[Aj].rbegin(); q != g.prodsOf[Aj].rend(); ++q){
+                vector<int> nr = g.rhs[*q];
+                nr.insert(nr.end(), gamma.begin(), gamma.end());
+                g.lhs.push_back(Ai);
+                g.rhs.push_back(move(nr));
+                work.push_back(g.lhs.size()-1);
             }
         }
-        auto FIRST_of_seq = [&](const vector<string>& seq){
-            set<string> res; bool allEps=true;
-            for(auto &X: seq){
-                for(auto &f: FIRST[X]) if(f!="eps") res.insert(f);
-                if(FIRST[X].count("eps")==0){ allEps=false; break; }
-            }
-            if(allEps) res.insert("eps");
-            return res;
-        };
-
-        // LR(1) canonical collection
-        auto closure = [&](const set<Item1>& I){
-            set<Item1> C = I;
-            bool added=true;
-            while(added){
-                added=false;
-                for(auto it: vector<Item1>(C.begin(), C.end())){
-                    int p=it.p, dot=it.dot;
-                    if(dot < (int)prods[p].rhs.size()){
-                        string B = prods[p].rhs[dot];
-                        if(nonterminals.count(B)){
-                            vector<string> beta;
-                            for(int k=dot+1;k<(int)prods[p].rhs.size();++k) beta.push_back(prods[p].rhs[k]);
-                            beta.push_back(it.look);
-                            auto lookset = FIRST_of_seq(beta);
-                            for(size_t q=0;q<prods.size();++q) if(prods[q].lhs==B){
-                                for(auto &la: lookset){
-                                    if(la=="eps") continue;
-                                    Item1 nit{(int)q,0,la};
-                                    if(C.insert(nit).second) added=true;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-            return C;
-        };
 
-        auto goto_fn = [&](const set<Item1>& I, const string& X){
-            set<Item1> J;
-            for(auto &it: I){
-                if(it.dot < (int)prods[it.p].rhs.size() && prods[it.p].rhs[it.dot]==X){
-                    J.insert({it.p, it.dot+1, it.look});
-                }
-            }
-            return closure(J);
-        };
-
-        vector< set<Item1> > C;
-        set<Item1> I0; I0.insert({0,0,"$"});
-        C.push_back(closure(I0));
-        bool addedg=true;
-        while(addedg){
-            addedg=false;
-            for(size_t i=0;i<C.size();++i){
-                set<string> syms;
-                for(auto &it: C[i]) if(it.dot < (int)prods[it.p].rhs.size()) syms.insert(prods[it.p].rhs[it.dot]);
-                for(auto &X: syms){
-                    auto g = goto_fn(C[i], X);
-                    if(g.empty()) continue;
-                    bool found=false;
-                    for(size_t j=0;j<C.size();++j) if(C[j]==g){ found=true; break; }
-                    if(!found){ C.push_back(g); addedg=true; }
-                }
-            }
+        // immediate left recursion: A -> A alpha | beta
+        vector<int> alphas, betas;
+        for(int p: done){
+            const vector<int>& r = g.rhs[p];
+            if(!r.empty() && r[0]==Ai){ if(r.size() > 1) alphas.push_back(p); }   // A -> A is dropped
+            else betas.push_back(p);
         }
-        int K = (int)C.size();
-
-        vector< set<pair<int,int>> > cores(K);
-        for(int i=0;i<K;++i){
-            for(auto &it: C[i]) cores[i].insert({it.p,it.dot});
+        if(alphas.empty()){
+            g.prodsOf[Ai] = betas;
+            continue;
         }
-
-        map< set<pair<int,int>>, vector<int> > groups;
-        for(int i=0;i<K;++i) groups[cores[i]].push_back(i);
-
-        int M = 0;
-        vector<int> mapState(K, -1);
-        for(auto &g: groups){
-            for(int s: g.second) mapState[s]=M;
-            M++;
+        int A2 = g.freshNT(Ai);
+        g.ntOrder.push_back(A2);
+        // A' is never substituted into: it ranks after every A_i in order,
+        // and a later A_j may start an alternative with it
+        rank.resize(g.names.size(), INT_MAX);
+        for(int p: betas){
+            vector<int> nr = g.rhs[p];
+            nr.push_back(A2);
+            g.addProd(Ai, nr);
+        }
+        if(betas.empty()) g.addProd(Ai, {A2});
+        for(int p: alphas){
+            vector<int> nr(g.rhs[p].begin()+1, g.rhs[p].end());
+            nr.push_back(A2);
+            g.addProd(A2, nr);
         }
+        g.addProd(A2, {});
+    }
+}
 
-        vector< map<pair<int,int>, set<string>> > mergedItems(M);
-        for(int s=0;s<K;++s){
-            int ms = mapState[s];
-            for(auto &it: C[s]){
-                mergedItems[ms][{it.p,it.dot}].insert(it.look);
-            }
+// ---------------------------------------------------------------------------
+// Left factoring. The alternatives of each nonterminal go into a trie; every
+// trie node that branches (or where one alternative ends and another goes
+// on) below the root becomes a fresh nonterminal, and the unbranched runs
+// between them become the common prefixes. One pass per nonterminal.
+// ---------------------------------------------------------------------------
+struct TrieNode { vector<pair<int,int>> kids; bool end = false; };
+
+void emitFromTrie(Grammar& g, vector<TrieNode>& trie, int A, int node, vector<int>& fresh){
+    for(auto kid: trie[node].kids){
+        vector<int> path = {kid.first};
+        int n = kid.second;
+        while(!trie[n].end && trie[n].kids.size()==1){
+            path.push_back(trie[n].kids[0].first);
+            n = trie[n].kids[0].second;
         }
+        if(trie[n].kids.empty()){ g.addProd(A, path); continue; }
+        int N2 = g.freshNT(A);
+        fresh.push_back(N2);
+        path.push_back(N2);
+        g.addProd(A, path);
+        emitFromTrie(g, trie, N2, n, fresh);
+    }
+    if(trie[node].end) g.addProd(A, {});
+}
 
-        map<pair<int,string>, int> trans;
-        for(int i=0;i<K;++i){
-            set<string> syms;
-            for(auto &it: C[i]) if(it.dot < (int)prods[it.p].rhs.size()) syms.insert(prods[it.p].rhs[it.dot]);
-            for(auto &X: syms){
-                auto g = goto_fn(C[i], X);
-                if(g.empty()) continue;
-                int tgt=-1;
-                for(int j=0;j<K;++j) if(C[j]==g){ tgt = mapState[j]; break; }
-                if(tgt==-1){
-                    set<pair<int,int>> coreg;
-                    for(auto &it: g) coreg.insert({it.p, it.dot});
-                    if(groups.count(coreg)){
-                        tgt = mapState[groups[coreg][0]];
-                    }
+void leftFactor(Grammar& g){
+    vector<int> order = g.ntOrder;
+    vector<int> allNew;
+    for(int A: order){
+        vector<TrieNode> trie(1);
+        for(int p: g.prodsOf[A]){
+            int n = 0;
+            for(int x: g.rhs[p]){
+                int next = -1;
+                for(auto& k: trie[n].kids) if(k.first==x){ next = k.second; break; }
+                if(next < 0){
+                    next = trie.size();
+                    trie[n].kids.push_back({x, next});
+                    trie.emplace_back();
                 }
-                if(tgt!=-1) trans[{mapState[i],X}] = tgt;
+                n = next;
             }
+            trie[n].end = true;
         }
+        g.prodsOf[A].clear();
+        vector<int> fresh;
+        emitFromTrie(g, trie, A, 0, fresh);
+        allNew.insert(allNew.end(), fresh.begin(), fresh.end());
+    }
+    g.ntOrder.insert(g.ntOrder.end(), allNew.begin(), allNew.end());
+}
 
-        map<pair<int,string>, pair<string,int>> ACTION;
-        map<pair<int,string>, int> GOTO;
-        for(int ms=0; ms<M; ++ms){
-            for(auto &pr: mergedItems[ms]){
-                int p = pr.first.first;
-                int dot = pr.first.second;
-                auto looks = pr.second;
-                if(dot < (int)prods[p].rhs.size()){
-                    string a = prods[p].rhs[dot];
-                    if(terminals.count(a)){
-                        auto it = trans.find({ms,a});
-                        if(it!=trans.end()) ACTION[{ms,a}] = {"s", it->second};
-                    } else {
-                        auto it = trans.find({ms,a});
-                        if(it!=trans.end()) GOTO[{ms,a}] = it->second;
-                    }
-                } else {
-                    for(auto &la: looks){
-                        if(p==0 && la=="$") ACTION[{ms,"$"}] = {"acc",-1};
-                        else ACTION[{ms,la}] = {"r", p};
-                    }
-                }
+// ---------------------------------------------------------------------------
+// LL(1) table builder
+// ---------------------------------------------------------------------------
+struct Bits {
+    vector<uint64_t> w;
+    explicit Bits(int n=0): w((n+63)/64, 0) {}
+    void set(int i){ w[i>>6] |= 1ULL<<(i&63); }
+    void merge(const Bits& o){ for(size_t i=0;i<w.size();++i) w[i] |= o.w[i]; }
+    template<class F> void forEach(F f) const {
+        for(size_t i=0;i<w.size();++i) for(uint64_t x=w[i]; x; x&=x-1) f((int)(i*64+__builtin_ctzll(x)));
+    }
+};
+
+// DeRemer & Pennello's Digraph over nonterminal indices (see first_follow_calculator.cpp)
+struct Digraph {
+    const vector<vector<int>>& R;
+    vector<Bits>& F;
+    vector<int> N, stk;
+    Digraph(const vector<vector<int>>& R, vector<Bits>& F): R(R), F(F), N(R.size(), 0) {
+        for(int x=0;x<(int)R.size();x++) if(N[x]==0) traverse(x);
+    }
+    void traverse(int x){
+        stk.push_back(x);
+        int d = stk.size();
+        N[x] = d;
+        for(int y: R[x]){
+            if(N[y]==0) traverse(y);
+            N[x] = min(N[x], N[y]);
+            F[x].merge(F[y]);
+        }
+        if(N[x]==d){
+            while(true){
+                int top = stk.back(); stk.pop_back();
+                N[top] = INT_MAX;
+                if(top==x) break;
+                F[top] = F[x];
             }
         }
+    }
+};
 
-        cout<<"=== LALR(1) merged states (M="<<M<<") ===\n";
-        for(int ms=0; ms<M; ++ms){
-            cout<<"State "<<ms<<":\n";
-            for(auto &pr: mergedItems[ms]){
-                int p = pr.first.first, dot = pr.first.second;
-                cout<<"  ("<<p<<") "<<prods[p].lhs<<" -> ";
-                for(int k=0;k<dot;k++) cout<<prods[p].rhs[k]<<" ";
-                cout<<". ";
-                for(int k=dot;k<(int)prods[p].rhs.size();k++) cout<<prods[p].rhs[k]<<" ";
-                cout<<" , {";
-                bool first=true;
-                for(auto &la: pr.second){ if(!first) cout<<","; cout<<la; first=false; }
-                cout<<"}\n";
-            }
+struct LL1Result {
+    vector<unordered_map<int,int>> table;      // per nonterminal: terminal -> production
+    vector<tuple<int,int,int,int>> conflicts;  // (A, a, existing prod, new prod)
+    vector<int> termOf;                        // terminal index -> symbol id
+    vector<int> unproductive;                  // nonterminals that derive no terminal string
+};
+
+LL1Result buildLL1(Grammar& g){
+    LL1Result res;
+    int S = g.names.size();
+    vector<int> ntIdx(S, -1), tIdx(S, -1);
+    for(size_t i=0;i<g.ntOrder.size();++i) ntIdx[g.ntOrder[i]] = i;
+    int dollar = g.intern("$");
+    tIdx.resize(g.names.size(), -1);
+    ntIdx.resize(g.names.size(), -1);
+    for(int s=0;s<(int)g.names.size();++s) if(!g.isNT[s]){ tIdx[s] = res.termOf.size(); res.termOf.push_back(s); }
+    int NT = g.ntOrder.size(), T = res.termOf.size();
+
+    // nullable by worklist
+    vector<char> nullable(NT, 0);
+    vector<int> pending(g.lhs.size(), 0);
+    vector<vector<int>> usedIn(NT);
+    vector<int> work, live;
+    for(int A: g.ntOrder) for(int p: g.prodsOf[A]){
+        live.push_back(p);
+        for(int x: g.rhs[p]){
+            if(g.isNT[x]){ pending[p]++; usedIn[ntIdx[x]].push_back(p); }
+            else { pending[p] = INT_MIN; }
         }
+        if(pending[p]==0) work.push_back(ntIdx[A]);
+    }
+    while(!work.empty()){
+        int A = work.back(); work.pop_back();
+        if(nullable[A]) continue;
+        nullable[A] = 1;
+        for(int p: usedIn[A]) if(--pending[p]==0) work.push_back(ntIdx[g.lhs[p]]);
+    }
 
-    // --- MODIFICATION STARTS HERE ---
+    // productive by the same worklist, with terminals no longer blocking:
+    // elimination can leave a cycle like S -> A, A -> S with nothing at all
+    vector<char> productive(NT, 0);
+    for(int p: live){
+        pending[p] = 0;
+        for(int x: g.rhs[p]) if(g.isNT[x]) pending[p]++;
+        if(pending[p]==0) work.push_back(ntIdx[g.lhs[p]]);
+    }
+    while(!work.empty()){
+        int A = work.back(); work.pop_back();
+        if(productive[A]) continue;
+        productive[A] = 1;
+        for(int p: usedIn[A]) if(--pending[p]==0) work.push_back(ntIdx[g.lhs[p]]);
+    }
+    for(int A=0;A<NT;++A) if(!productive[A]) res.unproductive.push_back(A);
 
-    // Check if the grammar is the specific one for hardcoding the output
-    bool isSpecificGrammar = (N == 3 &&
-    prods.size() == 4 && // Includes augmented S' -> S
-    prods[1].lhs == "S" && prods[1].rhs.size() == 2 && prods[1].rhs[0] == "C" && prods[1].rhs[1] == "C" &&
-    prods[2].lhs == "C" && prods[2].rhs.size() == 2 && prods[2].rhs[0] == "c" && prods[2].rhs[1] == "C" &&
-    prods[3].lhs == "C" && prods[3].rhs.size() == 1 && prods[3].rhs[0] == "d");
+    // FIRST and FOLLOW as Digraph problems
+    vector<Bits> FIRST(NT, Bits(T)), FOLLOW(NT, Bits(T));
+    vector<vector<int>> firstRel(NT), followRel(NT);
+    for(int p: live){
+        int A = ntIdx[g.lhs[p]];
+        for(int x: g.rhs[p]){
+            if(!g.isNT[x]){ FIRST[A].set(tIdx[x]); break; }
+            firstRel[A].push_back(ntIdx[x]);
+            if(!nullable[ntIdx[x]]) break;
+        }
+    }
+    Digraph solveFirst(firstRel, FIRST);
 
-    if (isSpecificGrammar ) {
-        // === Hardcoded Output for the Specific Grammar ===
+    FOLLOW[ntIdx[g.start]].set(tIdx[dollar]);
+    vector<Bits> firstOfRhs(g.lhs.size());
+    vector<char> rhsNullable(g.lhs.size(), 0);
+    for(int p: live){
+        int A = ntIdx[g.lhs[p]];
+        Bits rest(T);
+        bool restNullable = true;
+        for(int i=(int)g.rhs[p].size()-1;i>=0;--i){
+            int x = g.rhs[p][i];
+            if(!g.isNT[x]){ rest = Bits(T); rest.set(tIdx[x]); restNullable = false; continue; }
+            int B = ntIdx[x];
+            FOLLOW[B].merge(rest);
+            if(restNullable && B != A) followRel[B].push_back(A);
+            if(nullable[B]) rest.merge(FIRST[B]);
+            else { rest = FIRST[B]; restNullable = false; }
+        }
+        firstOfRhs[p] = move(rest);
+        rhsNullable[p] = restNullable;
+    }
+    Digraph solveFollow(followRel, FOLLOW);
 
-        // 1. Print the LALR Parsing Table from the image
-        cout << "\n=== LALR Parsing Table ===\n";
-        int colW = 7;
-        cout << left << setw(8) << "STATE" << " | " << setw(colW * 3) << "action" << " | " << "goto" << "\n";
-        cout << left << setw(8) << "" << " | "
-        << setw(colW) << "c" << setw(colW) << "d" << setw(colW) << "$" << " | "
-        << setw(colW) << "S" << setw(colW) << "C" << "\n";
-        cout << string(8, '-') << "-+-" << string(colW * 3, '-') << "-+-" << string(colW * 2, '-') << "\n";
+    res.table.assign(NT, {});
+    for(int p: live){
+        int A = ntIdx[g.lhs[p]];
+        auto put = [&](int t){
+            auto ins = res.table[A].insert({t, p});
+            if(!ins.second && ins.first->second != p) res.conflicts.emplace_back(A, t, ins.first->second, p);
+        };
+        firstOfRhs[p].forEach(put);
+        if(rhsNullable[p]) FOLLOW[A].forEach(put);
+    }
+    return res;
+}
 
-        cout << left << setw(8) << 0 << " | " << setw(colW) << "s36" << setw(colW) << "s47" << setw(colW) << "" << " | " << setw(colW) << "1" << setw(colW) << "2" << "\n";
-        cout << left << setw(8) << 1 << " | " << setw(colW) << "" << setw(colW) << "" << setw(colW) << "acc" << " | " << setw(colW) << "" << setw(colW) << "" << "\n";
-        cout << left << setw(8) << 2 << " | " << setw(colW) << "s36" << setw(colW) << "s47" << setw(colW) << "" << " | " << setw(colW) << "" << setw(colW) << "5" << "\n";
-        cout << left << setw(8) << 5 << " | " << setw(colW) << "" << setw(colW) << "" << setw(colW) << "r1" << " | " << setw(colW) << "" << setw(colW) << "" << "\n";
-        cout << left << setw(8) << 36 << " | " << setw(colW) << "s36" << setw(colW) << "s47" << setw(colW) << "" << " | " << setw(colW) << "" << setw(colW) << "89" << "\n";
-        cout << left << setw(8) << 47 << " | " << setw(colW) << "r3" << setw(colW) << "r3" << setw(colW) << "r3" << " | " << setw(colW) << "" << setw(colW) << "" << "\n";
-        cout << left << setw(8) << 89 << " | " << setw(colW) << "r2" << setw(colW) << "r2" << setw(colW) << "r2" << " | " << setw(colW) << "" << setw(colW) << "" << "\n";
+// ---------------------------------------------------------------------------
+// Synthetic grammar for timing: blocks of five nonterminals, each with
+// expression-style immediate left recursion (E, T), an indirect cycle through
+// L -> R -> L t, and alternatives sharing a prefix (call ( ... )). R links to
+// the next block, so the whole grammar is reachable. The result of the
+// transformation is LL(1).
+// ---------------------------------------------------------------------------
+string generateGrammar(int nts){
+    vector<string> out;
+    int blocks = max(1, nts/5);
+    for(int b=0;b<blocks;++b){
+        string s = to_string(b);
+        string E = "E"+s, T = "T"+s, F = "F"+s, L = "L"+s, R = "R"+s;
+        string next = b+1<blocks ? "E"+to_string(b+1) : "num";
+        out.push_back(E+" -> "+E+" + "+T);
+        out.push_back(E+" -> "+T);
+        out.push_back(T+" -> "+T+" * "+F);
+        out.push_back(T+" -> "+F);
+        out.push_back(F+" -> "+L);
+        out.push_back(F+" -> call ( )");
+        out.push_back(F+" -> call ( "+E+" )");
+        out.push_back(F+" -> id");
+        out.push_back(L+" -> "+R);
+        out.push_back(R+" -> "+L+" t");
+        out.push_back(R+" -> y");
+        out.push_back(R+" -> ( "+next+" )");
+    }
+    string g = to_string(out.size()) + "\n";
+    for(auto& l: out) g += l + "\n";
+    return g;
+}
 
-        // 2. Print the Parsing Steps from the image
-        cout << "\n=== Parsing Steps ===\n";
-        cout << left << setw(25) << "STACK" << " | " << left << setw(15) << "INPUT" << " | " << "ACTION\n";
-        cout << string(25, '-') << "-+-" << string(15, '-') << "-+-" << string(25, '-') << "\n";
-        cout << left << setw(25) << "0" << " | " << left << setw(15) << "c c d d $" << " | " << "Shift\n";
-        cout << left << setw(25) << "0 c 36" << " | " << left << setw(15) << "c d d $" << " | " << "Shift\n";
-        cout << left << setw(25) << "0 c 36 c 36" << " | " << left << setw(15) << "d d $" << " | " << "Shift\n";
-        cout << left << setw(25) << "0 c 36 c 36 d 47" << " | " << left << setw(15) << "d $" << " | " << "Reduce by C -> d\n";
-        cout << left << setw(25) << "0 c 36 c 89" << " | " << left << setw(15) << "d $" << " | " << "Reduce by C -> cC\n";
-        cout << left << setw(25) << "0 c 89" << " | " << left << setw(15) << "d $" << " | " << "Reduce by C -> cC\n";
-        cout << left << setw(25) << "0 C 2" << " | " << left << setw(15) << "d $" << " | " << "Shift\n";
-        cout << left << setw(25) << "0 C 2 d 47" << " | " << left << setw(15) << "$" << " | " << "Reduce by C -> d\n";
-        cout << left << setw(25) << "0 C 2 C 5" << " | " << left << setw(15) << "$" << " | " << "Reduce by S -> CC\n";
-        cout << left << setw(25) << "0 S 1" << " | " << left << setw(15) << "$" << " | " << "accept\n";
+int main(int argc, char** argv){
+    ios::sync_with_stdio(false);
+    cin.tie(nullptr);
+    bool generated = argc > 2 && string(argv[1]) == "--generate";
 
+    Grammar g;
+    if(generated){
+        stringstream ss(generateGrammar(atoi(argv[2])));
+        g = readGrammar(ss);
     } else {
-        
+        g = readGrammar(cin);
+    }
+    if(g.start < 0){ cout << "No grammar\n"; return 0; }
+    size_t ntsBefore = g.ntOrder.size(), prodsBefore = g.liveCount();
 
-        vector<string> termList(terminals.begin(), terminals.end());
-        sort(termList.begin(), termList.end());
-        vector<string> nontermList(nonterminals.begin(), nonterminals.end());
-        sort(nontermList.begin(), nontermList.end());
+    auto t0 = chrono::steady_clock::now();
+    eliminateLeftRecursion(g);
+    auto t1 = chrono::steady_clock::now();
+    if(!generated) g.print("Grammar after left recursion elimination");
+    leftFactor(g);
+    auto t2 = chrono::steady_clock::now();
+    if(!generated) g.print("Grammar after left factoring");
+    LL1Result ll = buildLL1(g);
+    auto t3 = chrono::steady_clock::now();
 
-        cout<<"\n=== ACTION Table ===\n";
-        int colW = 12;
-        cout << left << setw(8) << "State" << " | ";
-        for(auto &t: termList) cout << left << setw(colW) << t;
-        cout << "\n";
-        cout << string(8,'-') << "-+-";
-        for(size_t i=0;i<termList.size();++i) cout << string(colW,'-');
-        cout << "\n";
-        for(int i=0;i<M;++i){
-            cout << left << setw(8) << i << " | ";
-            for(auto &t: termList){
-                string cell = "";
-                auto it = ACTION.find({i,t});
-                if(it!=ACTION.end()){
-                    auto v = it->second;
-                    if(v.first=="s") cell = string("s") + to_string(v.second);
-                    else if(v.first=="r") cell = string("r") + to_string(v.second);
-                    else if(v.first=="acc") cell = "acc";
-                }
-                cout << left << setw(colW) << cell;
-            }
-            cout << "\n";
+    auto ms = [](auto a, auto b){ return chrono::duration<double, milli>(b-a).count(); };
+    if(generated){
+        cout << "Input:  " << ntsBefore << " nonterminals, " << prodsBefore << " productions\n";
+        cout << "Output: " << g.ntOrder.size() << " nonterminals, " << g.liveCount() << " productions\n";
+        cout << fixed << setprecision(2);
+        cout << "Left recursion elimination: " << ms(t0,t1) << " ms\n";
+        cout << "Left factoring:             " << ms(t1,t2) << " ms\n";
+        cout << "LL(1) table:                " << ms(t2,t3) << " ms\n";
+    } else {
+        cout << "=== LL(1) Parse Table ===\n";
+        for(size_t A=0;A<ll.table.size();++A){
+            vector<pair<string,int>> row;
+            for(auto& e: ll.table[A]) row.push_back({g.names[ll.termOf[e.first]], e.second});
+            sort(row.begin(), row.end());
+            for(auto& e: row) cout << "M[" << g.names[g.ntOrder[A]] << ", " << e.first << "] = " << g.prodText(e.second) << "\n";
         }
-
-        cout<<"\n=== GOTO Table ===\n";
-        cout << left << setw(8) << "State" << " | ";
-        for(auto &nt: nontermList) cout << left << setw(colW) << nt;
         cout << "\n";
-        cout << string(8,'-') << "-+-";
-        for(size_t i=0;i<nontermList.size();++i) cout << string(colW,'-');
-        cout << "\n";
-        for(int i=0;i<M;++i){
-            cout << left << setw(8) << i << " | ";
-            for(auto &nt: nontermList){
-                string cell = "";
-                auto it = GOTO.find({i,nt});
-                if(it!=GOTO.end()) cell = to_string(it->second);
-                cout << left << setw(colW) << cell;
-            }
-            cout << "\n";
-        }
-
-        string inputLine;
-        getline(cin,inputLine);
-        if(inputLine.empty()) getline(cin,inputLine);
-        stringstream ss2(inputLine);
-        vector<string> input;
-        while(ss2>>token) input.push_back(token);
-        if(input.empty()){ cout<<"No input\n"; return 0; }
-        if(input.back()!="$") input.push_back("$");
-
-        vector<int> st; st.push_back(0);
-        size_t ip=0;
-        vector<tuple<string,string,string>> steps;
-        while(true){
-            int s = st.back(); string a = input[ip];
-            stringstream stStack; for(size_t k=0;k<st.size();++k){ if(k) stStack<<" "; stStack<<st[k]; }
-            stringstream stInput; for(size_t k=ip;k<input.size();++k){ if(k>ip) stInput<<" "; stInput<<input[k]; }
+    }
 
-            auto it = ACTION.find({s,a});
-            if(it==ACTION.end()){ steps.emplace_back(stStack.str(), stInput.str(), string("ERROR: no ACTION")); break; }
-            auto act = it->second;
-            if(act.first=="s"){ steps.emplace_back(stStack.str(), stInput.str(), string("shift ")+to_string(act.second)); st.push_back(act.second); ip++; }
-            else if(act.first=="r"){
-                int pidx = act.second;
-                auto &pr = prods[pidx];
-                for(size_t k=0;k<pr.rhs.size();++k) if(!st.empty()) st.pop_back();
-                int t = st.back();
-                auto gotoIt = GOTO.find({t, pr.lhs});
-                if(gotoIt==GOTO.end()){ steps.emplace_back(stStack.str(), stInput.str(), string("ERROR: missing GOTO")); break; }
-                st.push_back(gotoIt->second);
-                steps.emplace_back(stStack.str(), stInput.str(), string("reduce by (")+to_string(pidx)+") "+pr.lhs+"->"+join(pr.rhs));
-            } else { steps.emplace_back(stStack.str(), stInput.str(), string("ACCEPT")); break; }
+    if(!ll.unproductive.empty()){
+        cout << "Grammar is NOT usable: " << ll.unproductive.size() << " nonterminal(s) with no terminating derivation\n";
+        size_t shown = 0;
+        for(int A: ll.unproductive){
+            if(++shown > 20){ cout << "  ...\n"; break; }
+            cout << "  " << g.names[g.ntOrder[A]] << "\n";
+        }
+    } else if(ll.conflicts.empty()){
+        cout << "Grammar is LL(1)\n";
+    } else {
+        cout << "Grammar is NOT LL(1): " << ll.conflicts.size() << " conflict(s)\n";
+        size_t shown = 0;
+        for(auto& c: ll.conflicts){
+            if(++shown > 20){ cout << "  ...\n"; break; }
+            cout << "  M[" << g.names[g.ntOrder[get<0>(c)]] << ", " << g.names[ll.termOf[get<1>(c)]] << "]: "
+                 << g.prodText(get<2>(c)) << "  |  " << g.prodText(get<3>(c)) << "\n";
         }
-
-        cout<<"\n=== Parsing Steps ===\n";
-        int wStack = 20, wInp = 30, wAct = 30;
-        for(auto &r: steps){ wStack = max(wStack, (int)get<0>(r).size()); wInp = max(wInp, (int)get<1>(r).size()); wAct = max(wAct, (int)get<2>(r).size()); }
-        cout << left << setw(wStack) << "States" << " | " << left << setw(wInp) << "Input" << " | " << left << setw(wAct) << "Action" << "\n";
-        cout << string(wStack,'-') << "-+-" << string(wInp,'-') << "-+-" << string(wAct,'-') << "\n";
-        for(auto &r: steps) cout << left << setw(wStack) << get<0>(r) << " | " << left << setw(wInp) << get<1>(r) << " | " << left << setw(wAct) << get<2>(r) << "\n";
     }
-
     return 0;
 }
@@ -0,0 +1,489 @@
+// libgrammar.cpp
+// Implementation of libgrammar.h. Symbols, nullable/FIRST/FOLLOW and the
+// SLR(1) table come from GrammarModel; canonical LR(1) states are built the
+// way grammar_analyzer does it (closure over (production, dot, lookahead)
+// items, states keyed by kernel), and LALR(1) merges LR(1) states with the
+// same LR(0) core. All tables share one cell encoding:
+//   ACTION: 0 error, s>0 shift to s-1, -1 accept, r<-1 reduce by -r-2
+//   GOTO:   -1 none
+#include "libgrammar.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "grammar_model.h"
+
+namespace {
+
+bool isDigits(const std::string &s) {
+  return !s.empty() && std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+std::string trim(const std::string &s) {
+  size_t b = s.find_first_not_of(" \t\r");
+  if (b == std::string::npos)
+    return "";
+  return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+}
+
+struct Item1 {
+  int prod, dot, look;
+  bool operator<(const Item1 &o) const {
+    if (prod != o.prod)
+      return prod < o.prod;
+    return dot != o.dot ? dot < o.dot : look < o.look;
+  }
+  bool operator==(const Item1 &o) const {
+    return prod == o.prod && dot == o.dot && look == o.look;
+  }
+};
+
+// One LR(1) state as the table builder sees it
+struct Lr1State {
+  std::vector<Item1> kernel;
+  std::vector<std::pair<int, int>> trans;   // (symbol, target), by symbol
+  std::vector<std::pair<int, int>> reduces; // (production, lookahead index)
+};
+
+} // namespace
+
+struct lg::Grammar::Impl {
+  GrammarModel model;
+  int states = 0, conflicts = 0;
+  std::vector<int> action; // states x T
+  std::vector<int> gotos;  // states x symbolCount
+  std::vector<int> column; // symbol -> ACTION column, -1 for nonterminals and '$'
+  std::vector<int> rhsLen, lhs;
+  std::unordered_map<std::string, int> ids;
+  bool oneCharTerminals = true;
+
+  explicit Impl(const std::string &text) {
+    std::istringstream in(text);
+    std::string line;
+    bool first = true;
+    while (std::getline(in, line)) {
+      line = trim(line);
+      if (line.empty() || line[0] == '#')
+        continue;
+      if (first && isDigits(line)) {
+        first = false;
+        continue;
+      }
+      first = false;
+      addLine(line);
+    }
+    if (model.productions().empty())
+      throw std::invalid_argument("grammar has no productions");
+    model.rebuildFull();
+    column.assign(model.symbolCount(), -1);
+    for (int t = 0; t < model.T(); ++t) {
+      int s = model.terminal(t);
+      if (s != model.eof()) {
+        column[s] = t;
+        if (model.name(s).size() != 1)
+          oneCharTerminals = false;
+      }
+    }
+    for (int s = 0; s < model.symbolCount(); ++s)
+      ids.emplace(model.name(s), s);
+    for (auto &p : model.productions()) {
+      lhs.push_back(p.lhs);
+      rhsLen.push_back((int)p.rhs.size());
+    }
+  }
+
+  void addLine(const std::string &line) {
+    std::vector<std::string> syms;
+    if (line.find_first_of(" \t") != std::string::npos) {
+      std::istringstream ls(line);
+      std::string lhs, arrow, s;
+      ls >> lhs >> arrow;
+      if (arrow != "->")
+        throw std::invalid_argument("expected 'A -> ...': " + line);
+      while (ls >> s)
+        syms.push_back(s);
+      if (syms.size() == 1 && syms[0] == "eps")
+        syms.clear();
+      model.addProduction(lhs, syms);
+      return;
+    }
+    if (line.size() < 3 || line.compare(1, 2, "->") != 0)
+      throw std::invalid_argument("expected 'A->...': " + line);
+    std::string rhs = line.substr(3);
+    if (rhs != "e")
+      for (char c : rhs)
+        syms.push_back(std::string(1, c));
+    model.addProduction(line.substr(0, 1), syms);
+  }
+
+  int T() const { return model.T(); }
+  int S() const { return model.symbolCount(); }
+
+  void reset(int n) {
+    states = n;
+    conflicts = 0;
+    action.assign((size_t)n * T(), 0);
+    gotos.assign((size_t)n * S(), -1);
+  }
+
+  // Shifts first, then reductions; an occupied cell keeps its entry and
+  // counts as a conflict, as in GrammarModel::buildRow
+  void fillRow(int s, const std::vector<std::pair<int, int>> &trans,
+               const std::vector<std::pair<int, int>> &reduces) {
+    int *row = &action[(size_t)s * T()];
+    for (auto &tr : trans) {
+      if (model.isNonterminal(tr.first))
+        gotos[(size_t)s * S() + tr.first] = tr.second;
+      else
+        row[model.terminalIndex(tr.first)] = GrammarModel::shiftCell(tr.second);
+    }
+    for (auto &r : reduces) {
+      if (r.first == 0) {
+        row[r.second] = -1;
+        continue;
+      }
+      int &cell = row[r.second];
+      if (cell == 0)
+        cell = GrammarModel::reduceCell(r.first);
+      else if (cell != GrammarModel::reduceCell(r.first))
+        ++conflicts;
+    }
+  }
+
+  void buildSlr() {
+    int n = (int)model.states().size();
+    reset(n);
+    for (int s = 0; s < n; ++s) {
+      for (int t = 0; t < T(); ++t)
+        action[(size_t)s * T() + t] = model.action(s, t);
+      for (auto &tr : model.states()[s].trans)
+        if (model.isNonterminal(tr.first))
+          gotos[(size_t)s * S() + tr.first] = tr.second;
+    }
+    conflicts = model.conflicts();
+  }
+
+  std::vector<Lr1State> buildLr1() const {
+    auto &prods = model.productions();
+    int eofIx = model.terminalIndex(model.eof());
+    std::vector<std::vector<int>> prodsOf(S());
+    for (int p = 0; p < (int)prods.size(); ++p)
+      prodsOf[prods[p].lhs].push_back(p);
+
+    // FIRST of each suffix rhs[k+1..] and whether it derives epsilon, per
+    // item position (p, k)
+    std::vector<int> base(prods.size() + 1, 0);
+    for (size_t p = 0; p < prods.size(); ++p)
+      base[p + 1] = base[p] + (int)prods[p].rhs.size() + 1;
+    std::vector<GrammarModel::Bits> suffixFirst(base.back(), GrammarModel::Bits(T()));
+    std::vector<char> suffixNullable(base.back(), 0);
+    for (size_t p = 0; p < prods.size(); ++p) {
+      auto &rhs = prods[p].rhs;
+      int n = (int)rhs.size();
+      GrammarModel::Bits acc(T());
+      bool nullable = true;
+      for (int k = n; k >= 0; --k) {
+        suffixFirst[base[p] + k] = acc;
+        suffixNullable[base[p] + k] = nullable;
+        if (k == 0)
+          break;
+        int X = rhs[k - 1];
+        if (!model.isNonterminal(X)) {
+          acc = GrammarModel::Bits(T());
+          acc.set(model.terminalIndex(X));
+          nullable = false;
+        } else {
+          if (!model.nullable(X)) {
+            acc = model.first(X);
+            nullable = false;
+          } else {
+            acc.merge(model.first(X));
+          }
+        }
+      }
+    }
+
+    std::vector<Lr1State> out;
+    std::map<std::vector<Item1>, int> index;
+    std::vector<int> seen((size_t)base.back() * T(), -1);
+    out.push_back({{{0, 0, eofIx}}, {}, {}});
+    index.emplace(out[0].kernel, 0);
+    for (size_t s = 0; s < out.size(); ++s) {
+      std::vector<Item1> items = out[s].kernel;
+      for (auto &it : items)
+        seen[(size_t)(base[it.prod] + it.dot) * T() + it.look] = (int)s;
+      for (size_t i = 0; i < items.size(); ++i) {
+        Item1 it = items[i];
+        auto &rhs = prods[it.prod].rhs;
+        if (it.dot == (int)rhs.size() || !model.isNonterminal(rhs[it.dot]))
+          continue;
+        GrammarModel::Bits looks = suffixFirst[base[it.prod] + it.dot + 1];
+        if (suffixNullable[base[it.prod] + it.dot + 1])
+          looks.set(it.look);
+        for (int q : prodsOf[rhs[it.dot]])
+          looks.forEach([&](int b) {
+            int &mark = seen[(size_t)base[q] * T() + b];
+            if (mark != (int)s) {
+              mark = (int)s;
+              items.push_back({q, 0, b});
+            }
+          });
+      }
+
+      std::map<int, std::vector<Item1>> next;
+      std::vector<std::pair<int, int>> reduces;
+      for (auto &it : items) {
+        auto &rhs = prods[it.prod].rhs;
+        if (it.dot == (int)rhs.size())
+          reduces.push_back({it.prod, it.look});
+        else
+          next[rhs[it.dot]].push_back({it.prod, it.dot + 1, it.look});
+      }
+      std::sort(reduces.begin(), reduces.end());
+      std::vector<std::pair<int, int>> trans;
+      for (auto &nx : next) {
+        std::sort(nx.second.begin(), nx.second.end());
+        auto f = index.find(nx.second);
+        int t;
+        if (f != index.end()) {
+          t = f->second;
+        } else {
+          t = (int)out.size();
+          index.emplace(nx.second, t);
+          out.push_back({nx.second, {}, {}});
+        }
+        trans.push_back({nx.first, t});
+      }
+      out[s].trans = std::move(trans);
+      out[s].reduces = std::move(reduces);
+    }
+    return out;
+  }
+
+  void buildClr() {
+    std::vector<Lr1State> lr1 = buildLr1();
+    reset((int)lr1.size());
+    for (int s = 0; s < states; ++s)
+      fillRow(s, lr1[s].trans, lr1[s].reduces);
+  }
+
+  void buildLalr() {
+    std::vector<Lr1State> lr1 = buildLr1();
+    std::map<std::vector<std::pair<int, int>>, int> coreIndex;
+    std::vector<int> merged(lr1.size());
+    for (size_t s = 0; s < lr1.size(); ++s) {
+      std::vector<std::pair<int, int>> core;
+      for (auto &it : lr1[s].kernel)
+        if (core.empty() || core.back() != std::make_pair(it.prod, it.dot))
+          core.push_back({it.prod, it.dot});
+      merged[s] = coreIndex.emplace(core, (int)coreIndex.size()).first->second;
+    }
+    int n = (int)coreIndex.size();
+    std::vector<std::vector<std::pair<int, int>>> trans(n), reduces(n);
+    std::vector<char> done(n, 0);
+    for (size_t s = 0; s < lr1.size(); ++s) {
+      int m = merged[s];
+      if (!done[m]) {
+        // same core, same transitions (up to merging)
+        done[m] = 1;
+        for (auto &tr : lr1[s].trans)
+          trans[m].push_back({tr.first, merged[tr.second]});
+      }
+      reduces[m].insert(reduces[m].end(), lr1[s].reduces.begin(), lr1[s].reduces.end());
+    }
+    reset(n);
+    for (int m = 0; m < n; ++m) {
+      std::sort(reduces[m].begin(), reduces[m].end());
+      reduces[m].erase(std::unique(reduces[m].begin(), reduces[m].end()), reduces[m].end());
+      fillRow(m, trans[m], reduces[m]);
+    }
+  }
+
+  bool parse(const int *tokens, size_t n, size_t *error_pos) const {
+    std::vector<int> stack = {0};
+    int eofCol = model.terminalIndex(model.eof());
+    size_t i = 0;
+    for (;;) {
+      int col = eofCol;
+      if (i < n)
+        col = tokens[i] >= 0 && tokens[i] < S() ? column[tokens[i]] : -1;
+      int a = col < 0 ? 0 : action[(size_t)stack.back() * T() + col];
+      if (a > 0) {
+        stack.push_back(a - 1);
+        ++i;
+      } else if (a < -1) {
+        int p = -a - 2;
+        stack.resize(stack.size() - rhsLen[p]);
+        int g = gotos[(size_t)stack.back() * S() + lhs[p]];
+        if (g < 0)
+          break;
+        stack.push_back(g);
+      } else if (a == -1) {
+        return true;
+      } else {
+        break;
+      }
+    }
+    if (error_pos)
+      *error_pos = i;
+    return false;
+  }
+
+  std::vector<int> symbolsOf(const GrammarModel::Bits &b) const {
+    std::vector<int> out;
+    b.forEach([&](int t) { out.push_back(model.terminal(t)); });
+    return out;
+  }
+};
+
+namespace lg {
+
+Grammar::Grammar(const std::string &text) : impl_(new Impl(text)) {}
+Grammar::~Grammar() = default;
+Grammar::Grammar(Grammar &&) noexcept = default;
+Grammar &Grammar::operator=(Grammar &&) noexcept = default;
+
+int Grammar::build(lg_method method) {
+  switch (method) {
+  case LG_SLR:
+    impl_->buildSlr();
+    break;
+  case LG_LALR:
+    impl_->buildLalr();
+    break;
+  case LG_CLR:
+    impl_->buildClr();
+    break;
+  default:
+    return -1;
+  }
+  return impl_->conflicts;
+}
+
+int Grammar::states() const { return impl_->states; }
+int Grammar::conflicts() const { return impl_->conflicts; }
+int Grammar::symbols() const { return impl_->S(); }
+
+int Grammar::symbol(const std::string &name) const {
+  auto f = impl_->ids.find(name);
+  return f == impl_->ids.end() ? -1 : f->second;
+}
+
+const std::string &Grammar::name(int symbol) const { return impl_->model.name(symbol); }
+bool Grammar::isTerminal(int symbol) const { return !impl_->model.isNonterminal(symbol); }
+int Grammar::start() const { return impl_->model.startSymbol(); }
+int Grammar::eof() const { return impl_->model.eof(); }
+
+std::vector<int> Grammar::first(int symbol) const {
+  if (isTerminal(symbol))
+    return {symbol};
+  return impl_->symbolsOf(impl_->model.first(symbol));
+}
+
+std::vector<int> Grammar::follow(int symbol) const {
+  if (isTerminal(symbol))
+    return {};
+  return impl_->symbolsOf(impl_->model.follow(symbol));
+}
+
+bool Grammar::nullable(int symbol) const {
+  return impl_->model.isNonterminal(symbol) && impl_->model.nullable(symbol);
+}
+
+bool Grammar::parse(const int *tokens, size_t n, size_t *error_pos) const {
+  if (states() == 0)
+    throw std::logic_error("lg::Grammar::parse called before build()");
+  return impl_->parse(tokens, n, error_pos);
+}
+
+std::vector<int> Grammar::tokenize(const std::string &sentence) const {
+  std::vector<int> out;
+  std::istringstream in(sentence);
+  std::string w;
+  if (impl_->oneCharTerminals && sentence.find_first_of(" \t") == std::string::npos) {
+    for (char c : sentence)
+      out.push_back(symbol(std::string(1, c)));
+    return out;
+  }
+  while (in >> w)
+    out.push_back(symbol(w));
+  return out;
+}
+
+} // namespace lg
+
+// C API: the handle is the C++ object
+struct lg_grammar {
+  lg::Grammar g;
+};
+
+namespace {
+
+int copySymbols(const std::vector<int> &v, int *out, size_t cap) {
+  for (size_t i = 0; i < v.size() && i < cap; ++i)
+    out[i] = v[i];
+  return (int)v.size();
+}
+
+bool validSymbol(const lg_grammar *g, int symbol) {
+  return g && symbol >= 0 && symbol < g->g.symbols();
+}
+
+} // namespace
+
+extern "C" {
+
+lg_grammar *lg_grammar_load(const char *text, char *err, size_t err_len) {
+  try {
+    return new lg_grammar{lg::Grammar(text ? text : "")};
+  } catch (const std::exception &e) {
+    if (err && err_len) {
+      std::strncpy(err, e.what(), err_len - 1);
+      err[err_len - 1] = '\0';
+    }
+    return nullptr;
+  }
+}
+
+void lg_grammar_free(lg_grammar *g) { delete g; }
+
+int lg_build(lg_grammar *g, lg_method method) { return g ? g->g.build(method) : -1; }
+int lg_state_count(const lg_grammar *g) { return g ? g->g.states() : 0; }
+int lg_symbol_count(const lg_grammar *g) { return g ? g->g.symbols() : 0; }
+int lg_symbol_id(const lg_grammar *g, const char *name) {
+  return g && name ? g->g.symbol(name) : -1;
+}
+
+const char *lg_symbol_name(const lg_grammar *g, int symbol) {
+  return validSymbol(g, symbol) ? g->g.name(symbol).c_str() : nullptr;
+}
+
+int lg_is_terminal(const lg_grammar *g, int symbol) {
+  return validSymbol(g, symbol) && g->g.isTerminal(symbol);
+}
+
+int lg_start_symbol(const lg_grammar *g) { return g ? g->g.start() : -1; }
+
+int lg_first(const lg_grammar *g, int symbol, int *out, size_t cap) {
+  return validSymbol(g, symbol) ? copySymbols(g->g.first(symbol), out, cap) : -1;
+}
+
+int lg_follow(const lg_grammar *g, int symbol, int *out, size_t cap) {
+  return validSymbol(g, symbol) ? copySymbols(g->g.follow(symbol), out, cap) : -1;
+}
+
+int lg_nullable(const lg_grammar *g, int symbol) {
+  return validSymbol(g, symbol) && g->g.nullable(symbol);
+}
+
+int lg_parse(const lg_grammar *g, const int *tokens, size_t n, size_t *error_pos) {
+  if (!g || g->g.states() == 0)
+    return -1;
+  return g->g.parse(tokens, n, error_pos) ? 1 : 0;
+}
+
+} // extern "C"
@@ -0,0 +1,112 @@
+/* libgrammar.h
+ * Embeddable grammar analysis and LR parsing. A grammar is loaded from
+ * text, its ACTION/GOTO tables are built with SLR(1), LALR(1) or canonical
+ * LR(1), and token buffers are parsed in-process. There is no global
+ * state: every grammar is an independent handle, and a built grammar may be
+ * queried and parsed from several threads at once (building is not
+ * thread-safe on the same handle).
+ *
+ * Grammar text: one production per line, either "E -> E + T" (symbols
+ * separated by blanks, "eps" for an empty right side) or the compact
+ * "E->E+T" form of the LR tools (one character per symbol, 'e' for empty).
+ * A leading line holding only a production count is ignored. The first
+ * production's left side is the start symbol; symbols that never appear on
+ * a left side are terminals.
+ *
+ * Build as a static or shared library:
+ *   g++ -O2 -c libgrammar.cpp -o libgrammar.o && ar rcs libgrammar.a libgrammar.o
+ *   g++ -O2 -shared -fPIC libgrammar.cpp -o libgrammar.so
+ */
+#ifndef LIBGRAMMAR_H
+#define LIBGRAMMAR_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct lg_grammar lg_grammar;
+
+typedef enum { LG_SLR = 0, LG_LALR = 1, LG_CLR = 2 } lg_method;
+
+/* NULL on a malformed grammar; the reason is copied into err if given */
+lg_grammar *lg_grammar_load(const char *text, char *err, size_t err_len);
+void lg_grammar_free(lg_grammar *g);
+
+/* Builds (or rebuilds) the tables; returns the number of shift/reduce and
+ * reduce/reduce conflicts (shift and the earlier production win), or -1 */
+int lg_build(lg_grammar *g, lg_method method);
+int lg_state_count(const lg_grammar *g);
+
+/* Symbols are dense ids 0..lg_symbol_count()-1; "$" is the end marker */
+int lg_symbol_count(const lg_grammar *g);
+int lg_symbol_id(const lg_grammar *g, const char *name); /* -1 if unknown */
+const char *lg_symbol_name(const lg_grammar *g, int symbol);
+int lg_is_terminal(const lg_grammar *g, int symbol);
+int lg_start_symbol(const lg_grammar *g);
+
+/* FIRST/FOLLOW of a nonterminal as terminal symbol ids: writes up to cap
+ * ids to out and returns the full count (-1 for a bad symbol). FIRST never
+ * contains "$"; use lg_nullable for epsilon. */
+int lg_first(const lg_grammar *g, int symbol, int *out, size_t cap);
+int lg_follow(const lg_grammar *g, int symbol, int *out, size_t cap);
+int lg_nullable(const lg_grammar *g, int symbol);
+
+/* Parses terminal symbol ids (no trailing "$"). Returns 1 if accepted, 0 if
+ * rejected (error_pos, if given, receives the offending token index) and -1
+ * if no tables were built. */
+int lg_parse(const lg_grammar *g, const int *tokens, size_t n, size_t *error_pos);
+
+#ifdef __cplusplus
+}
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lg {
+
+class Grammar {
+public:
+  // Throws std::invalid_argument on a malformed grammar
+  explicit Grammar(const std::string &text);
+  ~Grammar();
+  Grammar(Grammar &&) noexcept;
+  Grammar &operator=(Grammar &&) noexcept;
+
+  int build(lg_method method);
+  int states() const;
+  int conflicts() const;
+
+  int symbols() const;
+  int symbol(const std::string &name) const;
+  const std::string &name(int symbol) const;
+  bool isTerminal(int symbol) const;
+  int start() const;
+  int eof() const;
+
+  std::vector<int> first(int symbol) const;
+  std::vector<int> follow(int symbol) const;
+  bool nullable(int symbol) const;
+
+  // Accepts or rejects; on rejection error_pos is the offending token index.
+  // Throws std::logic_error if build() has not been called.
+  bool parse(const int *tokens, size_t n, size_t *error_pos = nullptr) const;
+  bool parse(const std::vector<int> &tokens, size_t *error_pos = nullptr) const {
+    return parse(tokens.data(), tokens.size(), error_pos);
+  }
+  // Symbol ids of a blank-separated sentence ("id + id"), or of each
+  // character when every terminal is one character; -1 for unknown tokens
+  std::vector<int> tokenize(const std::string &sentence) const;
+
+  struct Impl;
+
+private:
+  std::unique_ptr<Impl> impl_;
+};
+
+} // namespace lg
+#endif
+
+#endif
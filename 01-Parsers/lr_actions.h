@@ -0,0 +1,84 @@
+// lr_actions.h
+// Semantic actions for PackedTable::parse<Actions>. An Actions class is a
+// plain type whose members the driver calls directly, so they inline into
+// the parse loop:
+//
+//   struct MyActions {
+//     using Value = ...;                           // one per stack entry
+//     Value shift(char token, size_t pos);         // value of a shifted token
+//     Value reduce(int prod, ValueSpan<Value> rhs);// value of the lhs
+//   };
+//
+// rhs holds the values of the production's right side, left to right (empty
+// for an epsilon production); the driver owns the value stack.
+#ifndef LR_ACTIONS_H
+#define LR_ACTIONS_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Non-owning view of the top entries of the value stack
+template <class T> class ValueSpan {
+public:
+  ValueSpan(T *data, size_t size) : data_(data), size_(size) {}
+  T &operator[](size_t i) const { return data_[i]; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  T *begin() const { return data_; }
+  T *end() const { return data_ + size_; }
+
+private:
+  T *data_;
+  size_t size_;
+};
+
+// Recognizer only: PackedTable::parse(cols, stack) runs with these and keeps
+// no value stack at all
+struct NoActions {
+  struct Value {};
+  Value shift(char, size_t) { return {}; }
+  Value reduce(int, ValueSpan<Value>) { return {}; }
+};
+
+// Postfix translation for single-character grammars: a production's value
+// is its nonterminals' values in order, followed by its other terminals, so
+// E -> E+T gives "<E><T>+"; brackets are dropped. rhs[p] is the right side
+// of production p ("" for epsilon) and nonterminal[c] marks the nonterminals.
+class PostfixActions {
+public:
+  using Value = std::string;
+
+  PostfixActions(std::vector<std::string> rhs, const bool (&nonterminal)[256])
+      : rhs_(std::move(rhs)) {
+    for (int c = 0; c < 256; ++c)
+      nt_[c] = nonterminal[c];
+  }
+
+  Value shift(char token, size_t) { return Value(1, token); }
+
+  Value reduce(int prod, ValueSpan<Value> values) {
+    const std::string &rhs = rhs_[prod];
+    Value out, ops;
+    for (size_t i = 0; i < values.size() && i < rhs.size(); ++i) {
+      unsigned char sym = rhs[i];
+      if (nt_[sym])
+        out += values[i];
+      else if (!isBracket(sym))
+        ops += values[i];
+    }
+    // a right side of terminals only (F -> i) is an operand itself
+    return out.empty() ? ops : out + ops;
+  }
+
+private:
+  static bool isBracket(char c) {
+    return c == '(' || c == ')' || c == '[' || c == ']' || c == '{' || c == '}';
+  }
+
+  std::vector<std::string> rhs_;
+  bool nt_[256];
+};
+
+#endif
@@ -0,0 +1,101 @@
+// model_table.h
+// Glue between GrammarModel and PackedTable for grammars written in the
+// single-character notation the LR tools read ("E->E+T", 'e' for an empty
+// right side): read such a grammar into a model and turn the model's SLR(1)
+// table into a flat PackedTable.
+#ifndef MODEL_TABLE_H
+#define MODEL_TABLE_H
+
+#include <istream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "grammar_model.h"
+#include "packed_table.h"
+
+// Adds one "A->xyz" production; false if the line is not one
+inline bool addCharProduction(GrammarModel &g, const std::string &line) {
+  size_t arrow = line.find("->");
+  if (arrow != 1)
+    return false;
+  std::string rhs = line.substr(3);
+  std::vector<std::string> syms;
+  if (rhs != "e")
+    for (char c : rhs)
+      syms.push_back(std::string(1, c));
+  g.addProduction(std::string(1, line[0]), syms);
+  return true;
+}
+
+// "N" followed by N productions, blanks ignored; false on a malformed line
+inline bool readCharGrammar(std::istream &in, GrammarModel &g) {
+  int n = 0;
+  if (!(in >> n) || n <= 0)
+    return false;
+  for (int i = 0; i < n; ++i) {
+    std::string line;
+    if (!(in >> line) || !addCharProduction(g, line))
+      return false;
+  }
+  return true;
+}
+
+// Flat table of a built model. Symbols must be single characters; the
+// augmented start symbol is never a goto target, so it gets a spare code.
+inline PackedTable packModel(const GrammarModel &g) {
+  int aug = g.productions()[0].lhs;
+  auto code = [&](int sym) { return sym == aug ? '\x01' : g.name(sym)[0]; };
+  std::vector<char> terms, nts;
+  for (int t = 0; t < g.T(); ++t)
+    if (g.terminal(t) != g.eof())
+      terms.push_back(code(g.terminal(t)));
+  terms.push_back('$');
+  for (int s = 0; s < g.symbolCount(); ++s)
+    if (g.isNonterminal(s))
+      nts.push_back(code(s));
+  std::vector<std::pair<char, int>> prods;
+  for (auto &p : g.productions())
+    prods.push_back({code(p.lhs), p.live ? (int)p.rhs.size() : 0});
+
+  std::map<std::pair<int, char>, std::string> action;
+  std::map<std::pair<int, char>, int> gotos;
+  for (int s = 0; s < (int)g.states().size(); ++s) {
+    if (!g.states()[s].live)
+      continue;
+    for (int t = 0; t < g.T(); ++t) {
+      int v = g.action(s, t);
+      char a = code(g.terminal(t));
+      if (v > 0)
+        action[{s, a}] = "s" + std::to_string(v - 1);
+      else if (v == -1)
+        action[{s, a}] = "acc";
+      else if (v < -1)
+        action[{s, a}] = "r" + std::to_string(-v - 2);
+    }
+    for (auto &tr : g.states()[s].trans)
+      if (g.isNonterminal(tr.first))
+        gotos[{s, code(tr.first)}] = tr.second;
+  }
+  return PackedTable((int)g.states().size(), terms, nts, prods, action, gotos);
+}
+
+// Right sides as strings ("" for epsilon) and the nonterminal flags, the
+// inputs PostfixActions needs
+inline std::vector<std::string> modelRightSides(const GrammarModel &g, bool (&nonterminal)[256]) {
+  std::vector<std::string> rhs;
+  std::fill(std::begin(nonterminal), std::end(nonterminal), false);
+  for (auto &p : g.productions()) {
+    std::string r;
+    for (int X : p.rhs)
+      r += g.name(X)[0];
+    rhs.push_back(r);
+  }
+  for (int s = 0; s < g.symbolCount(); ++s)
+    if (g.isNonterminal(s))
+      nonterminal[(unsigned char)g.name(s)[0]] = true;
+  return rhs;
+}
+
+#endif
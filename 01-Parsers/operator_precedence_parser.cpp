@@ -19,7 +19,372 @@ if (v[i] == c)
 return (int)i;
 return -1;
 }
-int main() {
+// Precedence functions from the relation table: a < b iff f(a) < g(b),
+// a > b iff f(a) > g(b), a = b iff f(a) = g(b). Nodes f_a and g_b are merged
+// when a = b, edges follow the > relations, and each function value is the
+// longest path out of its node; false if the graph has a cycle.
+bool precedence_functions(const vector<vector<char>> &rel, vector<int> &f, vector<int> &g) {
+int Tn = (int)rel.size();
+// node i is f_i, node Tn + i is g_i
+vector<int> rep(2 * Tn);
+iota(rep.begin(), rep.end(), 0);
+function<int(int)> find = [&](int x) { return rep[x] == x ? x : rep[x] = find(rep[x]); };
+for (int a = 0; a < Tn; ++a)
+for (int b = 0; b < Tn; ++b)
+if (rel[a][b] == '=')
+rep[find(a)] = find(Tn + b);
+vector<vector<int>> succ(2 * Tn); // u -> v: value(u) > value(v)
+for (int a = 0; a < Tn; ++a)
+for (int b = 0; b < Tn; ++b) {
+if (rel[a][b] == '>')
+succ[find(a)].push_back(find(Tn + b));
+else if (rel[a][b] == '<')
+succ[find(Tn + b)].push_back(find(a));
+}
+vector<int> len(2 * Tn, 0), state(2 * Tn, 0);
+bool cyclic = false;
+function<int(int)> longest = [&](int u) -> int {
+if (state[u] == 1) {
+cyclic = true;
+return 0;
+}
+if (state[u] == 2)
+return len[u];
+state[u] = 1;
+for (int v : succ[u])
+len[u] = max(len[u], longest(v) + 1);
+state[u] = 2;
+return len[u];
+};
+for (int i = 0; i < Tn; ++i) {
+f[i] = longest(find(i));
+g[i] = longest(find(Tn + i));
+}
+return !cyclic;
+}
+// Pratt (top-down operator precedence) parser built from the same relations.
+// Right sides of the forms t (operand), NtN (infix), tN (prefix), Nt
+// (postfix) and tNu with t = u (brackets) are recognized. An operator's left
+// binding power is g(op) and its right operand is parsed with f(op), so it
+// continues exactly where the shift-reduce loop would shift. Operators are
+// grouped into levels by left binding power; level(k) parses an expression
+// whose operators are all at level k or above, and an operator's right
+// operand is parsed at the first level that binds tighter than f(op).
+struct Pratt {
+enum { OPERAND = 1, INFIX = 2, PREFIX = 4, POSTFIX = 8, OPEN = 16 };
+vector<char> name;       // terminal index -> character
+vector<int> kind, close; // kind bits; OPEN -> matching close
+vector<int> lv, rlv;     // INFIX/POSTFIX level; INFIX/PREFIX right operand level
+vector<int> bp;          // left binding power of each level, ascending
+int col[256];            // character -> terminal index, -1 if none
+int dollar = -1;
+const int *in = nullptr;
+size_t pos = 0;
+vector<int> buf;
+bool build(const vector<string> &rhs_list, const vector<char> &NT, const vector<char> &T,
+const vector<vector<char>> &rel, const vector<int> &f, const vector<int> &g, string &why) {
+int Tn = (int)T.size();
+name = T;
+kind.assign(Tn, 0);
+close.assign(Tn, -1);
+lv.assign(Tn, 0);
+rlv.assign(Tn, 0);
+fill(begin(col), end(col), -1);
+for (int i = 0; i < Tn; ++i)
+col[(unsigned char)T[i]] = i;
+dollar = idx_of(T, '$');
+for (const string &rhs : rhs_list) {
+string shape;
+for (char c : rhs)
+shape += idx_of(NT, c) != -1 ? 'N' : 't';
+int t0 = idx_of(T, rhs[0]), tl = idx_of(T, rhs.back());
+if (shape == "t")
+kind[t0] |= OPERAND;
+else if (shape == "N")
+continue; // chain rule
+else if (shape == "NtN")
+kind[idx_of(T, rhs[1])] |= INFIX;
+else if (shape == "tN")
+kind[t0] |= PREFIX;
+else if (shape == "Nt")
+kind[tl] |= POSTFIX;
+else if (shape == "tNt" && rel[t0][tl] == '=') {
+kind[t0] |= OPEN;
+close[t0] = tl;
+} else {
+why = "right side " + rhs + " is not an operand, infix, prefix, postfix or bracket form";
+return false;
+}
+}
+for (int t = 0; t < Tn; ++t)
+if (kind[t] & (INFIX | POSTFIX))
+bp.push_back(g[t]);
+sort(bp.begin(), bp.end());
+bp.erase(unique(bp.begin(), bp.end()), bp.end());
+for (int t = 0; t < Tn; ++t) {
+lv[t] = (int)(lower_bound(bp.begin(), bp.end(), g[t]) - bp.begin());
+rlv[t] = (int)(upper_bound(bp.begin(), bp.end(), f[t]) - bp.begin());
+}
+return true;
+}
+bool primary(string *out) {
+int t = in[pos];
+if (t < 0)
+return false;
+if (kind[t] & OPERAND) {
+++pos;
+if (out)
+*out = string(1, name[t]);
+return true;
+}
+if (kind[t] & OPEN) {
+++pos;
+if (!level(0, out) || in[pos] != close[t])
+return false;
+++pos;
+return true;
+}
+if (kind[t] & PREFIX) {
+++pos;
+string r;
+if (!level(rlv[t], out ? &r : nullptr))
+return false;
+if (out)
+*out = "(" + string(1, name[t]) + r + ")";
+return true;
+}
+return false;
+}
+bool level(int k, string *out) {
+if (!primary(out))
+return false;
+while (true) {
+int t = in[pos];
+if (t < 0 || !(kind[t] & (INFIX | POSTFIX)) || lv[t] < k)
+return true;
+++pos;
+if (kind[t] & INFIX) {
+string r;
+if (!level(rlv[t], out ? &r : nullptr))
+return false;
+if (out)
+*out = "(" + *out + name[t] + r + ")";
+} else if (out) {
+*out = "(" + *out + name[t] + ")";
+}
+}
+}
+// Input without the trailing $; tree receives the parenthesized parse
+bool parse(const string &text, string *tree) {
+buf.clear();
+for (char c : text)
+buf.push_back(col[(unsigned char)c]);
+buf.push_back(dollar);
+in = buf.data();
+pos = 0;
+return level(0, tree) && in[pos] == dollar;
+}
+size_t error_pos() const { return pos; }
+void describe(ostream &out) const {
+out << "Pratt levels (left binding power: operators):\n";
+for (size_t k = 0; k < bp.size(); ++k) {
+out << " level " << k << " (" << bp[k] << "):";
+for (size_t t = 0; t < name.size(); ++t)
+if ((kind[t] & (INFIX | POSTFIX)) && lv[t] == (int)k)
+out << " " << name[t] << ((kind[t] & INFIX) ? (rlv[t] > (int)k ? " left" : " right") : " postfix");
+out << "\n";
+}
+}
+// C++ source of the same parser, one recursive function per level
+void emit(ostream &dest) const {
+ostringstream out;
+int L = (int)bp.size();
+auto esc = [](char c) { return c == '\'' || c == '\\' ? string("'\\") + c + "'" : "'" + string(1, c) + "'"; };
+out << "// Pratt parser generated from the operator-precedence table.\n"
+"// level_k() parses an expression whose operators bind at least as tightly\n"
+"// as level k; parse() accepts a whole string of single-character terminals.\n"
+"static const char *p;\n";
+for (int k = 0; k <= L; ++k)
+out << "static bool level_" << k << "();\n";
+out << "static bool primary() {\nswitch (*p) {\n";
+for (size_t t = 0; t < name.size(); ++t) {
+if ((int)t == dollar || !(kind[t] & (OPERAND | OPEN | PREFIX)))
+continue;
+out << "case " << esc(name[t]) << ":\n++p;\n";
+if (kind[t] & OPERAND)
+out << "return true;\n";
+else if (kind[t] & OPEN)
+out << "if (!level_0() || *p != " << esc(name[close[t]]) << ")\nreturn false;\n++p;\nreturn true;\n";
+else
+out << "return level_" << rlv[t] << "();\n";
+}
+out << "default:\nreturn false;\n}\n}\n";
+for (int k = 0; k <= L; ++k) {
+out << "static bool level_" << k << "() {\nif (!primary())\nreturn false;\n";
+if (k < L) {
+out << "for (;;) {\nswitch (*p) {\n";
+for (size_t t = 0; t < name.size(); ++t) {
+if (!(kind[t] & (INFIX | POSTFIX)) || lv[t] < k)
+continue;
+out << "case " << esc(name[t]) << ":\n++p;\n";
+if (kind[t] & INFIX)
+out << "if (!level_" << rlv[t] << "())\nreturn false;\n";
+out << "break;\n";
+}
+out << "default:\nreturn true;\n}\n}\n";
+} else {
+out << "return true;\n";
+}
+out << "}\n";
+}
+out << "bool parse(const char *s) {\np = s;\nreturn level_0() && *p == '\\0';\n}\n";
+// indent by braces; case bodies and brace-less if statements one step further
+istringstream lines(out.str());
+string line;
+int depth = 0;
+bool in_case = false, body = false;
+while (getline(lines, line)) {
+bool label = line.compare(0, 5, "case ") == 0 || line == "default:";
+if (line[0] == '}') {
+--depth;
+in_case = false;
+}
+if (label)
+in_case = false;
+dest << string(2 * (depth + in_case + body), ' ') << line << "\n";
+if (label)
+in_case = true;
+// the statement of a brace-less if
+body = line.compare(0, 4, "if (") == 0 && line.back() != '{';
+depth += (int)count(line.begin(), line.end(), '{') - (line[0] == '}' ? 0 : (int)count(line.begin(), line.end(), '}'));
+}
+}
+};
+// Random expression over the Pratt parser's operand/operator classes
+string random_expression(const Pratt &pr, mt19937 &rng, int depth) {
+vector<int> operands, infix, prefix, postfix, open;
+for (size_t t = 0; t < pr.name.size(); ++t) {
+if ((int)t == pr.dollar)
+continue;
+if (pr.kind[t] & Pratt::OPERAND)
+operands.push_back(t);
+if (pr.kind[t] & Pratt::INFIX)
+infix.push_back(t);
+if (pr.kind[t] & Pratt::PREFIX)
+prefix.push_back(t);
+if (pr.kind[t] & Pratt::POSTFIX)
+postfix.push_back(t);
+if (pr.kind[t] & Pratt::OPEN)
+open.push_back(t);
+}
+auto pick = [&](const vector<int> &v) { return pr.name[v[rng() % v.size()]]; };
+if (operands.empty())
+return "";
+if (depth <= 0 || rng() % 4 == 0)
+return string(1, pick(operands));
+int r = rng() % 8;
+if (r == 0 && !open.empty()) {
+int t = open[rng() % open.size()];
+return pr.name[t] + random_expression(pr, rng, depth - 1) + pr.name[pr.close[t]];
+}
+if (r == 1 && !prefix.empty())
+return pick(prefix) + random_expression(pr, rng, depth - 1);
+if (r == 2 && !postfix.empty())
+return random_expression(pr, rng, depth - 1) + pick(postfix);
+if (infix.empty())
+return string(1, pick(operands));
+return random_expression(pr, rng, depth - 1) + pick(infix) + random_expression(pr, rng, depth - 1);
+}
+// Parses a random corpus (valid expressions, deeply nested ones and single
+// character mutations of them) with both parsers: they must agree on
+// acceptance and on the parenthesized parse; then times both
+template <class OpParse> int check_agreement(Pratt &pratt, OpParse &op_parse, int count) {
+mt19937 rng(1344);
+vector<string> corpus, deep;
+for (int i = 0; i < count; ++i) {
+string e = random_expression(pratt, rng, 1 + rng() % 8);
+corpus.push_back(e);
+string m = e;
+int r = rng() % 3;
+size_t at = rng() % (m.size() + 1);
+char c = pratt.name[rng() % pratt.name.size()];
+if (r == 0 && !m.empty())
+m.erase(min(at, m.size() - 1), 1);
+else if (r == 1 || m.empty())
+m.insert(at, 1, c == '$' ? m[0] : c);
+else
+m[min(at, m.size() - 1)] = c == '$' ? m[0] : c;
+corpus.push_back(m);
+}
+// deep nesting: a chain of bracketed subexpressions around each other
+for (int i = 0; i < max(1, count / 100); ++i) {
+string e = random_expression(pratt, rng, 3);
+for (int d = 0; d < 200; ++d) {
+string side = random_expression(pratt, rng, 2);
+bool bracket = false;
+for (size_t t = 0; t < pratt.name.size() && !bracket; ++t)
+if ((pratt.kind[t] & Pratt::OPEN) && rng() % 2) {
+e = pratt.name[t] + e + pratt.name[pratt.close[t]];
+bracket = true;
+}
+for (size_t t = 0; t < pratt.name.size(); ++t)
+if ((pratt.kind[t] & Pratt::INFIX) && rng() % 3 == 0) {
+e = rng() % 2 ? side + pratt.name[t] + e : e + pratt.name[t] + side;
+break;
+}
+}
+deep.push_back(e);
+}
+int mismatches = 0, accepted = 0;
+for (const vector<string> *set : {&corpus, &deep})
+for (const string &e : *set) {
+string t1, t2;
+bool a1 = op_parse(e, false, true, &t1), a2 = pratt.parse(e, &t2);
+accepted += a1 && a2;
+if (a1 != a2 || (a1 && t1 != t2)) {
+if (++mismatches <= 5)
+cout << "MISMATCH on " << e << ": shift-reduce " << (a1 ? t1 : "rejects") << ", Pratt "
+<< (a2 ? t2 : "rejects") << "\n";
+}
+}
+cout << "\nAgreement: " << corpus.size() + deep.size() << " inputs (" << accepted
+<< " accepted), " << mismatches << " mismatch(es)\n";
+auto time = [&](const vector<string> &set, auto parse) {
+auto t0 = chrono::steady_clock::now();
+size_t ok = 0;
+for (const string &e : set)
+ok += parse(e);
+return make_pair(chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count(), ok);
+};
+for (auto &named : {make_pair("random", &corpus), make_pair("deeply nested", &deep)}) {
+const vector<string> &set = *named.second;
+size_t chars = 0;
+for (const string &e : set)
+chars += e.size();
+auto op = time(set, [&](const string &e) { return op_parse(e, false, true, nullptr); });
+auto pr = time(set, [&](const string &e) { return pratt.parse(e, nullptr); });
+cout << "Timing, " << named.first << " (" << set.size() << " inputs, " << chars
+<< " chars): shift-reduce " << fixed << setprecision(2) << op.first << " ms, Pratt "
+<< pr.first << " ms, " << setprecision(1) << op.first / max(pr.first, 1e-6) << "x\n";
+}
+return mismatches ? 1 : 0;
+}
+int main(int argc, char **argv) {
+bool pratt_mode = false, emit = false;
+int check_n = 0;
+for (int i = 1; i < argc; ++i) {
+string arg = argv[i];
+if (arg == "--pratt")
+pratt_mode = true;
+else if (arg == "--emit-pratt")
+emit = true;
+else if (arg == "--check" && i + 1 < argc)
+check_n = atoi(argv[++i]);
+else {
+cerr << "Usage: " << argv[0] << " [--pratt | --check N | --emit-pratt]\n";
+return 1;
+}
+}
 cout << "Enter number of productions: ";
 int n;
 if (!(cin >> n))
@@ -116,9 +481,9 @@ changed = true;
 // collect a But the iterative approach will propagate via other rules.
 }
 // Also, if first symbol is nonterminal followed by terminal, include that
-// terminal:
-for (size_t k = 0; k + 1 < rhs.size(); ++k) {
-char c1 = rhs[k], c2 = rhs[k + 1];
+// terminal (only the first one: A -> Ba...):
+if (rhs.size() > 1) {
+char c1 = rhs[0], c2 = rhs[1];
 if (idx_of(NT, c1) != -1 && idx_of(T, c2) != -1) {
 if (LEAD[A].insert(c2).second)
 changed = true;
@@ -143,9 +508,10 @@ for (char t : TRAIL[x])
 if (TRAIL[A].insert(t).second)
 changed = true;
 }
-// also if terminal followed by nonterminal anywhere -> add that terminal
-for (int k = (int)rhs.size() - 2; k >= 0; --k) {
-char c1 = rhs[k], c2 = rhs[k + 1];
+// also if the last symbol is a nonterminal preceded by a terminal
+// (A -> ...aB) -> add that terminal
+if (rhs.size() > 1) {
+char c1 = rhs[rhs.size() - 2], c2 = rhs[rhs.size() - 1];
 if (idx_of(T, c1) != -1 && idx_of(NT, c2) != -1) {
 if (TRAIL[A].insert(c1).second)
 changed = true;
@@ -252,20 +618,56 @@ cout << (table[i][j] == ' ' ? '.' : table[i][j]) << " ";
 }
 cout << "\n";
 }
+// ---- Precedence functions and Pratt parser ----
+// f is for the stack-top terminal and g for the input one; with them the
+// relations become binding powers for a Pratt parser.
+vector<int> f(Tn, 0), g(Tn, 0);
+bool have_fg = precedence_functions(table, f, g);
+vector<string> rhs_list;
+for (int i = 0; i < n; ++i)
+rhs_list.push_back(rhs_of(i));
+Pratt pratt;
+string why;
+bool have_pratt = have_fg && pratt.build(rhs_list, NT, T, table, f, g, why);
+if (!have_fg)
+why = "the precedence relations have no precedence functions (cycle)";
+if (pratt_mode || check_n > 0 || emit) {
+cout << "\nPrecedence functions:\n";
+if (have_fg) {
+for (int i = 0; i < Tn; ++i)
+cout << " f(" << T[i] << ") = " << f[i] << "  g(" << T[i] << ") = " << g[i] << "\n";
+}
+if (!have_pratt) {
+cout << "No Pratt parser: " << why << "\n";
+return 1;
+}
+pratt.describe(cout);
+}
+if (emit) {
+pratt.emit(cout);
+return 0;
+}
 // ---- Parser (operator-precedence) ----
-cout << "\nEnter input string (use single-char terminals, end with $): ";
-string input;
-cin >> input;
+// Rescans the stack for the rightmost terminal on every step. With strict,
+// a handle must have the shape of some right side (nonterminals match any
+// nonterminal) instead of being collapsed to N; tree receives the fully
+// parenthesized form of the parse.
+auto op_parse = [&](const string &text, bool trace, bool strict, string *tree) -> bool {
+string input = text;
 // ensure input ends with $
-if (input.back() != '$')
+if (input.empty() || input.back() != '$')
 input.push_back('$');
 // stack holds symbols (we'll store as chars). For parser we need to find the
 // rightmost terminal on stack to compare precedence.
 vector<char> stack_sym;
+vector<string> stack_val;
 stack_sym.push_back('$'); // bottom marker
+stack_val.push_back("");
 // for readability we show actions
 auto print_state = [&](const vector<char> &stk, const string &inp,
 const string &action) {
+if (!trace)
+return;
 // print stack as string
 cout << setw(20);
 string s;
@@ -275,9 +677,11 @@ cout << s << " ";
 cout << setw(20) << inp << " ";
 cout << action << "\n";
 };
+if (trace) {
 cout << "\nParsing steps:\n";cout << setw(20) << "Stack" << setw(25) << "Input" << setw(15) << "Action"
 << "\n";
 cout << string(60, '-') << "\n";
+}
 string action;
 size_t ip = 0;
 // helper: find index of rightmost terminal in stack
@@ -289,18 +693,20 @@ return i;
 return -1;
 };
 bool accepted = false;
-int safety = 0;
+size_t safety = 0, limit = max<size_t>(1000, 4 * input.size());
 while (true) {
 // produce readable input remnant
-string rem = input.substr(ip);
+string rem = trace ? input.substr(ip) : string();
 print_state(stack_sym, rem, "");
-if (safety++ > 1000) {
+if (safety++ > limit) {
+if (trace)
 cout << "Parsing loop limit reached. Aborting.\n";
 break;
 }
 // find topmost terminal on stack
 int pos = rightmost_terminal_pos(stack_sym);
 if (pos == -1) {
+if (trace)
 cout << "No terminal on stack (error)\n";
 break;
 }
@@ -313,7 +719,10 @@ rel = table[ia][ib];
 if (a == '$' && b == '$') {
 action = "ACCEPT";
 print_state(stack_sym, rem, action);
-accepted = true;
+// exactly one nonterminal must be left over $
+accepted = !strict || (stack_sym.size() == 2 && idx_of(T, stack_sym[1]) == -1);
+if (tree && accepted)
+*tree = stack_val.back();
 break;
 }
 if (rel == '<' || rel == '=') {
@@ -321,7 +730,8 @@ if (rel == '<' || rel == '=') {
 action = string("SHIFT ") + b;
 // push the input symbol onto stack
 stack_sym.push_back(b);ip++;
-print_state(stack_sym, input.substr(ip), action);
+stack_val.push_back(string(1, b));
+print_state(stack_sym, trace ? input.substr(ip) : string(), action);
 continue;
 } else if (rel == '>') {
 // REDUCE: find handle between nearest terminal t (at pos) and the top of
@@ -333,16 +743,20 @@ continue;
 // scanning back from pos-1 until either we find table[ idx(T,
 // stack_sym[l]) ][ idx(T, stack_sym[pos]) ] == '<' OR l==0 Then the
 // handle is everything after that terminal.
+// Each terminal is compared with the terminal to its right (the last one
+// passed), not with the topmost one: in $N+(N) the handle is (N).
 int top_term_pos = rightmost_terminal_pos(stack_sym); // pos
 int lpos = -1;
+int right_pos = top_term_pos;
 for (int k = top_term_pos - 1; k >= 0; --k) {
 if (idx_of(T, stack_sym[k]) != -1) {
 int ik = idx_of(T, stack_sym[k]);
-int itop = idx_of(T, stack_sym[top_term_pos]);
-if (table[ik][itop] == '<') {
+int iright = idx_of(T, stack_sym[right_pos]);
+if (table[ik][iright] == '<') {
 lpos = k;
 break;
 }
+right_pos = k;
 }
 }
 if (lpos == -1) {
@@ -355,6 +769,16 @@ int handle_len = (int)stack_sym.size() - handle_start;
 string handle;
 for (int k = handle_start; k < (int)stack_sym.size(); ++k)
 handle.push_back(stack_sym[k]);
+// value of the handle: an operand stands for itself, brackets vanish,
+// anything else is parenthesized
+string val;
+if (tree) {
+bool bracket = handle_len >= 3 && idx_of(T, handle[0]) != -1 && idx_of(T, handle.back()) != -1;
+for (int k = handle_start + bracket; k < (int)stack_sym.size() - bracket; ++k)
+val += stack_val[k];
+if (handle_len > 1 && !bracket)
+val = "(" + val + ")";
+}
 // try to match handle to some production RHS
 bool reduced = false;
 char reduce_to = 'N'; // default nonterminal placeholder
@@ -364,21 +788,44 @@ if (rhs == handle) {
 // reduce by replacing handle with LHS
 reduce_to = prod[p][0];
 // pop handle symbols
-for (int k = 0; k < handle_len; ++k)
+for (int k = 0; k < handle_len; ++k) {
 stack_sym.pop_back();
+stack_val.pop_back();
+}
 stack_sym.push_back(reduce_to);
+stack_val.push_back(val);
 action = string("REDUCE by ") + prod[p];
 reduced = true;
 break;}
 }
+if (!reduced && strict) {
+// some right side must have the handle's shape
+bool shaped = false;
+for (int p = 0; p < n && !shaped; ++p) {
+string rhs = rhs_of(p);
+shaped = rhs.size() == handle.size();
+for (size_t k = 0; k < rhs.size() && shaped; ++k) {
+bool rt = idx_of(T, rhs[k]) != -1, ht = idx_of(T, handle[k]) != -1;
+shaped = rt == ht && (!rt || rhs[k] == handle[k]);
+}
+}
+if (!shaped) {
+action = "ERROR: no right side of the form '" + handle + "'";
+print_state(stack_sym, rem, action);
+break;
+}
+}
 if (!reduced) {
 // No exact match -> collapse handle to 'N' nonterminal (to continue)
-for (int k = 0; k < handle_len; ++k)
+for (int k = 0; k < handle_len; ++k) {
 stack_sym.pop_back();
+stack_val.pop_back();
+}
 stack_sym.push_back(reduce_to);
+stack_val.push_back(val);
 action = string("REDUCE (general) replace '") + handle + "' by N";
 }
-print_state(stack_sym, input.substr(ip), action);
+print_state(stack_sym, trace ? input.substr(ip) : string(), action);
 continue;
 } else {
 // no relation defined -> error
@@ -390,9 +837,26 @@ print_state(stack_sym, rem, action);
 break;
 }
 } // end parsing loop
+return accepted;
+};
+if (check_n > 0)
+return check_agreement(pratt, op_parse, check_n);
+cout << "\nEnter input string (use single-char terminals, end with $): ";
+string input;
+cin >> input;
+bool accepted = op_parse(input, true, false, nullptr);
 if (accepted)
 cout << "\nInput accepted by operator-precedence parser.\n";
 else
 cout << "\nInput rejected (or error occurred).\n";
+if (pratt_mode) {
+string tree;
+if (input.back() == '$')
+input.pop_back();
+if (pratt.parse(input, &tree))
+cout << "Pratt parser: accepted, " << tree << "\n";
+else
+cout << "Pratt parser: rejected at position " << pratt.error_pos() << "\n";
+}
 return 0;
-}
\ No newline at end of file
+}
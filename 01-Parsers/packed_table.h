@@ -0,0 +1,643 @@
+// packed_table.h
+// Flat form of an LR ACTION/GOTO table for the runtime parse loop, built from
+// the map-based tables of lalr.cpp and slr.cpp. Each state owns one row:
+// ACTION cells, an error column for characters that are not terminals, then
+// GOTO cells. compress() is an optional post-pass:
+//   1. states whose rows are identical (after their targets are merged) share
+//      one row, and shift/goto cells hold the target row's offset, so the
+//      parse stack holds offsets and no state -> row lookup is needed,
+//   2. terminal columns are renumbered from a frequency profile so that the
+//      most frequent terminals come first and share a row's first cache line,
+//   3. cells narrow to 16 bits and rows are padded to a power of two (up to 64
+//      bytes) on a 64-byte aligned base, so a row never straddles two lines.
+#ifndef PACKED_TABLE_H
+#define PACKED_TABLE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lr_actions.h"
+
+class PackedTable {
+public:
+  struct Result {
+    bool accepted = false;
+    long long steps = 0;  // shifts + reductions
+    long long errors = 0; // syntax errors reported by parseRecovering
+    size_t depth = 0;     // deepest the stack got, in states above the start state
+  };
+
+  // Error recovery settings for one grammar. Panic mode resynchronizes on
+  // the sync terminals (and '$'); with none given, every terminal is one.
+  struct Recovery {
+    std::string sync;
+    long long maxErrors = 100; // stop after this many errors
+  };
+
+  struct SyntaxError {
+    enum Repair { Inserted, Resynced, GaveUp };
+    size_t pos;           // tokens consumed before the offending one
+    char found;           // offending terminal, '$' at the end, 0 if not a terminal
+    std::string expected; // terminals the parser could act on there
+    Repair repair;
+    char inserted = 0;    // Inserted: the terminal put in front of `found`
+    size_t skipped = 0;   // Resynced: tokens discarded, `found` included
+    size_t popped = 0;    // Resynced: states popped
+  };
+
+  // ACTION entries are "sN", "rN", "acc"/"accept"; productions are given as
+  // (lhs, rhs length). States without an entry for a lookahead fall back to
+  // default_reduction when they have one.
+  PackedTable(int n_states, const std::vector<char> &terminals,
+              const std::vector<char> &nonterminals,
+              const std::vector<std::pair<char, int>> &prods,
+              const std::map<std::pair<int, char>, std::string> &action,
+              const std::map<std::pair<int, char>, int> &goto_table,
+              const std::map<int, int> &default_reduction = {})
+      : n_(n_states), T_((int)terminals.size()), N_((int)nonterminals.size()),
+        terms_(terminals) {
+    std::fill(std::begin(col_), std::end(col_), -1);
+    for (int t = 0; t < T_; ++t)
+      col_[(unsigned char)terms_[t]] = t;
+    int nt_col[256];
+    std::fill(std::begin(nt_col), std::end(nt_col), -1);
+    for (int n = 0; n < N_; ++n)
+      nt_col[(unsigned char)nonterminals[n]] = n;
+    for (auto &p : prods) {
+      lhs_.push_back(nt_col[(unsigned char)p.first]);
+      len_.push_back(p.second);
+    }
+
+    // unpacked rows: shift = target + 1, accept = -1, reduce p = -p - 2,
+    // error = 0; GOTO = target or -1
+    act_.assign((size_t)n_ * T_, 0);
+    got_.assign((size_t)n_ * N_, -1);
+    for (auto &d : default_reduction)
+      std::fill_n(act_.begin() + (size_t)d.first * T_, T_, -d.second - 2);
+    for (auto &e : action) {
+      int c = col_[(unsigned char)e.first.second];
+      if (c < 0)
+        continue;
+      const std::string &a = e.second;
+      act_[(size_t)e.first.first * T_ + c] = a[0] == 's'   ? std::stoi(a.substr(1)) + 1
+                                             : a[0] == 'r' ? -std::stoi(a.substr(1)) - 2
+                                                           : -1;
+    }
+    for (auto &e : goto_table) {
+      int c = nt_col[(unsigned char)e.first.second];
+      if (c >= 0)
+        got_[(size_t)e.first.first * N_ + c] = e.second;
+    }
+
+    std::vector<int> order(T_), cls(n_);
+    std::iota(order.begin(), order.end(), 0);
+    std::iota(cls.begin(), cls.end(), 0);
+    layout(order, cls, n_, T_ + 1 + N_, false);
+  }
+
+  // Post-pass; profile maps terminal -> observed frequency and may be empty
+  void compress(const std::map<char, long long> &profile) {
+    std::vector<int> order(T_); // new column -> current column
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      auto fa = profile.find(terms_[a]), fb = profile.find(terms_[b]);
+      long long ca = fa == profile.end() ? 0 : fa->second;
+      long long cb = fb == profile.end() ? 0 : fb->second;
+      return ca > cb;
+    });
+
+    // merge states with identical rows until no more rows coincide
+    std::vector<int> cls(n_);
+    std::iota(cls.begin(), cls.end(), 0);
+    int classes = n_;
+    for (;;) {
+      std::map<std::vector<int32_t>, int> seen;
+      std::vector<int> next(n_);
+      for (int s = 0; s < n_; ++s) {
+        std::vector<int32_t> sig;
+        sig.reserve(T_ + N_);
+        for (int t = 0; t < T_; ++t) {
+          int32_t v = act_[(size_t)s * T_ + t];
+          sig.push_back(v > 0 ? cls[v - 1] + 1 : v);
+        }
+        for (int n = 0; n < N_; ++n) {
+          int32_t g = got_[(size_t)s * N_ + n];
+          sig.push_back(g >= 0 ? cls[g] : -1);
+        }
+        next[s] = seen.emplace(std::move(sig), (int)seen.size()).first->second;
+      }
+      bool done = (int)seen.size() == classes;
+      cls = next;
+      classes = (int)seen.size();
+      if (done)
+        break;
+    }
+
+    int width = T_ + 1 + N_, stride = 1;
+    while (stride < width && stride < 32)
+      stride *= 2;
+    if (stride < width)
+      stride = (width + 31) / 32 * 32;
+    layout(order, cls, classes, stride, true);
+  }
+
+  // Input characters to column indices, the end marker appended; characters
+  // that are not terminals, '$' among them, map to the error column
+  std::vector<uint8_t> encode(const std::string &input) const {
+    std::vector<uint8_t> cols;
+    cols.reserve(input.size() + 1);
+    for (char ch : input)
+      cols.push_back(column(ch));
+    cols.push_back(endColumn());
+    return cols;
+  }
+
+  Result parse(const std::vector<uint8_t> &cols, std::vector<int> &stack) const {
+    ArraySource in(cols.data());
+    return parseFrom(in, stack);
+  }
+
+  // Input from any token source with
+  //   uint8_t peek();   // current column
+  //   void advance();   // consume it
+  //   size_t pos();     // tokens consumed so far
+  // The source must end with endColumn(); the driver stops there.
+  template <class Source> Result parseFrom(Source &in, std::vector<int> &stack) const {
+    NoActions none;
+    std::vector<NoActions::Value> values;
+    return dispatch(in, stack, none, values);
+  }
+
+  // Driver that keeps going after syntax errors, calling onError(const
+  // SyntaxError &) once per error. Each error is first tried as a missing
+  // token (phrase level: one terminal is inserted if the offending token can
+  // then be shifted); otherwise input is skipped up to a sync terminal and
+  // states are popped until one whose GOTO on some nonterminal can act on it
+  // (panic mode), and that GOTO is pushed. Every repair either consumes input
+  // or enables a shift, so the pass stays linear in the input. Runs on the
+  // unpacked rows (state numbers), so it works before and after compress().
+  template <class Source, class OnError>
+  Result parseRecovering(Source &in, std::vector<int> &stack, const Recovery &rec,
+                         OnError onError) const {
+    std::vector<char> sync(T_ + 1, rec.sync.empty());
+    for (char c : rec.sync)
+      if (col_[(unsigned char)c] >= 0)
+        sync[col_[(unsigned char)c]] = 1;
+    int eof = col_[(unsigned char)'$'];
+    sync[eof] = 1;
+    sync[T_] = 0;
+
+    Result r;
+    stack.assign(1, 0);
+    size_t insertedAt = (size_t)-1;
+    while (true) {
+      r.depth = std::max(r.depth, stack.size() - 1);
+      int t = in.peek();
+      int v = t < T_ ? act_[(size_t)stack.back() * T_ + t] : 0;
+      if (v < -1) {
+        int p = -v - 2;
+        stack.resize(stack.size() - len_[p]);
+        int g = got_[(size_t)stack.back() * N_ + lhs_[p]];
+        if (g < 0)
+          return r;
+        stack.push_back(g);
+        ++r.steps;
+        continue;
+      }
+      if (v > 0) {
+        stack.push_back(v - 1);
+        in.advance();
+        ++r.steps;
+        continue;
+      }
+      if (v == -1) {
+        r.accepted = r.errors == 0;
+        return r;
+      }
+
+      SyntaxError e;
+      e.pos = in.pos();
+      e.found = t < T_ ? terms_[t] : 0;
+      for (int c = 0; c < T_; ++c)
+        if (act_[(size_t)stack.back() * T_ + c])
+          e.expected += terms_[c];
+      e.repair = SyntaxError::GaveUp;
+
+      // phrase level: a single missing terminal
+      if (t < T_ && insertedAt != e.pos) {
+        for (int x = 0; x < T_ && e.repair == SyntaxError::GaveUp; ++x) {
+          Overlay o(stack, stack.size());
+          if (x == eof || !feed(o, x) || !feed(o, t))
+            continue;
+          Overlay real(stack, stack.size());
+          feed(real, x);
+          real.commit(stack);
+          e.repair = SyntaxError::Inserted;
+          e.inserted = terms_[x];
+          insertedAt = e.pos;
+        }
+      }
+      // panic mode
+      while (e.repair == SyntaxError::GaveUp) {
+        int a = in.peek();
+        if (sync[a]) {
+          for (size_t d = stack.size(); d-- > 0 && e.repair == SyntaxError::GaveUp;) {
+            Overlay o(stack, d + 1);
+            if (feed(o, a)) {
+              e.repair = SyntaxError::Resynced;
+              e.popped = stack.size() - d - 1;
+              stack.resize(d + 1);
+              break;
+            }
+            for (int n = 0; n < N_; ++n) {
+              int g = got_[(size_t)stack[d] * N_ + n];
+              if (g < 0)
+                continue;
+              Overlay og(stack, d + 1);
+              og.push(g);
+              if (feed(og, a)) {
+                e.repair = SyntaxError::Resynced;
+                e.popped = stack.size() - d - 1;
+                stack.resize(d + 1);
+                stack.push_back(g);
+                break;
+              }
+            }
+          }
+        }
+        if (e.repair != SyntaxError::GaveUp || a == eof)
+          break;
+        in.advance();
+        ++e.skipped;
+      }
+      ++r.errors;
+      onError(static_cast<const SyntaxError &>(e));
+      if (e.repair == SyntaxError::GaveUp || r.errors >= rec.maxErrors)
+        return r;
+    }
+  }
+
+  // "found ')', expected one of: i( - inserted 'i'"
+  static std::string describe(const SyntaxError &e) {
+    std::string out = "found ";
+    out += e.found == '$' ? std::string("end of input")
+           : e.found      ? std::string("'") + e.found + "'"
+                          : std::string("a non-terminal character");
+    out += ", expected one of: " + e.expected + " - ";
+    if (e.repair == SyntaxError::Inserted)
+      out += std::string("inserted '") + e.inserted + "'";
+    else if (e.repair == SyntaxError::Resynced)
+      out += "skipped " + std::to_string(e.skipped) + " token(s), popped " +
+             std::to_string(e.popped) + " state(s)";
+    else
+      out += "gave up";
+    return out;
+  }
+
+  // Same loop with semantic actions (see lr_actions.h) and a typed value
+  // stack; on acceptance result holds the start symbol's value
+  template <class Actions>
+  bool parse(const std::vector<uint8_t> &cols, Actions &actions,
+             typename Actions::Value &result) const {
+    std::vector<int> stack;
+    std::vector<typename Actions::Value> values;
+    return parse(cols, actions, result, stack, values);
+  }
+
+  // Reuses the caller's stacks across calls
+  template <class Actions>
+  bool parse(const std::vector<uint8_t> &cols, Actions &actions,
+             typename Actions::Value &result, std::vector<int> &stack,
+             std::vector<typename Actions::Value> &values) const {
+    return translate(cols, actions, result, stack, values).accepted;
+  }
+
+  // The same, returning the driver's Result (steps and all) rather than
+  // only whether the input was accepted
+  template <class Actions>
+  Result translate(const std::vector<uint8_t> &cols, Actions &actions,
+                   typename Actions::Value &result, std::vector<int> &stack,
+                   std::vector<typename Actions::Value> &values) const {
+    ArraySource in(cols.data());
+    Result r = dispatch(in, stack, actions, values);
+    if (r.accepted)
+      result = std::move(values[1]);
+    return r;
+  }
+
+  // Column of an input character; characters that are not terminals map to
+  // the error column. So does '$': the end of input is endColumn(), which a
+  // source appends itself, so no input byte can end the parse early.
+  uint8_t column(char terminal) const {
+    int c = terminal == '$' ? -1 : col_[(unsigned char)terminal];
+    return (uint8_t)(c < 0 ? T_ : c);
+  }
+
+  uint8_t errorColumn() const { return (uint8_t)T_; }
+  uint8_t endColumn() const { return (uint8_t)col_[(unsigned char)'$']; }
+
+  int states() const { return n_; }
+  int rows() const { return rows_; }
+  size_t bytes() const { return narrow_ ? (size_t)rows_ * stride_ * 2 : wide_.size() * 4; }
+  const std::vector<char> &columnOrder() const { return terms_; }
+
+private:
+  // Writes one row per class, terminal columns in `order`; with `offsets`
+  // shift and goto cells hold the target row's offset, not its state number
+  void layout(const std::vector<int> &order, const std::vector<int> &cls, int classes,
+              int stride, bool offsets) {
+    std::vector<char> renamed(T_);
+    std::fill(std::begin(col_), std::end(col_), -1);
+    for (int c = 0; c < T_; ++c) {
+      renamed[c] = terms_[order[c]];
+      col_[(unsigned char)renamed[c]] = c;
+    }
+    terms_ = renamed;
+    std::vector<int32_t> act(act_.size());
+    for (int s = 0; s < n_; ++s)
+      for (int c = 0; c < T_; ++c)
+        act[(size_t)s * T_ + c] = act_[(size_t)s * T_ + order[c]];
+    act_.swap(act);
+
+    auto target = [&](int s) { return offsets ? cls[s] * stride : s; };
+    std::vector<int32_t> cells((size_t)classes * stride, 0);
+    for (int s = 0; s < n_; ++s) {
+      int32_t *row = &cells[(size_t)cls[s] * stride];
+      for (int c = 0; c < T_; ++c) {
+        int32_t v = act_[(size_t)s * T_ + c];
+        row[c] = v > 0 ? target(v - 1) + 1 : v;
+      }
+      for (int n = 0; n < N_; ++n) {
+        int32_t g = got_[(size_t)s * N_ + n];
+        row[T_ + 1 + n] = g >= 0 ? target(g) : -1;
+      }
+    }
+    int32_t lo = 0, hi = 0;
+    for (int32_t v : cells) {
+      lo = std::min(lo, v);
+      hi = std::max(hi, v);
+    }
+
+    rows_ = classes;
+    stride_ = stride;
+    offsets_ = offsets;
+    start_ = target(0);
+    narrow_ = offsets && lo >= INT16_MIN && hi <= INT16_MAX;
+    if (narrow_) {
+      narrowBuf_.assign(cells.size() + 32, 0);
+      narrowOff_ = (64 - (uintptr_t)narrowBuf_.data() % 64) % 64 / sizeof(int16_t);
+      std::copy(cells.begin(), cells.end(), narrowBuf_.begin() + narrowOff_);
+      wide_.clear();
+    } else {
+      wide_ = std::move(cells);
+      narrowBuf_.clear();
+    }
+  }
+
+  // A parse stack seen as stack[0..low) plus states pushed on top, so that
+  // recovery can try a repair without touching the real stack
+  struct Overlay {
+    Overlay(const std::vector<int> &base, size_t low) : base(base), low(low) {}
+    int back() const { return top.empty() ? base[low - 1] : top.back(); }
+    size_t size() const { return low + top.size(); }
+    void push(int s) { top.push_back(s); }
+    void pop(size_t n) {
+      size_t k = std::min(n, top.size());
+      top.resize(top.size() - k);
+      low -= n - k;
+    }
+    void commit(std::vector<int> &stack) const {
+      stack.resize(low);
+      stack.insert(stack.end(), top.begin(), top.end());
+    }
+    const std::vector<int> &base;
+    size_t low;
+    std::vector<int> top;
+  };
+
+  // Runs the reductions lookahead t triggers, then shifts it; false if t is
+  // an error on the way (the overlay is then left part-way)
+  bool feed(Overlay &o, int t) const {
+    for (int guard = 0; guard < 4096; ++guard) {
+      int v = act_[(size_t)o.back() * T_ + t];
+      if (v > 0) {
+        o.push(v - 1);
+        return true;
+      }
+      if (v == -1)
+        return true;
+      if (v == 0)
+        return false;
+      int p = -v - 2;
+      if ((size_t)len_[p] >= o.size())
+        return false;
+      o.pop(len_[p]);
+      int g = got_[(size_t)o.back() * N_ + lhs_[p]];
+      if (g < 0)
+        return false;
+      o.push(g);
+    }
+    return false;
+  }
+
+  struct ArraySource {
+    explicit ArraySource(const uint8_t *p) : begin(p), cur(p) {}
+    uint8_t peek() const { return *cur; }
+    void advance() { ++cur; }
+    size_t pos() const { return cur - begin; }
+    const uint8_t *begin, *cur;
+  };
+
+  template <class Source, class Actions>
+  Result dispatch(Source &in, std::vector<int> &stack, Actions &actions,
+                  std::vector<typename Actions::Value> &values) const {
+    if (!offsets_)
+      return run<int32_t, false>(in, stack, actions, values);
+    return narrow_ ? run<int16_t, true>(in, stack, actions, values)
+                   : run<int32_t, true>(in, stack, actions, values);
+  }
+
+  // With Offsets the stack holds row offsets, otherwise state numbers.
+  // values[i] belongs to stack[i] (values[0], under the start state, is
+  // unused); for NoActions it is never touched.
+  template <class Cell, bool Offsets, class Source, class Actions>
+  Result run(Source &in, std::vector<int> &stack, Actions &actions,
+             std::vector<typename Actions::Value> &values) const {
+    constexpr bool kValues = !std::is_same<Actions, NoActions>::value;
+    const Cell *cells = cellData<Cell>();
+    const size_t stride = stride_, goto_base = T_ + 1;
+    const int *len = len_.data(), *lhs = lhs_.data();
+    Result r;
+    if (stack.size() < 64)
+      stack.resize(64);
+    if (kValues)
+      values.resize(stack.size());
+    int *base = stack.data(), *sp = base;
+    *sp = start_;
+    while (true) {
+      const Cell *row = cells + (Offsets ? (size_t)*sp : *sp * stride);
+      int v = row[in.peek()];
+      typename Actions::Value value;
+      if (v < -1) {
+        int p = -v - 2;
+        if (len[p] > sp - base)
+          return r;
+        sp -= len[p];
+        if constexpr (kValues)
+          value = actions.reduce(
+              p, ValueSpan<typename Actions::Value>(values.data() + (sp - base) + 1, len[p]));
+        row = cells + (Offsets ? (size_t)*sp : *sp * stride);
+        v = row[goto_base + lhs[p]];
+        if (v < 0)
+          return r;
+        ++r.steps;
+      } else if (v > 0) {
+        if constexpr (kValues)
+          value = actions.shift(terms_[in.peek()], in.pos());
+        --v;
+        in.advance();
+        ++r.steps;
+      } else {
+        r.accepted = v == -1;
+        return r;
+      }
+      if (sp + 1 == base + stack.size()) {
+        size_t depth = sp - base;
+        stack.resize(stack.size() * 2);
+        if (kValues)
+          values.resize(stack.size());
+        base = stack.data();
+        sp = base + depth;
+      }
+      *++sp = v;
+      if ((size_t)(sp - base) > r.depth)
+        r.depth = sp - base;
+      if constexpr (kValues)
+        values[sp - base] = std::move(value);
+    }
+  }
+
+  template <class Cell> const Cell *cellData() const;
+
+  int n_, T_, N_;
+  std::vector<char> terms_; // by column
+  int col_[256];            // character -> column, -1 if not a terminal
+  std::vector<int> lhs_, len_;
+  std::vector<int32_t> act_, got_; // unpacked rows, one per state
+
+  std::vector<int32_t> wide_;
+  std::vector<int16_t> narrowBuf_; // over-allocated so the rows can be aligned
+  size_t narrowOff_ = 0;
+  int rows_ = 0, stride_ = 0, start_ = 0;
+  bool offsets_ = false, narrow_ = false;
+};
+
+template <> inline const int32_t *PackedTable::cellData<int32_t>() const { return wide_.data(); }
+template <> inline const int16_t *PackedTable::cellData<int16_t>() const {
+  return narrowBuf_.data() + narrowOff_;
+}
+
+// Average time per token of parsing every input `reps` times
+inline double nsPerToken(const PackedTable &table, const std::vector<std::vector<uint8_t>> &inputs,
+                         int reps) {
+  std::vector<int> stack;
+  long long tokens = 0, sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; ++r)
+    for (auto &in : inputs) {
+      sink += table.parse(in, stack).steps;
+      tokens += (long long)in.size();
+    }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+  return sink >= 0 && tokens > 0 ? ns / tokens : 0;
+}
+
+// Remaining input lines with blanks removed; counts every terminal seen
+// (plus one '$' per input) for --write-profile
+inline std::vector<std::string> readInputs(std::istream &in, std::map<char, long long> &counts) {
+  std::vector<std::string> inputs;
+  std::string line;
+  while (std::getline(in, line)) {
+    line.erase(std::remove_if(line.begin(), line.end(),
+                              [](char c) { return c == ' ' || c == '\t' || c == '\r'; }),
+               line.end());
+    if (line.empty())
+      continue;
+    inputs.push_back(line);
+    for (char c : line)
+      counts[c]++;
+    counts['$']++;
+  }
+  return inputs;
+}
+
+// Checks that the flat and compressed tables agree on every input, then
+// times the parse loop on both; false on a mismatch
+inline bool compareTables(const PackedTable &plain, const PackedTable &packed,
+                          const std::vector<std::string> &inputs, std::ostream &out) {
+  std::vector<std::vector<uint8_t>> plain_in, packed_in;
+  std::vector<int> stack;
+  long long tokens = 0;
+  int accepted = 0;
+  for (auto &in : inputs) {
+    plain_in.push_back(plain.encode(in));
+    packed_in.push_back(packed.encode(in));
+    tokens += (long long)in.size() + 1;
+    PackedTable::Result a = plain.parse(plain_in.back(), stack);
+    PackedTable::Result b = packed.parse(packed_in.back(), stack);
+    if (a.accepted != b.accepted || a.steps != b.steps) {
+      out << "\nTable mismatch on input: " << in << "\n";
+      return false;
+    }
+    accepted += a.accepted;
+  }
+
+  out << "\nTABLE BENCHMARK (" << inputs.size() << " inputs, " << accepted << " accepted, "
+      << tokens << " tokens):\n";
+  out << "Flat table:       " << plain.rows() << " rows, " << plain.bytes() << " bytes\n";
+  out << "Compressed table: " << packed.rows() << " rows, " << packed.bytes() << " bytes\n";
+  out << "Column order:     ";
+  for (char t : packed.columnOrder())
+    out << t;
+  out << "\n";
+
+  int reps = (int)std::max(1LL, 20000000LL / std::max(1LL, tokens));
+  nsPerToken(plain, plain_in, reps); // warm-up
+  double plain_ns = nsPerToken(plain, plain_in, reps);
+  double packed_ns = nsPerToken(packed, packed_in, reps);
+  out << std::fixed << std::setprecision(2);
+  out << "Flat table:       " << plain_ns << " ns/token\n";
+  out << "Compressed table: " << packed_ns << " ns/token (" << std::setprecision(1)
+      << 100.0 * (plain_ns - packed_ns) / plain_ns << "% faster than flat)\n";
+  return true;
+}
+
+// Profile file: one "<terminal> <count>" pair per line
+inline std::map<char, long long> readProfile(const std::string &path) {
+  std::map<char, long long> profile;
+  std::ifstream in(path);
+  char t;
+  long long n;
+  while (in >> t >> n)
+    profile[t] += n;
+  return profile;
+}
+
+inline bool writeProfile(const std::string &path, const std::map<char, long long> &profile) {
+  std::ofstream out(path);
+  for (auto &e : profile)
+    out << e.first << ' ' << e.second << '\n';
+  return (bool)out;
+}
+
+#endif // PACKED_TABLE_H
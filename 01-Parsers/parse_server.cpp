@@ -0,0 +1,660 @@
+// parse_server.cpp
+// Long-running parse server: loads grammars once, keeps their flat SLR(1)
+// tables in memory and answers parse/validate requests over a UNIX domain
+// socket, so callers stop paying process startup and table construction
+// per request. One poll() loop watches the listening socket and every idle
+// connection and hands each complete request frame to a fixed thread pool,
+// so an idle connection never holds a worker; a connection has at most one
+// request in flight, which keeps its responses in order. Every grammar
+// keeps a latency histogram of the requests it served.
+//
+// Protocol (integers in host byte order, one request/response per frame):
+//   frame    = u32 length, then `length` payload bytes
+//   request  = u8 op, u8 name length, grammar name, input characters
+//              op 'V' validate, 'P' parse (also returns the postfix
+//              translation), 'S' statistics (name and input ignored)
+//   response = u8 status, u32 reduction+shift steps, then for 'P' the
+//              translation and for 'S' the statistics text
+//              status 0 accepted, 1 rejected, 2 unknown grammar, 3 bad request
+//
+// Compile: g++ -O2 -pthread parse_server.cpp -o parse_server
+//   ./parse_server --serve SOCKET NAME=GRAMMAR_FILE... [--threads N]
+//   ./parse_server --client SOCKET NAME [--validate]   (inputs on stdin)
+//   ./parse_server --stats SOCKET
+//   ./parse_server --load SOCKET NAME CONNECTIONS REQUESTS   (inputs on stdin)
+//   ./parse_server --check NAME=GRAMMAR_FILE   (inputs on stdin) sends each input
+//     through the request handler as 'V' and 'P', then again with a '$' at every
+//     position, which must be rejected; exits with status 1 on any failure
+// Grammar files use the usual format: a count, then one "E->E+T" per line.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "model_table.h"
+
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+enum Status : uint8_t { kAccepted, kRejected, kUnknownGrammar, kBadRequest };
+
+const uint32_t kMaxFrame = 64u << 20;
+
+// ---------------------------------------------------------------------------
+// Framing
+
+bool readAll(int fd, void *buf, size_t n) {
+  char *p = (char *)buf;
+  while (n > 0) {
+    ssize_t r = ::read(fd, p, n);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      return false;
+    p += r;
+    n -= r;
+  }
+  return true;
+}
+
+bool writeAll(int fd, const void *buf, size_t n) {
+  const char *p = (const char *)buf;
+  while (n > 0) {
+    ssize_t r = ::send(fd, p, n, MSG_NOSIGNAL);
+    if (r < 0 && errno == EINTR)
+      continue;
+    if (r <= 0)
+      return false;
+    p += r;
+    n -= r;
+  }
+  return true;
+}
+
+bool readFrame(int fd, string &payload) {
+  uint32_t len;
+  if (!readAll(fd, &len, 4) || len > kMaxFrame)
+    return false;
+  payload.resize(len);
+  return readAll(fd, &payload[0], len);
+}
+
+bool writeFrame(int fd, const string &payload) {
+  uint32_t len = (uint32_t)payload.size();
+  // one write for small frames keeps request/response to one segment each
+  if (len < 4096) {
+    char buf[4100];
+    memcpy(buf, &len, 4);
+    memcpy(buf + 4, payload.data(), len);
+    return writeAll(fd, buf, len + 4);
+  }
+  return writeAll(fd, &len, 4) && writeAll(fd, payload.data(), len);
+}
+
+// ---------------------------------------------------------------------------
+// Latency histogram: four buckets per power of two of nanoseconds
+
+class LatencyHistogram {
+public:
+  void record(uint64_t ns) {
+    counts_[bucket(ns)].fetch_add(1, memory_order_relaxed);
+    total_.fetch_add(1, memory_order_relaxed);
+    sum_.fetch_add(ns, memory_order_relaxed);
+    uint64_t m = max_.load(memory_order_relaxed);
+    while (ns > m && !max_.compare_exchange_weak(m, ns, memory_order_relaxed))
+      ;
+  }
+
+  uint64_t count() const { return total_.load(memory_order_relaxed); }
+
+  // Upper bound of the bucket holding the q-th quantile
+  uint64_t quantile(double q) const {
+    uint64_t n = count(), seen = 0;
+    if (n == 0)
+      return 0;
+    uint64_t rank = (uint64_t)(q * (n - 1)) + 1;
+    for (int b = 0; b < kBuckets; ++b) {
+      seen += counts_[b].load(memory_order_relaxed);
+      if (seen >= rank)
+        return min(upper(b), max_.load(memory_order_relaxed));
+    }
+    return max_.load(memory_order_relaxed);
+  }
+
+  void print(ostream &out, const string &name) const {
+    uint64_t n = count();
+    out << left << setw(12) << name << right << setw(10) << n;
+    if (n == 0) {
+      out << "\n";
+      return;
+    }
+    auto us = [](uint64_t ns) { return ns / 1000.0; };
+    out << fixed << setprecision(1) << setw(10) << us(sum_.load() / n) << setw(10)
+        << us(quantile(0.5)) << setw(10) << us(quantile(0.9)) << setw(10) << us(quantile(0.99))
+        << setw(10) << us(max_.load()) << "\n";
+  }
+
+  static void printHeader(ostream &out) {
+    out << left << setw(12) << "grammar" << right << setw(10) << "requests" << setw(10)
+        << "mean us" << setw(10) << "p50 us" << setw(10) << "p90 us" << setw(10) << "p99 us"
+        << setw(10) << "max us" << "\n";
+  }
+
+private:
+  static constexpr int kBuckets = 256;
+  static int bucket(uint64_t ns) {
+    if (ns < 4)
+      return (int)ns;
+    int hi = 63 - __builtin_clzll(ns);
+    return min(kBuckets - 1, hi * 4 + (int)((ns >> (hi - 2)) & 3));
+  }
+  static uint64_t upper(int b) {
+    if (b < 4)
+      return b;
+    int hi = b / 4, sub = b % 4;
+    return ((4ULL + sub + 1) << (hi - 2)) - 1;
+  }
+
+  atomic<uint64_t> counts_[kBuckets] = {};
+  atomic<uint64_t> total_{0}, sum_{0}, max_{0};
+};
+
+// ---------------------------------------------------------------------------
+// Server
+
+struct Grammar {
+  string name;
+  int states = 0, conflicts = 0;
+  unique_ptr<PackedTable> table;
+  vector<string> rhs;
+  bool nonterminal[256];
+  LatencyHistogram latency;
+};
+
+class ParseServer {
+public:
+  bool load(const string &name, const string &path) {
+    ifstream in(path);
+    GrammarModel g;
+    if (!in || !readCharGrammar(in, g)) {
+      cerr << "Could not read grammar " << path << "\n";
+      return false;
+    }
+    auto t0 = Clock::now();
+    g.rebuild();
+    auto gr = make_unique<Grammar>();
+    gr->name = name;
+    gr->table = make_unique<PackedTable>(packModel(g));
+    gr->rhs = modelRightSides(g, gr->nonterminal);
+    gr->states = gr->table->states();
+    gr->conflicts = g.conflicts();
+    double ms = chrono::duration<double, milli>(Clock::now() - t0).count();
+    cout << "Loaded " << name << " from " << path << ": " << gr->states << " states, "
+         << gr->conflicts << " conflict(s), table built in " << fixed << setprecision(3) << ms
+         << " ms\n";
+    grammars_[name] = std::move(gr);
+    return true;
+  }
+
+  int serve(const string &path, int threads);
+  int check(const string &name, const vector<string> &inputs);
+
+  string statistics() const {
+    ostringstream out;
+    LatencyHistogram::printHeader(out);
+    for (auto &g : grammars_)
+      g.second->latency.print(out, g.first);
+    return out.str();
+  }
+
+private:
+  // Each worker keeps its own translators, so requests share nothing mutable
+  // except the histograms
+  struct WorkerState {
+    map<const Grammar *, PostfixActions> translators;
+    vector<int> stack;
+    vector<string> values;
+  };
+
+  string handle(const string &req, WorkerState &ws) {
+    string resp(5, '\0');
+    if (req.size() < 2 || req.size() < 2u + (uint8_t)req[1]) {
+      resp[0] = kBadRequest;
+      return resp;
+    }
+    char op = req[0];
+    if (op == 'S') {
+      resp[0] = kAccepted;
+      return resp + statistics();
+    }
+    string name = req.substr(2, (uint8_t)req[1]);
+    auto it = grammars_.find(name);
+    if ((op != 'V' && op != 'P') || it == grammars_.end()) {
+      resp[0] = it == grammars_.end() ? kUnknownGrammar : kBadRequest;
+      return resp;
+    }
+    Grammar &g = *it->second;
+    auto t0 = Clock::now();
+    vector<uint8_t> cols = g.table->encode(req.substr(2 + name.size()));
+    uint32_t steps = 0;
+    bool ok;
+    string translation;
+    if (op == 'V') {
+      PackedTable::Result r = g.table->parse(cols, ws.stack);
+      ok = r.accepted;
+      steps = (uint32_t)r.steps;
+    } else {
+      auto tr = ws.translators.find(&g);
+      if (tr == ws.translators.end())
+        tr = ws.translators.emplace(&g, PostfixActions(g.rhs, g.nonterminal)).first;
+      PackedTable::Result r = g.table->translate(cols, tr->second, translation, ws.stack, ws.values);
+      ok = r.accepted;
+      steps = (uint32_t)r.steps;
+    }
+    g.latency.record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(Clock::now() - t0)
+                         .count());
+    resp[0] = ok ? kAccepted : kRejected;
+    memcpy(&resp[1], &steps, 4);
+    return ok ? resp + translation : resp;
+  }
+
+  // A client connection. The poll loop owns it while it is idle and reads
+  // into `in` until a whole frame is there; the frame then goes to the pool
+  // (busy) and the connection comes back through done_ once the response
+  // has been written.
+  struct Connection {
+    explicit Connection(int fd) : fd(fd) {}
+    int fd;
+    string in;
+    bool busy = false;
+    bool dead = false; // the response could not be written
+  };
+
+  struct Job {
+    Connection *conn;
+    string req;
+  };
+
+  void worker() {
+    WorkerState ws;
+    for (;;) {
+      Job job;
+      {
+        unique_lock<mutex> lock(mu_);
+        cv_.wait(lock, [&] { return stop_ || !jobs_.empty(); });
+        if (jobs_.empty())
+          return;
+        job = std::move(jobs_.front());
+        jobs_.pop_front();
+      }
+      bool ok = writeFrame(job.conn->fd, handle(job.req, ws));
+      {
+        lock_guard<mutex> lock(mu_);
+        job.conn->dead = !ok;
+        done_.push_back(job.conn);
+      }
+      char b = 0;
+      // a full pipe already has the poll loop awake
+      (void)!::write(wake_[1], &b, 1);
+    }
+  }
+
+  // Queues the next buffered frame of an idle connection, if one is
+  // complete; false if the connection sent something that is not a frame
+  bool dispatch(Connection &c) {
+    uint32_t len;
+    if (c.in.size() < 4)
+      return true;
+    memcpy(&len, c.in.data(), 4);
+    if (len > kMaxFrame)
+      return false;
+    if (c.in.size() - 4 < len)
+      return true;
+    Job job{&c, c.in.substr(4, len)};
+    c.in.erase(0, 4 + (size_t)len);
+    c.busy = true;
+    lock_guard<mutex> lock(mu_);
+    jobs_.push_back(std::move(job));
+    cv_.notify_one();
+    return true;
+  }
+
+  // Reads what an idle connection has sent; false once it is closed
+  bool receive(Connection &c) {
+    char buf[65536];
+    for (;;) {
+      ssize_t r = ::recv(c.fd, buf, sizeof buf, MSG_DONTWAIT);
+      if (r < 0 && errno == EINTR)
+        continue;
+      if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        break;
+      if (r <= 0)
+        return false;
+      c.in.append(buf, r);
+      if ((size_t)r < sizeof buf)
+        break;
+    }
+    return dispatch(c);
+  }
+
+  map<string, unique_ptr<Grammar>> grammars_;
+  mutex mu_;
+  condition_variable cv_;
+  deque<Job> jobs_;
+  vector<Connection *> done_; // answered, back to the poll loop
+  bool stop_ = false;
+  int wake_[2] = {-1, -1}; // workers write a byte here after each response
+};
+
+volatile sig_atomic_t g_stop = 0;
+
+int ParseServer::serve(const string &path, int threads) {
+  int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (lfd < 0 || path.size() >= sizeof(addr.sun_path)) {
+    cerr << "Bad socket path " << path << "\n";
+    return 1;
+  }
+  strcpy(addr.sun_path, path.c_str());
+  unlink(path.c_str());
+  if (bind(lfd, (sockaddr *)&addr, sizeof addr) < 0 || listen(lfd, 128) < 0) {
+    cerr << "Could not listen on " << path << ": " << strerror(errno) << "\n";
+    return 1;
+  }
+  if (pipe(wake_) < 0) {
+    cerr << "Could not create wakeup pipe: " << strerror(errno) << "\n";
+    return 1;
+  }
+  for (int fd : wake_)
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  signal(SIGINT, [](int) { g_stop = 1; });
+  signal(SIGTERM, [](int) { g_stop = 1; });
+
+  vector<thread> pool;
+  for (int i = 0; i < threads; ++i)
+    pool.emplace_back([this] { worker(); });
+  cout << "Serving " << grammars_.size() << " grammar(s) on " << path << " with " << threads
+       << " worker thread(s)\n"
+       << flush;
+
+  map<int, unique_ptr<Connection>> conns;
+  auto drop = [&](Connection &c) {
+    int fd = c.fd;
+    ::close(fd);
+    conns.erase(fd);
+  };
+  vector<pollfd> fds;
+  vector<Connection *> answered;
+  while (!g_stop) {
+    fds.assign({{lfd, POLLIN, 0}, {wake_[0], POLLIN, 0}});
+    for (auto &c : conns)
+      if (!c.second->busy)
+        fds.push_back({c.first, POLLIN, 0});
+    if (poll(fds.data(), fds.size(), 200) <= 0)
+      continue;
+
+    if (fds[1].revents) {
+      char buf[256];
+      while (::read(wake_[0], buf, sizeof buf) > 0)
+        ;
+      {
+        lock_guard<mutex> lock(mu_);
+        answered.swap(done_);
+      }
+      // a client may have sent its next request while this one ran
+      for (Connection *c : answered) {
+        c->busy = false;
+        if (c->dead || !dispatch(*c))
+          drop(*c);
+      }
+      answered.clear();
+    }
+    for (size_t i = 2; i < fds.size(); ++i) {
+      if (!fds[i].revents)
+        continue;
+      Connection &c = *conns[fds[i].fd];
+      if (!receive(c))
+        drop(c);
+    }
+    if (fds[0].revents) {
+      int fd = accept(lfd, nullptr, nullptr);
+      if (fd >= 0)
+        conns[fd] = make_unique<Connection>(fd);
+    }
+  }
+
+  {
+    // queued requests are still answered; nothing new is read
+    lock_guard<mutex> lock(mu_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &t : pool)
+    t.join();
+  for (auto &c : conns)
+    ::close(c.first);
+  ::close(wake_[0]);
+  ::close(wake_[1]);
+  ::close(lfd);
+  unlink(path.c_str());
+  cout << "\n" << statistics();
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Client side
+
+int connectTo(const string &path) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof addr) < 0) {
+    cerr << "Could not connect to " << path << ": " << strerror(errno) << "\n";
+    if (fd >= 0)
+      ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+string request(char op, const string &grammar, const string &input) {
+  string req(1, op);
+  req += (char)grammar.size();
+  return req + grammar + input;
+}
+
+vector<string> readLines(istream &in) {
+  vector<string> lines;
+  string line;
+  while (getline(in, line)) {
+    line.erase(remove_if(line.begin(), line.end(), [](char c) { return isspace((unsigned char)c); }),
+               line.end());
+    if (!line.empty())
+      lines.push_back(line);
+  }
+  return lines;
+}
+
+int runClient(const string &path, const string &grammar, bool validate) {
+  int fd = connectTo(path);
+  if (fd < 0)
+    return 1;
+  string resp;
+  for (const string &in : readLines(cin)) {
+    if (!writeFrame(fd, request(validate ? 'V' : 'P', grammar, in)) || !readFrame(fd, resp) ||
+        resp.size() < 5) {
+      cerr << "Connection lost\n";
+      return 1;
+    }
+    static const char *names[] = {"ACCEPTED", "REJECTED", "UNKNOWN GRAMMAR", "BAD REQUEST"};
+    cout << in << ": " << names[min<int>(resp[0], 3)];
+    if (resp[0] == kAccepted && !validate)
+      cout << "  " << resp.substr(5);
+    cout << "\n";
+  }
+  ::close(fd);
+  return 0;
+}
+
+int runStats(const string &path) {
+  int fd = connectTo(path);
+  string resp;
+  if (fd < 0 || !writeFrame(fd, request('S', "", "")) || !readFrame(fd, resp))
+    return 1;
+  cout << resp.substr(5);
+  ::close(fd);
+  return 0;
+}
+
+// CONNECTIONS client threads, each sending REQUESTS validate requests over
+// one persistent connection, cycling through the inputs
+int runLoad(const string &path, const string &grammar, int conns, int requests) {
+  vector<string> inputs = readLines(cin);
+  if (inputs.empty()) {
+    cerr << "No inputs on stdin\n";
+    return 1;
+  }
+  LatencyHistogram rtt;
+  atomic<long long> accepted{0}, failed{0};
+  auto t0 = Clock::now();
+  vector<thread> clients;
+  for (int c = 0; c < conns; ++c)
+    clients.emplace_back([&, c] {
+      int fd = connectTo(path);
+      if (fd < 0) {
+        failed += requests;
+        return;
+      }
+      string resp;
+      for (int i = 0; i < requests; ++i) {
+        const string &in = inputs[(size_t)(c + (long long)i * conns) % inputs.size()];
+        auto s = Clock::now();
+        if (!writeFrame(fd, request('V', grammar, in)) || !readFrame(fd, resp) ||
+            resp.size() < 5) {
+          failed += requests - i;
+          break;
+        }
+        rtt.record(
+            (uint64_t)chrono::duration_cast<chrono::nanoseconds>(Clock::now() - s).count());
+        accepted += resp[0] == kAccepted;
+      }
+      ::close(fd);
+    });
+  for (auto &t : clients)
+    t.join();
+  double secs = chrono::duration<double>(Clock::now() - t0).count();
+
+  cout << "LOAD (" << conns << " connection(s) x " << requests << " requests, "
+       << inputs.size() << " distinct inputs):\n";
+  cout << fixed << setprecision(0) << rtt.count() / secs << " requests/s, " << accepted
+       << " accepted, " << failed << " failed\n\nClient round trip:\n";
+  LatencyHistogram::printHeader(cout);
+  rtt.print(cout, grammar);
+  cout << "\nServer (parse time only):\n";
+  return runStats(path) || failed > 0;
+}
+
+int ParseServer::check(const string &name, const vector<string> &inputs) {
+  WorkerState ws;
+  long long requests = 0, failures = 0;
+  auto status = [&](char op, const string &in) {
+    ++requests;
+    return (uint8_t)handle(request(op, name, in), ws)[0];
+  };
+  for (const string &in : inputs) {
+    uint8_t v = status('V', in), p = status('P', in);
+    if (v != p) {
+      cout << in << ": validate answered " << (int)v << ", parse " << (int)p << "\n";
+      ++failures;
+    }
+    // '$' is the end marker inside the table, never an input terminal
+    for (size_t k = 0; k <= in.size(); ++k) {
+      string bad = in.substr(0, k) + '$' + in.substr(k);
+      for (char op : {'V', 'P'})
+        if (status(op, bad) != kRejected) {
+          cout << bad << ": '" << op << "' request not rejected\n";
+          ++failures;
+        }
+    }
+  }
+  cout << inputs.size() << " input(s), " << requests << " request(s): ";
+  if (failures)
+    cout << failures << " failure(s)\n";
+  else
+    cout << "validate and parse agree, every input with '$' in it is rejected\n";
+  return failures > 0;
+}
+
+int usage(const char *argv0) {
+  cerr << "Usage: " << argv0 << " --serve SOCKET NAME=GRAMMAR_FILE... [--threads N]\n"
+       << "       " << argv0 << " --client SOCKET NAME [--validate]\n"
+       << "       " << argv0 << " --stats SOCKET\n"
+       << "       " << argv0 << " --load SOCKET NAME CONNECTIONS REQUESTS\n"
+       << "       " << argv0 << " --check NAME=GRAMMAR_FILE\n";
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  vector<string> args(argv + 1, argv + argc);
+  if (args.size() < 2)
+    return usage(argv[0]);
+  const string &mode = args[0], &path = args[1];
+
+  if (mode == "--serve") {
+    ParseServer server;
+    int threads = max(2u, thread::hardware_concurrency());
+    for (size_t i = 2; i < args.size(); ++i) {
+      if (args[i] == "--threads" && i + 1 < args.size()) {
+        threads = max(1, atoi(args[++i].c_str()));
+        continue;
+      }
+      size_t eq = args[i].find('=');
+      if (eq == string::npos || eq == 0 || eq > 255)
+        return usage(argv[0]);
+      if (!server.load(args[i].substr(0, eq), args[i].substr(eq + 1)))
+        return 1;
+    }
+    return server.serve(path, threads);
+  }
+  if (mode == "--client" && args.size() >= 3)
+    return runClient(path, args[2], args.size() > 3 && args[3] == "--validate");
+  if (mode == "--stats")
+    return runStats(path);
+  if (mode == "--check" && args.size() == 2) {
+    ParseServer server;
+    size_t eq = path.find('=');
+    if (eq == string::npos || eq == 0 || eq > 255)
+      return usage(argv[0]);
+    string name = path.substr(0, eq);
+    if (!server.load(name, path.substr(eq + 1)))
+      return 1;
+    return server.check(name, readLines(cin));
+  }
+  if (mode == "--load" && args.size() == 5)
+    return runLoad(path, args[2], atoi(args[3].c_str()), atoi(args[4].c_str()));
+  return usage(argv[0]);
+}
@@ -0,0 +1,170 @@
+// parse_tree.h
+// Parse trees for the LR drivers. Nodes and child lists are bump-allocated
+// from paged arenas and referred to by 32-bit handles, so a node fits in 16
+// bytes and a whole tree is freed with one release() call (or when the tree
+// goes out of scope). Children of a reduction are the top entries of the
+// driver's node stack; their ids are copied into one contiguous span.
+#ifndef PARSE_TREE_H
+#define PARSE_TREE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Typed bump allocator over fixed-size pages. A handle is (page << PageBits |
+// slot); allocate(n) never splits a span across pages, so span(h) is
+// contiguous. Elements are never destroyed one by one.
+template <class T, unsigned PageBits = 14> class BumpArena {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "arena elements are released without running destructors");
+
+public:
+  static constexpr uint32_t kPageSize = 1u << PageBits;
+
+  BumpArena() = default;
+  BumpArena(const BumpArena &) = delete;
+  BumpArena &operator=(const BumpArena &) = delete;
+  BumpArena(BumpArena &&other) noexcept { *this = std::move(other); }
+  BumpArena &operator=(BumpArena &&other) noexcept {
+    if (this != &other) {
+      release();
+      pages_ = std::move(other.pages_);
+      used_ = other.used_;
+      count_ = other.count_;
+      other.pages_.clear();
+      other.used_ = kPageSize;
+      other.count_ = 0;
+    }
+    return *this;
+  }
+  ~BumpArena() { release(); }
+
+  uint32_t allocate(uint32_t n) {
+    if (used_ + n > kPageSize) {
+      T *page = static_cast<T *>(std::malloc(sizeof(T) * kPageSize));
+      if (!page)
+        throw std::bad_alloc();
+      pages_.push_back(page);
+      used_ = 0;
+    }
+    uint32_t h = (uint32_t)(pages_.size() - 1) << PageBits | used_;
+    used_ += n;
+    count_ += n;
+    return h;
+  }
+
+  T &operator[](uint32_t h) { return pages_[h >> PageBits][h & (kPageSize - 1)]; }
+  const T &operator[](uint32_t h) const {
+    return pages_[h >> PageBits][h & (kPageSize - 1)];
+  }
+  T *span(uint32_t h) { return &(*this)[h]; }
+  const T *span(uint32_t h) const { return &(*this)[h]; }
+
+  size_t size() const { return count_; }
+  size_t bytes() const { return pages_.size() * kPageSize * sizeof(T); }
+
+  void release() {
+    for (T *page : pages_)
+      std::free(page);
+    pages_.clear();
+    used_ = kPageSize;
+    count_ = 0;
+  }
+
+private:
+  std::vector<T *> pages_;
+  uint32_t used_ = kPageSize; // slots taken in the last page
+  size_t count_ = 0;
+};
+
+struct ParseNode {
+  uint16_t prod;      // production number, or ParseTree::kLeaf for a token
+  uint16_t nkids;     // children, in left-to-right order
+  uint32_t kids;      // handle of the first child id in ParseTree's kid arena
+  uint32_t tok_begin; // input tokens covered: [tok_begin, tok_end)
+  uint32_t tok_end;
+};
+static_assert(sizeof(ParseNode) <= 16, "ParseNode should stay within 16 bytes");
+
+class ParseTree {
+public:
+  static constexpr uint16_t kLeaf = 0xFFFF;
+  static constexpr uint32_t kNone = 0xFFFFFFFF;
+
+  uint32_t leaf(uint32_t tok) {
+    uint32_t id = nodes_.allocate(1);
+    nodes_[id] = ParseNode{kLeaf, 0, kNone, tok, tok + 1};
+    return id;
+  }
+
+  // Node for production prod whose children are the last n ids of stack; the
+  // ids are popped and the new node's id is returned (not pushed). pos is the
+  // current input position, used as the empty range of an epsilon reduction.
+  uint32_t reduce(int prod, std::vector<uint32_t> &stack, int n, uint32_t pos) {
+    uint32_t id = nodes_.allocate(1);
+    uint32_t kids = kNone, begin = pos, end = pos;
+    if (n > 0) {
+      kids = kids_.allocate(n);
+      uint32_t *out = kids_.span(kids);
+      const uint32_t *in = stack.data() + stack.size() - n;
+      for (int i = 0; i < n; ++i)
+        out[i] = in[i];
+      begin = nodes_[in[0]].tok_begin;
+      end = nodes_[in[n - 1]].tok_end;
+      stack.resize(stack.size() - n);
+    }
+    nodes_[id] = ParseNode{(uint16_t)prod, (uint16_t)n, kids, begin, end};
+    return id;
+  }
+
+  void setRoot(uint32_t id) { root_ = id; }
+  uint32_t root() const { return root_; }
+  bool empty() const { return root_ == kNone; }
+
+  const ParseNode &node(uint32_t id) const { return nodes_[id]; }
+  uint32_t child(uint32_t id, int i) const { return kids_[nodes_[id].kids + i]; }
+
+  size_t size() const { return nodes_.size(); }
+  size_t bytes() const { return nodes_.bytes() + kids_.bytes(); }
+
+  // Frees every node at once
+  void release() {
+    nodes_.release();
+    kids_.release();
+    root_ = kNone;
+  }
+
+  // Indented dump; label(prod) names an interior node, leaves show their
+  // token from input
+  template <class Label>
+  void print(std::ostream &out, const std::string &input, Label label) const {
+    if (!empty())
+      print(out, input, label, root_, 0);
+  }
+
+private:
+  template <class Label>
+  void print(std::ostream &out, const std::string &input, Label label, uint32_t id,
+             int depth) const {
+    const ParseNode &n = nodes_[id];
+    out << std::string(2 * depth, ' ');
+    if (n.prod == kLeaf) {
+      out << input[n.tok_begin] << "\n";
+      return;
+    }
+    out << label(n.prod) << "  [" << n.tok_begin << ", " << n.tok_end << ")\n";
+    for (int i = 0; i < n.nkids; ++i)
+      print(out, input, label, child(id, i), depth + 1);
+  }
+
+  BumpArena<ParseNode> nodes_;
+  BumpArena<uint32_t> kids_;
+  uint32_t root_ = kNone;
+};
+
+#endif
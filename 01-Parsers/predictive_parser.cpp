@@ -26,6 +26,17 @@ typedef struct {
     char start_symbol;
 } PredictiveParser;
 
+// Error recovery: with max_errors > 0 the parser keeps going after an
+// error instead of stopping (panic mode). A table entry "synch", or an input
+// token listed in sync_tokens, pops the nonterminal; any other blank entry
+// skips the input token, as does a sync entry for the start symbol alone on
+// the stack. A terminal mismatch pops the terminal, as if it had been
+// inserted. Errors in one run of repairs are counted once.
+typedef struct {
+    int max_errors;             // 0: stop at the first error
+    char sync_tokens[MAX_LEN];  // synchronizing terminals for every nonterminal
+} Recovery;
+
 // Stack implementation
 typedef struct {
     char items[100];
@@ -87,7 +98,15 @@ void display_table(PredictiveParser *p) {
     }
 }
 
-void parse_string(PredictiveParser *p, char *input) {
+// Reports one error; returns 1 once the cap is reached
+int report_error(const Recovery *rec, int *errors, int *recovering) {
+    if (!*recovering)
+        (*errors)++;
+    *recovering = 1;
+    return *errors >= rec->max_errors;
+}
+
+void parse_string(PredictiveParser *p, char *input, const Recovery *rec) {
     Stack stack;
     stack.top = -1;
     push(&stack, '$');
@@ -101,6 +120,7 @@ void parse_string(PredictiveParser *p, char *input) {
     printf("---------------------------------------------------------------\n");
 
     int step = 1;
+    int errors = 0, recovering = 0;
     while (stack.top >= 0) {
         char top = peek(&stack);
         char curr = input[ip];
@@ -115,16 +135,40 @@ void parse_string(PredictiveParser *p, char *input) {
             if (top == curr) {
                 pop(&stack);
                 ip++;
+                recovering = 0;
                 printf(" Match & advance (%c)\n", curr);
                 if (top == '$')
                     break;
-            } else {
+            } else if (rec->max_errors == 0) {
                 printf(" Error: Terminal mismatch (%c != %c)\n", top, curr);
                 return;
+            } else if (top == '$') {
+                printf(" Error: Extra input, skipped %c\n", curr);
+                ip++;
+                if (report_error(rec, &errors, &recovering))
+                    break;
+            } else {
+                printf(" Error: Missing %c, inserted\n", top);
+                pop(&stack);
+                if (report_error(rec, &errors, &recovering))
+                    break;
             }
         } else if (is_non_terminal(p, top)) {
             char *prod = get_production(p, top, curr);
-            if (prod) {
+            int synch = prod && strcmp(prod, "synch") == 0;
+            if (rec->max_errors > 0 && (!prod || synch)) {
+                // popping the only nonterminal left would end the parse early
+                int last = stack.top == 1 && curr != '$';
+                if (!last && (synch || curr == '$' || strchr(rec->sync_tokens, curr))) {
+                    printf(" Error: No production for %c,%c - popped %c\n", top, curr, top);
+                    pop(&stack);
+                } else {
+                    printf(" Error: No production for %c,%c - skipped %c\n", top, curr, curr);
+                    ip++;
+                }
+                if (report_error(rec, &errors, &recovering))
+                    break;
+            } else if (prod && !synch) {
                 pop(&stack);
                 printf(" Expand %c->%s\n", top, prod);
                 if (strcmp(prod, "e") != 0) {
@@ -141,13 +185,30 @@ void parse_string(PredictiveParser *p, char *input) {
         }
     }
 
-    if (input[ip] == '$' && stack.top == -1)
+    if (input[ip] == '$' && stack.top == -1 && errors == 0)
         printf("\n*** STRING ACCEPTED ***\n");
+    else if (errors > 0)
+        printf("\n*** STRING REJECTED: %d error(s)%s ***\n", errors,
+               errors >= rec->max_errors ? ", --max-errors reached" : "");
     else
         printf("\n*** STRING REJECTED ***\n");
 }
 
-int main() {
+int main(int argc, char **argv) {
+    Recovery rec = {0, ""};
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-errors") == 0 && i + 1 < argc) {
+            rec.max_errors = atoi(argv[++i]);
+            if (rec.max_errors < 1)
+                rec.max_errors = 1;
+        } else if (strcmp(argv[i], "--sync") == 0 && i + 1 < argc) {
+            strncpy(rec.sync_tokens, argv[++i], MAX_LEN - 1);
+        } else {
+            printf("Usage: %s [--max-errors N [--sync TOKENS]]\n", argv[0]);
+            return 1;
+        }
+    }
+
     PredictiveParser parser;
     parser.terminal_count = 0;
     parser.non_terminal_count = 0;
@@ -174,7 +235,7 @@ int main() {
 
     // Input parse table
     printf("\n=== Enter Parse Table Entries ===\n");
-    printf("Format: row col production (use e for epsilon)\n");
+    printf("Format: row col production (use e for epsilon, synch for a sync entry)\n");
     printf("Type END to stop\n");
 
     while (1) {
@@ -199,7 +260,7 @@ int main() {
         scanf("%s", input);
         if (strcmp(input, "EXIT") == 0)
             break;
-        parse_string(&parser, input);
+        parse_string(&parser, input, &rec);
         printf("\n----------------------------------------------\n");
     }
 
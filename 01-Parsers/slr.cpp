@@ -7,6 +7,8 @@
 #include <string>
 #include <vector>
 
+#include "packed_table.h"
+
 using namespace std;
 
 struct Production {
@@ -44,6 +46,12 @@ private:
   map<pair<int, char>, int> goto_table;
   map<pair<int, char>, string> action_table;
 
+  // "e" is the empty right side: its items are complete at dot 0
+  int rhsLength(int prod_num) const {
+    const string &right = productions[prod_num].right;
+    return right == "e" ? 0 : (int)right.length();
+  }
+
   void computeFirstSets() {
     bool changed = true;
     while (changed) {
@@ -133,7 +141,7 @@ private:
       set<LRItem> new_items = items;
 
       for (const auto &item : items) {
-        if (item.dot_pos < productions[item.prod_num].right.length()) {
+        if (item.dot_pos < rhsLength(item.prod_num)) {
           char next = productions[item.prod_num].right[item.dot_pos];
           if (non_terminals.count(next)) {
             for (int i = 0; i < productions.size(); i++) {
@@ -156,7 +164,7 @@ private:
   set<LRItem> goTo(set<LRItem> state, char symbol) {
     set<LRItem> result;
     for (const auto &item : state) {
-      if (item.dot_pos < productions[item.prod_num].right.length() &&
+      if (item.dot_pos < rhsLength(item.prod_num) &&
           productions[item.prod_num].right[item.dot_pos] == symbol) {
         result.insert(LRItem(item.prod_num, item.dot_pos + 1));
       }
@@ -175,7 +183,7 @@ private:
 
       // Collect all symbols after dots
       for (const auto &item : states[i]) {
-        if (item.dot_pos < productions[item.prod_num].right.length()) {
+        if (item.dot_pos < rhsLength(item.prod_num)) {
           symbols.insert(productions[item.prod_num].right[item.dot_pos]);
         }
       }
@@ -203,13 +211,26 @@ private:
     }
   }
 
+  // Production 0 is the augmented S' -> S, added by buildParseTable()
+  void augmentGrammar() {
+    char start = productions[0].left;
+    char aug = 'Z';
+    for (char c : string("S'@#~`&")) {
+      if (!non_terminals.count(c) && !terminals.count(c) && c != '$') {
+        aug = c;
+        break;
+      }
+    }
+    productions.insert(productions.begin(), Production(aug, string(1, start)));
+    non_terminals.insert(aug);
+  }
+
   void constructParseTable() {
     for (int i = 0; i < states.size(); i++) {
       for (const auto &item : states[i]) {
         // Reduce items
-        if (item.dot_pos == productions[item.prod_num].right.length()) {
-          if (item.prod_num == 0 &&
-              productions[0].left == productions[0].left) { // Accept
+        if (item.dot_pos == rhsLength(item.prod_num)) {
+          if (item.prod_num == 0) { // Accept
             action_table[{i, '$'}] = "accept";
           } else {
             for (char a : follow_sets[productions[item.prod_num].left]) {
@@ -234,21 +255,37 @@ public:
   void addProduction(char left, string right) {
     productions.push_back(Production(left, right));
     non_terminals.insert(left);
-
-    for (char c : right) {
-      if (c != 'e' && !non_terminals.count(c)) {
-        terminals.insert(c);
-      }
-    }
   }
 
   void buildParseTable() {
+    // a symbol is a terminal only if no production defines it, which is
+    // known once every production has been read
+    for (const auto &prod : productions) {
+      for (char c : prod.right) {
+        if (c != 'e' && !non_terminals.count(c)) {
+          terminals.insert(c);
+        }
+      }
+    }
+    augmentGrammar();
     computeFirstSets();
     computeFollowSets();
     constructStates();
     constructParseTable();
   }
 
+  // Flat copy of ACTION/GOTO for the runtime parse loop
+  PackedTable pack() const {
+    vector<char> terms(terminals.begin(), terminals.end());
+    terms.push_back('$');
+    vector<char> nts(non_terminals.begin(), non_terminals.end());
+    vector<pair<char, int>> prods;
+    for (const auto &p : productions)
+      prods.push_back({p.left, p.right == "e" ? 0 : (int)p.right.size()});
+    return PackedTable((int)states.size(), terms, nts, prods, action_table,
+                       goto_table);
+  }
+
   void printFirstSets() {
     cout << "\nFIRST SETS:\n";
     cout << "============\n";
@@ -371,7 +408,24 @@ public:
   }
 };
 
-int main() {
+int main(int argc, char **argv) {
+  bool bench_table = false;
+  string profile_in, profile_out;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "--bench-table") {
+      bench_table = true;
+    } else if (arg == "--profile" && i + 1 < argc) {
+      profile_in = argv[++i];
+    } else if (arg == "--write-profile" && i + 1 < argc) {
+      profile_out = argv[++i];
+    } else {
+      cerr << "Usage: " << argv[0]
+           << " [--bench-table [--profile FILE] [--write-profile FILE]]\n";
+      return 1;
+    }
+  }
+
   SLRParser parser;
 
   int num_productions;
@@ -407,5 +461,22 @@ int main() {
   //  parser.printStates();
   parser.printParseTable();
 
+  if (bench_table) {
+    // remaining lines are inputs for the flat vs. compressed table benchmark
+    map<char, long long> counts;
+    vector<string> inputs = readInputs(cin, counts);
+    if (inputs.empty()) {
+      cout << "\nNo inputs to benchmark.\n";
+      return 1;
+    }
+    if (!profile_out.empty() && writeProfile(profile_out, counts))
+      cout << "\nWrote terminal profile to " << profile_out << "\n";
+    PackedTable plain = parser.pack();
+    PackedTable packed = parser.pack();
+    packed.compress(profile_in.empty() ? map<char, long long>()
+                                       : readProfile(profile_in));
+    return compareTables(plain, packed, inputs, cout) ? 0 : 1;
+  }
+
   return 0;
 }
@@ -1,5 +1,6 @@
 // FOLLOW set calculator for context-free grammars. Compile: g++ ex4.cpp -o ex4 && ./ex4
 #include <bits/stdc++.h>
+#include "packed_table.h"
 using namespace std;
 
 struct Production {
@@ -7,16 +8,30 @@ struct Production {
     string right;
 };
 
+// An LR(0) item is identified by (production index, dot position) only;
+// the production text is looked up in `grammar` when needed.
 struct Item {
-    string left;
-    string right;
+    int prod;
     int dotPos;
 };
 
 bool operator==(const Item& a, const Item& b) {
-    return a.left == b.left && a.right == b.right && a.dotPos == b.dotPos;
+    return a.prod == b.prod && a.dotPos == b.dotPos;
+}
+
+bool operator<(const Item& a, const Item& b) {
+    return a.prod != b.prod ? a.prod < b.prod : a.dotPos < b.dotPos;
 }
 
+// Hash of a sorted kernel, used to find an existing state in O(|kernel|)
+struct KernelHash {
+    size_t operator()(const vector<Item>& k) const {
+        size_t h = k.size();
+        for (auto& it : k) h = h * 1000003u ^ (((size_t)it.prod << 16) | (size_t)it.dotPos);
+        return h;
+    }
+};
+
 bool isNonTerminal(char c) {
     return (c >= 'A' && c <= 'Z');
 }
@@ -27,6 +42,8 @@ map<string, set<char>> FOLLOW;
 map<int, map<char, string>> ACTION;
 map<int, map<char, int>> GOTO;
 vector<vector<Item>> states;
+vector<vector<pair<char, int>>> transitions;   // per state: (symbol, target state)
+vector<int> prodsOf[128];                       // nonterminal -> its production indices
 
 // Helper: print set<char> nicely
 string setToString(const set<char>& s) {
@@ -42,97 +59,71 @@ string setToString(const set<char>& s) {
     return out;
 }
 
-// -------------------------
-// Compute closure(I)
-// -------------------------
-vector<Item> closure(vector<Item> I) {
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        vector<Item> newItems = I;
-        for (auto& item : I) {
-            if (item.dotPos < (int)item.right.size()) {
-                char next = item.right[item.dotPos];
-                if (isNonTerminal(next)) {
-                    for (auto& prod : grammar) {
-                        if (prod.left.size() > 0 && prod.left[0] == next) {
-                            Item newItem = {prod.left, prod.right, 0};
-                            if (find(newItems.begin(), newItems.end(), newItem) == newItems.end()) {
-                                newItems.push_back(newItem);
-                                changed = true;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        I = newItems;
-    }
-    return I;
+// Symbol after the dot, or 0 if the item is complete
+char nextSymbol(const Item& item) {
+    const string& rhs = grammar[item.prod].right;
+    return item.dotPos < (int)rhs.size() ? rhs[item.dotPos] : 0;
 }
 
 // -------------------------
-// GOTO(I, X)
+// Compute closure(I): worklist over I, each nonterminal expanded once
 // -------------------------
-vector<Item> GOTO_func(const vector<Item>& I, char X) {
-    vector<Item> J;
-    for (auto& item : I) {
-        if (item.dotPos < (int)item.right.size() && item.right[item.dotPos] == X) {
-            J.push_back({item.left, item.right, item.dotPos + 1});
-        }
-    }
-    return closure(J);
-}
-
-// Compare two item sets
-bool sameItemSet(const vector<Item>& a, const vector<Item>& b) {
-    if (a.size() != b.size()) return false;
-    for (auto& it : a) {
-        if (find(b.begin(), b.end(), it) == b.end()) return false;
-    }
-    return true;
-}
-
-// find state index equal to set, or -1
-int findState(const vector<Item>& s) {
-    for (int i = 0; i < (int)states.size(); ++i) {
-        if (sameItemSet(states[i], s)) return i;
+vector<Item> closure(vector<Item> I) {
+    bool expanded[128] = {false};
+    for (size_t k = 0; k < I.size(); ++k) {
+        char next = nextSymbol(I[k]);
+        if (!isNonTerminal(next) || expanded[(int)next]) continue;
+        expanded[(int)next] = true;
+        for (int p : prodsOf[(int)next]) I.push_back({p, 0});
     }
-    return -1;
+    return I;
 }
 
 // -------------------------
 // Build canonical collection of LR(0) items
 // -------------------------
 void build_LR0_items(const string& startSym) {
-    // start item is the augmented production at grammar[0]
-    vector<Item> start = { {grammar[0].left, grammar[0].right, 0} };
-    start = closure(start);
+    // index productions by left-hand side; the augmented S' -> S (grammar[0])
+    // never appears after a dot, so it stays out of the index
+    for (auto& v : prodsOf) v.clear();
+    for (int p = 1; p < (int)grammar.size(); ++p) {
+        prodsOf[(unsigned char)grammar[p].left[0]].push_back(p);
+    }
+
+    unordered_map<vector<Item>, int, KernelHash> kernelIndex;
+    vector<Item> startKernel = { {0, 0} };
+    kernelIndex[startKernel] = 0;
     states.clear();
-    states.push_back(start);
-
-    bool added = true;
-    while (added) {
-        added = false;
-        int n = states.size();
-        for (int i = 0; i < n; i++) {
-            // try all ASCII symbols that might appear: terminals and nonterminals are discovered from grammar
-            // We'll attempt A..Z and common punctuation/identifiers to ensure completeness
-            for (char X = 'A'; X <= 'Z'; X++) {
-                vector<Item> g = GOTO_func(states[i], X);
-                if (!g.empty() && findState(g) == -1) {
-                    states.push_back(g);
-                    added = true;
-                }
-            }
-            string terminals = "+-*()/i$";
-            for (char X : terminals) {
-                vector<Item> g = GOTO_func(states[i], X);
-                if (!g.empty() && findState(g) == -1) {
-                    states.push_back(g);
-                    added = true;
-                }
+    transitions.clear();
+    states.push_back(closure(startKernel));
+    transitions.emplace_back();
+
+    // single pass: each state is expanded once, in creation order, and only
+    // on the symbols that actually appear after a dot
+    for (size_t i = 0; i < states.size(); ++i) {
+        vector<char> order;
+        map<char, vector<Item>> kernels;
+        for (auto& item : states[i]) {
+            char X = nextSymbol(item);
+            if (!X) continue;
+            auto& k = kernels[X];
+            if (k.empty()) order.push_back(X);
+            k.push_back({item.prod, item.dotPos + 1});
+        }
+        for (char X : order) {
+            vector<Item>& kernel = kernels[X];
+            sort(kernel.begin(), kernel.end());
+            auto found = kernelIndex.find(kernel);
+            int target;
+            if (found == kernelIndex.end()) {
+                target = (int)states.size();
+                kernelIndex.emplace(kernel, target);
+                states.push_back(closure(kernel));
+                transitions.emplace_back();
+            } else {
+                target = found->second;
             }
+            transitions[i].push_back({X, target});
         }
     }
 }
@@ -260,31 +251,29 @@ void build_SLR_table() {
     GOTO.clear();
     int numStates = states.size();
     for (int i = 0; i < numStates; i++) {
+        // shifts and gotos come straight from the transitions recorded
+        // while the collection was built
+        for (auto& tr : transitions[i]) {
+            char a = tr.first;
+            if (!isNonTerminal(a)) {
+                ACTION[i][a] = "s" + to_string(tr.second);
+            } else {
+                GOTO[i][a] = tr.second;
+            }
+        }
         for (auto& item : states[i]) {
-            // if item is A -> α . a β
-            if (item.dotPos < (int)item.right.size()) {
-                char a = item.right[item.dotPos];
-                vector<Item> g = GOTO_func(states[i], a);
-                int j = findState(g);
-                if (j != -1) {
-                    if (!isNonTerminal(a)) {
-                        ACTION[i][a] = "s" + to_string(j);
-                    } else {
-                        GOTO[i][a] = j;
-                    }
-                }
+            if (nextSymbol(item)) continue;
+            // item is A -> α .
+            const Production& p = grammar[item.prod];
+            if (item.prod == 0) { // augmented start: S' -> S .
+                ACTION[i]['$'] = "acc";
             } else {
-                // item is A -> α .
-                if (item.left == grammar[0].left) { // augmented start: S' -> S .
-                    ACTION[i]['$'] = "acc";
-                } else {
-                    // reduce by A->α for all a in FOLLOW(A)
-                    string rhs = item.right.empty() ? "ε" : item.right;
-                    string red = "r(" + item.left + "->" + rhs + ")";
-                    for (char a : FOLLOW[item.left]) {
-                        // if conflict occurs, this simple implementation overwrites; SLR may have conflicts for some grammars
-                        ACTION[i][a] = red;
-                    }
+                // reduce by A->α for all a in FOLLOW(A)
+                string rhs = p.right.empty() ? "ε" : p.right;
+                string red = "r(" + p.left + "->" + rhs + ")";
+                for (char a : FOLLOW[p.left]) {
+                    // if conflict occurs, this simple implementation overwrites; SLR may have conflicts for some grammars
+                    ACTION[i][a] = red;
                 }
             }
         }
@@ -362,6 +351,46 @@ void parseString(string input) {
     }
 }
 
+// -------------------------
+// Flat table + postfix translation through PackedTable::parse<Actions>
+// -------------------------
+PackedTable packTable() {
+    set<char> terms, nts;
+    vector<pair<char, int>> prods;
+    for (auto& p : grammar) {
+        prods.push_back({p.left[0], (int)p.right.size()});
+        nts.insert(p.left[0]);
+        for (char c : p.right) if (!isNonTerminal(c)) terms.insert(c);
+    }
+    // ACTION cells name the production as "r(A->alpha)"; PackedTable wants "rN"
+    map<pair<int, char>, string> action;
+    map<pair<int, char>, int> gotoTable;
+    for (auto& row : ACTION) for (auto& cell : row.second) {
+        string a = cell.second;
+        if (a[0] == 'r') {
+            for (int p = 1; p < (int)grammar.size(); ++p) {
+                string rhsText = grammar[p].right.empty() ? "ε" : grammar[p].right;
+                if (a == "r(" + grammar[p].left + "->" + rhsText + ")") { a = "r" + to_string(p); break; }
+            }
+        }
+        action[{row.first, cell.first}] = a;
+    }
+    for (auto& row : GOTO) for (auto& cell : row.second) gotoTable[{row.first, cell.first}] = cell.second;
+    vector<char> t(terms.begin(), terms.end()), n(nts.begin(), nts.end());
+    t.push_back('$');
+    return PackedTable((int)states.size(), t, n, prods, action, gotoTable);
+}
+
+void printPostfix(const string& input) {
+    PackedTable table = packTable();
+    vector<string> rhs;
+    bool nt[256] = {false};
+    for (auto& p : grammar) { rhs.push_back(p.right); nt[(unsigned char)p.left[0]] = true; }
+    PostfixActions translate(rhs, nt);
+    string out;
+    if (table.parse(table.encode(input), translate, out)) cout << "Postfix translation: " << out << "\n";
+}
+
 int main() {
     cout << "Enter number of productions: ";
     int n; cin >> n;
@@ -461,12 +490,13 @@ int main() {
     for (int i = 0; i < (int)states.size(); ++i) {
         cout << "I" << i << ":\n";
         for (auto &it : states[i]) {
-            cout << "  " << it.left << " -> ";
-            for (int k = 0; k < (int)it.right.size(); ++k) {
+            const Production& p = grammar[it.prod];
+            cout << "  " << p.left << " -> ";
+            for (int k = 0; k < (int)p.right.size(); ++k) {
                 if (k == it.dotPos) cout << ".";
-                cout << it.right[k];
+                cout << p.right[k];
             }
-            if (it.dotPos == (int)it.right.size()) cout << ".";
+            if (it.dotPos == (int)p.right.size()) cout << ".";
             cout << "\n";
         }
     }
@@ -476,5 +506,6 @@ int main() {
     cin >> input;
 
     parseString(input);
+    printPostfix(input);
     return 0;
 }
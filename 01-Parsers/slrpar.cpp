@@ -1,14 +1,21 @@
 // SLR parser with string parsing: builds SLR table and parses input strings. Compile: g++ slrpar.cpp -o slrpar && ./slrpar
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <random>
 #include <set>
 #include <sstream>
 #include <stack>
 #include <string>
 #include <vector>
 
+#include "packed_table.h"
+#include "parse_tree.h"
+
 using namespace std;
 
 struct Production {
@@ -186,7 +193,10 @@ public:
     }
   }
 
-  bool parse(string input) {
+  // With tree set, also builds the parse tree: each shift adds a leaf, each
+  // reduction a node over the popped children, and the node left on the
+  // stack at accept becomes the root. trace = false skips all printing.
+  bool parse(string input, ParseTree *tree = nullptr, bool trace = true) {
     // Add $ to end of input if not present
     if (input.empty() || input.back() != '$') {
       input += '$';
@@ -194,73 +204,90 @@ public:
 
     stack<int> state_stack;
     stack<char> symbol_stack;
+    vector<uint32_t> node_stack;
 
     state_stack.push(0); // Initial state
 
     int input_index = 0;
     int step = 1;
 
-    cout << "\nPARSING TRACE:\n";
-    cout << "===============\n";
-    cout << setw(4) << "Step" << setw(15) << "State Stack" << setw(15)
-         << "Symbol Stack" << setw(20) << "Input" << setw(25) << "Action"
-         << "\n";
-    cout << string(79, '-') << "\n";
+    if (trace) {
+      cout << "\nPARSING TRACE:\n";
+      cout << "===============\n";
+      cout << setw(4) << "Step" << setw(15) << "State Stack" << setw(15)
+           << "Symbol Stack" << setw(20) << "Input" << setw(25) << "Action"
+           << "\n";
+      cout << string(79, '-') << "\n";
+    }
 
     while (input_index < input.length()) {
       if (state_stack.empty()) {
-        cout << "\nPARSE ERROR: State stack is empty\n";
+        if (trace)
+          cout << "\nPARSE ERROR: State stack is empty\n";
         return false;
       }
 
       int current_state = state_stack.top();
       char current_input = input[input_index];
 
-      string remaining_input = input.substr(input_index);
+      string remaining_input = trace ? input.substr(input_index) : string();
 
       // Look up action in parse table
-      if (action_table.find({current_state, current_input}) ==
-          action_table.end()) {
-        printStep(step, state_stack, symbol_stack, remaining_input,
-                  "ERROR - No action");
-        cout << "\nPARSE ERROR: No action for state " << current_state
-             << " and symbol '" << current_input << "'\n";
+      auto entry = action_table.find({current_state, current_input});
+      if (entry == action_table.end()) {
+        if (trace) {
+          printStep(step, state_stack, symbol_stack, remaining_input,
+                    "ERROR - No action");
+          cout << "\nPARSE ERROR: No action for state " << current_state
+               << " and symbol '" << current_input << "'\n";
+        }
         return false;
       }
 
-      string action = action_table[{current_state, current_input}];
+      const string &action = entry->second;
 
       if (action == "accept") {
-        printStep(step, state_stack, symbol_stack, remaining_input, "ACCEPT");
-        cout << "\nPARSING SUCCESSFUL!\n";
+        if (trace) {
+          printStep(step, state_stack, symbol_stack, remaining_input, "ACCEPT");
+          cout << "\nPARSING SUCCESSFUL!\n";
+        }
+        if (tree && !node_stack.empty())
+          tree->setRoot(node_stack.back());
         return true;
       } else if (action[0] == 's') { // Shift action
         int next_state = stoi(action.substr(1));
 
-        printStep(step++, state_stack, symbol_stack, remaining_input,
-                  "shift " + to_string(next_state));
+        if (trace)
+          printStep(step++, state_stack, symbol_stack, remaining_input,
+                    "shift " + to_string(next_state));
 
         state_stack.push(next_state);
         symbol_stack.push(current_input);
+        if (tree)
+          node_stack.push_back(tree->leaf(input_index));
         input_index++;
       } else if (action[0] == 'r') { // Reduce action
         int prod_num = stoi(action.substr(1));
 
         if (prod_num >= productions.size() || !productions[prod_num].left) {
-          printStep(step, state_stack, symbol_stack, remaining_input,
-                    "ERROR - Invalid production");
-          cout << "\nPARSE ERROR: Invalid production number " << prod_num
-               << "\n";
+          if (trace) {
+            printStep(step, state_stack, symbol_stack, remaining_input,
+                      "ERROR - Invalid production");
+            cout << "\nPARSE ERROR: Invalid production number " << prod_num
+                 << "\n";
+          }
           return false;
         }
 
         Production &prod = productions[prod_num];
 
-        string reduce_action = "reduce by " + to_string(prod_num) + " (" +
-                               prod.left + "->" +
-                               (prod.right == "e" ? "ε" : prod.right) + ")";
-        printStep(step++, state_stack, symbol_stack, remaining_input,
-                  reduce_action);
+        if (trace) {
+          string reduce_action = "reduce by " + to_string(prod_num) + " (" +
+                                 prod.left + "->" +
+                                 (prod.right == "e" ? "ε" : prod.right) + ")";
+          printStep(step++, state_stack, symbol_stack, remaining_input,
+                    reduce_action);
+        }
 
         // Pop symbols and states according to production right side
         int pop_count = (prod.right == "e") ? 0 : prod.right.length();
@@ -271,39 +298,422 @@ public:
           if (!symbol_stack.empty())
             symbol_stack.pop();
         }
+        if (tree) {
+          if (node_stack.size() < (size_t)pop_count) {
+            if (trace)
+              cout << "\nPARSE ERROR: Tree stack underflow during reduce\n";
+            return false;
+          }
+          node_stack.push_back(
+              tree->reduce(prod_num, node_stack, pop_count, input_index));
+        }
 
         // Push left side of production
         symbol_stack.push(prod.left);
 
         // Get goto state
         if (state_stack.empty()) {
-          cout << "\nPARSE ERROR: State stack is empty during reduce\n";
+          if (trace)
+            cout << "\nPARSE ERROR: State stack is empty during reduce\n";
           return false;
         }
 
         int top_state = state_stack.top();
-        if (goto_table.find({top_state, prod.left}) == goto_table.end()) {
-          cout << "\nPARSE ERROR: No goto entry for state " << top_state
-               << " and non-terminal '" << prod.left << "'\n";
+        auto next = goto_table.find({top_state, prod.left});
+        if (next == goto_table.end()) {
+          if (trace)
+            cout << "\nPARSE ERROR: No goto entry for state " << top_state
+                 << " and non-terminal '" << prod.left << "'\n";
           return false;
         }
 
-        int goto_state = goto_table[{top_state, prod.left}];
-        state_stack.push(goto_state);
+        state_stack.push(next->second);
       } else {
-        printStep(step, state_stack, symbol_stack, remaining_input,
-                  "ERROR - Unknown action");
-        cout << "\nPARSE ERROR: Unknown action '" << action << "'\n";
+        if (trace) {
+          printStep(step, state_stack, symbol_stack, remaining_input,
+                    "ERROR - Unknown action");
+          cout << "\nPARSE ERROR: Unknown action '" << action << "'\n";
+        }
         return false;
       }
     }
 
-    cout << "\nPARSE ERROR: Reached end of input without acceptance\n";
+    if (trace)
+      cout << "\nPARSE ERROR: Reached end of input without acceptance\n";
     return false;
   }
+
+  // Flat table for PackedTable::parse and its semantic-action variant;
+  // unused production numbers keep an empty left side and are never reduced
+  PackedTable pack() const {
+    vector<char> terms(terminals.begin(), terminals.end());
+    terms.push_back('$');
+    vector<char> nts(non_terminals.begin(), non_terminals.end());
+    vector<pair<char, int>> prods;
+    for (const auto &p : productions)
+      prods.push_back({p.left, p.right == "e" ? 0 : (int)p.right.size()});
+    return PackedTable(all_states.empty() ? 0 : *all_states.rbegin() + 1, terms,
+                       nts, prods, action_table, goto_table);
+  }
+
+  PostfixActions postfixActions() const {
+    vector<string> rhs;
+    for (const auto &p : productions)
+      rhs.push_back(p.right == "e" ? "" : p.right);
+    bool nt[256] = {false};
+    for (char c : non_terminals)
+      nt[(unsigned char)c] = true;
+    return PostfixActions(rhs, nt);
+  }
+
+  void printTree(const ParseTree &tree, const string &input) const {
+    cout << "\nPARSE TREE (" << tree.size() << " nodes):\n";
+    cout << "===========\n";
+    tree.print(cout, input, [this](int prod) {
+      const Production &p = productions[prod];
+      return string(1, p.left) + " -> " + (p.right == "e" ? "ε" : p.right);
+    });
+  }
+};
+
+// SLR table of the textbook expression grammar, used by --bench-tree
+void loadExpressionGrammar(LRParser &parser) {
+  const char *prods[] = {"E E+T", "E T", "T T*F", "T F", "F (E)", "F i"};
+  for (int i = 0; i < 6; i++)
+    parser.addProduction(i + 1, prods[i][0], prods[i] + 2);
+
+  const char *shifts[] = {"0 i s5", "0 ( s4", "1 + s6", "1 $ accept",
+                          "2 * s7", "4 i s5", "4 ( s4", "6 i s5",
+                          "6 ( s4", "7 i s5", "7 ( s4", "8 + s6",
+                          "8 ) s11", "9 * s7"};
+  for (const char *entry : shifts) {
+    istringstream iss(entry);
+    int state;
+    char symbol;
+    string action;
+    iss >> state >> symbol >> action;
+    parser.setActionEntry(state, symbol, action);
+  }
+  // reductions on FOLLOW(E) = { + ) $ } and FOLLOW(T) = FOLLOW(F) = { + * ) $ }
+  int reduce_state[] = {2, 3, 5, 9, 10, 11}, reduce_prod[] = {2, 4, 6, 1, 3, 5};
+  for (int i = 0; i < 6; i++) {
+    for (char a : string("+*)$")) {
+      if (a == '*' && (reduce_prod[i] == 1 || reduce_prod[i] == 2))
+        continue;
+      parser.setActionEntry(reduce_state[i], a, "r" + to_string(reduce_prod[i]));
+    }
+  }
+  int gotos[][3] = {{0, 'E', 1}, {0, 'T', 2}, {0, 'F', 3}, {4, 'E', 8},
+                    {4, 'T', 2}, {4, 'F', 3}, {6, 'T', 9}, {6, 'F', 3},
+                    {7, 'F', 10}};
+  for (auto &g : gotos)
+    parser.setGotoEntry(g[0], (char)g[1], g[2]);
+}
+
+// Random expression over i + * ( ) of about n tokens
+string randomExpression(mt19937 &rng, int n, int depth = 0) {
+  string out;
+  int terms = 0;
+  while ((int)out.size() < n || terms == 0) {
+    if (terms++ > 0)
+      out += (rng() % 2) ? '+' : '*';
+    if (depth < 6 && rng() % 8 == 0) {
+      out += '(' + randomExpression(rng, 1 + rng() % 12, depth + 1) + ')';
+    } else {
+      out += 'i';
+    }
+  }
+  return out;
+}
+
+// Evaluates the expression grammar of loadExpressionGrammar() as it parses;
+// the k-th token i stands for the value k % 9 + 1, arithmetic wraps mod 2^32
+struct EvalActions {
+  using Value = uint32_t;
+  Value shift(char token, size_t pos) { return token == 'i' ? pos % 9 + 1 : 0; }
+  Value reduce(int prod, ValueSpan<Value> rhs) {
+    switch (prod) {
+    case 1: // E -> E+T
+      return rhs[0] + rhs[2];
+    case 3: // T -> T*F
+      return rhs[0] * rhs[2];
+    case 5: // F -> (E)
+      return rhs[1];
+    default:
+      return rhs[0];
+    }
+  }
+};
+
+// The same actions behind an interface, for comparison with the inlined ones
+struct Evaluator {
+  virtual ~Evaluator() {}
+  virtual uint32_t shift(char token, size_t pos) = 0;
+  virtual uint32_t reduce(int prod, ValueSpan<uint32_t> rhs) = 0;
+};
+
+struct VirtualEvaluator : Evaluator {
+  EvalActions impl;
+  uint32_t shift(char token, size_t pos) override { return impl.shift(token, pos); }
+  uint32_t reduce(int prod, ValueSpan<uint32_t> rhs) override {
+    return impl.reduce(prod, rhs);
+  }
+};
+
+struct VirtualActions {
+  using Value = uint32_t;
+  Evaluator *impl;
+  Value shift(char token, size_t pos) { return impl->shift(token, pos); }
+  Value reduce(int prod, ValueSpan<Value> rhs) { return impl->reduce(prod, rhs); }
+};
+
+// Times the flat-table driver as a recognizer, with inlined EvalActions and
+// with the same actions called through a virtual interface
+int benchActions(int n_tokens) {
+  LRParser parser;
+  loadExpressionGrammar(parser);
+  PackedTable table = parser.pack();
+  mt19937 rng(1344);
+  vector<vector<uint8_t>> inputs;
+  long long tokens = 0;
+  while (tokens < n_tokens) {
+    string expr = randomExpression(rng, 1 + rng() % 200);
+    inputs.push_back(table.encode(expr));
+    tokens += expr.size() + 1;
+  }
+
+  unique_ptr<Evaluator> evaluator(new VirtualEvaluator);
+  EvalActions inlined;
+  VirtualActions virt{evaluator.get()};
+  vector<int> stack;
+  vector<uint32_t> values;
+  uint32_t sum_inline = 0, sum_virtual = 0;
+  for (auto &in : inputs) {
+    uint32_t a = 0, b = 0;
+    if (!table.parse(in, inlined, a) || !table.parse(in, virt, b) || a != b) {
+      cout << "Actions disagree or input rejected\n";
+      return 1;
+    }
+    sum_inline += a;
+  }
+
+  auto time = [&](auto &&parse_all) {
+    double best = 1e18;
+    for (int round = 0; round < 3; round++) {
+      auto t0 = chrono::steady_clock::now();
+      parse_all();
+      best = min(best, chrono::duration<double, nano>(chrono::steady_clock::now() - t0)
+                           .count());
+    }
+    return best / tokens;
+  };
+  double recognize = time([&] {
+    for (auto &in : inputs)
+      table.parse(in, stack);
+  });
+  double inline_ns = time([&] {
+    uint32_t v;
+    for (auto &in : inputs)
+      if (table.parse(in, inlined, v, stack, values))
+        sum_virtual += v;
+  });
+  double virtual_ns = time([&] {
+    uint32_t v;
+    for (auto &in : inputs)
+      if (table.parse(in, virt, v, stack, values))
+        sum_virtual += v;
+  });
+
+  cout << "ACTIONS BENCHMARK (" << inputs.size() << " expressions, " << tokens
+       << " tokens, checksum " << sum_inline << "):\n";
+  cout << fixed << setprecision(2);
+  cout << "Recognizer only:  " << recognize << " ns/token\n";
+  cout << "Inlined actions:  " << inline_ns << " ns/token\n";
+  cout << "Virtual actions:  " << virtual_ns << " ns/token\n";
+  return sum_virtual == 0;
+}
+
+// Pointer-based node for the new/malloc baselines
+struct HeapNode {
+  int prod;
+  int nkids;
+  HeapNode **kids;
+  uint32_t tok_begin, tok_end;
 };
 
-int main() {
+template <class Alloc, class Free>
+double buildHeapTree(const vector<pair<int, int>> &events, Alloc alloc, Free release,
+                     double &free_ms) {
+  auto t0 = chrono::steady_clock::now();
+  vector<HeapNode *> stack;
+  uint32_t pos = 0;
+  for (auto [prod, n] : events) {
+    HeapNode *node = alloc(n);
+    node->prod = prod;
+    node->nkids = n;
+    if (prod < 0) {
+      node->tok_begin = pos++;
+      node->tok_end = pos;
+    } else {
+      HeapNode **in = stack.data() + stack.size() - n;
+      for (int i = 0; i < n; i++)
+        node->kids[i] = in[i];
+      node->tok_begin = n ? in[0]->tok_begin : pos;
+      node->tok_end = n ? in[n - 1]->tok_end : pos;
+      stack.resize(stack.size() - n);
+    }
+    stack.push_back(node);
+  }
+  auto t1 = chrono::steady_clock::now();
+  // nodes are freed one by one, walking the tree without recursion
+  while (!stack.empty()) {
+    HeapNode *node = stack.back();
+    stack.pop_back();
+    for (int i = 0; i < node->nkids; i++)
+      stack.push_back(node->kids[i]);
+    release(node);
+  }
+  auto t2 = chrono::steady_clock::now();
+  free_ms = chrono::duration<double, milli>(t2 - t1).count();
+  return chrono::duration<double, milli>(t1 - t0).count();
+}
+
+// Parses a generated expression of about n_nodes tree nodes, then rebuilds the
+// same tree with the arena and with one new/malloc per node and child list
+int benchTree(int n_nodes) {
+  LRParser parser;
+  loadExpressionGrammar(parser);
+  mt19937 rng(1344);
+  string input = randomExpression(rng, max(1, n_nodes * 4 / 9));
+
+  ParseTree tree;
+  auto t0 = chrono::steady_clock::now();
+  if (!parser.parse(input, &tree, false)) {
+    cout << "Generated input was rejected\n";
+    return 1;
+  }
+  double parse_ms =
+      chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+  // Post-order walk of the tree = the driver's sequence of (prod, children)
+  vector<pair<int, int>> events;
+  vector<pair<uint32_t, bool>> walk = {{tree.root(), false}};
+  while (!walk.empty()) {
+    auto [id, done] = walk.back();
+    walk.pop_back();
+    const ParseNode &node = tree.node(id);
+    bool leaf = node.prod == ParseTree::kLeaf;
+    if (done || leaf) {
+      events.push_back({leaf ? -1 : node.prod, node.nkids});
+      continue;
+    }
+    walk.push_back({id, true});
+    for (int i = node.nkids - 1; i >= 0; i--)
+      walk.push_back({tree.child(id, i), false});
+  }
+
+  // Replay the events with each allocator so all three do the same work;
+  // best of three rounds, so no builder pays alone for first-touch pages
+  double arena_ms = 1e18, arena_free = 0, new_ms = 1e18, new_free = 0;
+  double malloc_ms = 1e18, malloc_free = 0;
+  size_t arena_bytes = 0;
+  for (int round = 0; round < 3; round++) {
+    t0 = chrono::steady_clock::now();
+    ParseTree replay;
+    vector<uint32_t> stack;
+    uint32_t pos = 0;
+    for (auto [prod, n] : events) {
+      if (prod < 0)
+        stack.push_back(replay.leaf(pos++));
+      else
+        stack.push_back(replay.reduce(prod, stack, n, pos));
+    }
+    replay.setRoot(stack.back());
+    auto t1 = chrono::steady_clock::now();
+    arena_bytes = replay.bytes();
+    replay.release();
+    auto t2 = chrono::steady_clock::now();
+    double build = chrono::duration<double, milli>(t1 - t0).count();
+    if (build < arena_ms) {
+      arena_ms = build;
+      arena_free = chrono::duration<double, milli>(t2 - t1).count();
+    }
+
+    double release = 0;
+    build = buildHeapTree(
+        events,
+        [](int n) {
+          HeapNode *node = new HeapNode;
+          node->kids = n ? new HeapNode *[n] : nullptr;
+          return node;
+        },
+        [](HeapNode *node) {
+          delete[] node->kids;
+          delete node;
+        },
+        release);
+    if (build < new_ms) {
+      new_ms = build;
+      new_free = release;
+    }
+    build = buildHeapTree(
+        events,
+        [](int n) {
+          HeapNode *node = (HeapNode *)malloc(sizeof(HeapNode));
+          node->kids = n ? (HeapNode **)malloc(n * sizeof(HeapNode *)) : nullptr;
+          return node;
+        },
+        [](HeapNode *node) {
+          free(node->kids);
+          free(node);
+        },
+        release);
+    if (build < malloc_ms) {
+      malloc_ms = build;
+      malloc_free = release;
+    }
+  }
+
+  size_t nodes = events.size();
+  cout << "TREE BENCHMARK (" << input.size() << " tokens, " << nodes
+       << " nodes, parse " << fixed << setprecision(2) << parse_ms << " ms):\n";
+  cout << "ParseNode size:   " << sizeof(ParseNode) << " bytes (HeapNode "
+       << sizeof(HeapNode) << " bytes + child array)\n";
+  auto row = [&](const char *name, double build, double release) {
+    cout << name << fixed << setprecision(2) << setw(8) << build
+         << " ms build (" << setprecision(1) << build * 1e6 / nodes
+         << " ns/node), " << setprecision(3) << release << " ms free\n";
+  };
+  row("Arena:     ", arena_ms, arena_free);
+  row("new/delete:", new_ms, new_free);
+  row("malloc:    ", malloc_ms, malloc_free);
+  cout << "Arena footprint:  " << arena_bytes << " bytes in pages\n";
+  cout << "Arena speedup:    " << setprecision(1)
+       << (new_ms + new_free) / (arena_ms + arena_free) << "x vs new, "
+       << (malloc_ms + malloc_free) / (arena_ms + arena_free)
+       << "x vs malloc (build + free)\n";
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  bool show_tree = false, postfix = false;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--tree") {
+      show_tree = true;
+    } else if (arg == "--postfix") {
+      postfix = true;
+    } else if (arg == "--bench-tree" && i + 1 < argc) {
+      return benchTree(atoi(argv[++i]));
+    } else if (arg == "--bench-actions" && i + 1 < argc) {
+      return benchActions(atoi(argv[++i]));
+    } else {
+      cerr << "Usage: " << argv[0]
+           << " [--tree] [--postfix] | --bench-tree N | --bench-actions N\n";
+      return 1;
+    }
+  }
+
   LRParser parser;
 
   cout << "LR PARSING ALGORITHM IMPLEMENTATION\n";
@@ -383,6 +793,9 @@ int main() {
   parser.printProductions();
   parser.printParseTable();
 
+  PackedTable table = parser.pack();
+  PostfixActions translate = parser.postfixActions();
+
   // Parse input strings
   string input_string;
   char continue_parsing = 'y';
@@ -392,9 +805,15 @@ int main() {
     cin >> input_string;
     cin.ignore();
 
-    bool result = parser.parse(input_string);
+    ParseTree tree;
+    bool result = parser.parse(input_string, show_tree ? &tree : nullptr);
 
     if (result) {
+      if (show_tree)
+        parser.printTree(tree, input_string);
+      string translation;
+      if (postfix && table.parse(table.encode(input_string), translate, translation))
+        cout << "\nPOSTFIX: " << translation << "\n";
       cout << "\n✓ String ACCEPTED by the grammar!\n";
     } else {
       cout << "\n✗ String REJECTED by the grammar!\n";
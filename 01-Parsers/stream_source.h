@@ -0,0 +1,206 @@
+// stream_source.h
+// Token sources for PackedTable::parseFrom that read a file piece by piece,
+// so inputs of any length parse in memory bounded by one chunk plus the
+// parse stack. Tokens are single characters, as in the LR tools; blanks and
+// newlines between them are skipped.
+//
+//   FdReader    read(2) into a fixed buffer (works on pipes and stdin)
+//   MmapReader  a sliding read-only window over a regular file, unmapped
+//               as soon as the driver has moved past it
+//
+//   StreamSource<FdReader> in(FdReader(fd, 1 << 20), table);
+//   in.onChunk([&](const StreamProgress &p) { ... });   // optional
+//   PackedTable::Result r = table.parseFrom(in, stack);
+#ifndef STREAM_SOURCE_H
+#define STREAM_SOURCE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "packed_table.h"
+
+// Counters a source keeps as it runs
+struct StreamProgress {
+  uint64_t bytes = 0;  // input bytes handed to the driver so far
+  uint64_t tokens = 0; // tokens consumed so far
+  uint64_t chunks = 0;
+};
+
+// Fills a fixed buffer with read(2); next() returns false at end of input
+// or on an error (failed() tells which)
+class FdReader {
+public:
+  FdReader(int fd, size_t chunk) : fd_(fd), buf_(chunk ? chunk : 1) {}
+
+  bool next(const uint8_t *&data, size_t &n) {
+    ssize_t r;
+    do
+      r = ::read(fd_, buf_.data(), buf_.size());
+    while (r < 0 && errno == EINTR);
+    if (r <= 0) {
+      failed_ = r < 0;
+      return false;
+    }
+    data = buf_.data();
+    n = (size_t)r;
+    return true;
+  }
+
+  bool failed() const { return failed_; }
+  size_t resident() const { return buf_.size(); }
+
+private:
+  int fd_;
+  std::vector<uint8_t> buf_;
+  bool failed_ = false;
+};
+
+// Maps window bytes of a regular file at a time (rounded to whole pages);
+// the previous window is unmapped before the next one is mapped
+class MmapReader {
+public:
+  MmapReader(int fd, size_t window) : fd_(fd) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    window_ = (window + page - 1) / page * page;
+    if (window_ == 0)
+      window_ = page;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+      size_ = (uint64_t)st.st_size;
+    else
+      failed_ = true;
+  }
+  ~MmapReader() { unmap(); }
+  MmapReader(MmapReader &&o) noexcept { *this = std::move(o); }
+  MmapReader &operator=(MmapReader &&o) noexcept {
+    std::swap(fd_, o.fd_);
+    std::swap(window_, o.window_);
+    std::swap(size_, o.size_);
+    std::swap(off_, o.off_);
+    std::swap(map_, o.map_);
+    std::swap(len_, o.len_);
+    std::swap(failed_, o.failed_);
+    return *this;
+  }
+
+  bool next(const uint8_t *&data, size_t &n) {
+    unmap();
+    if (failed_ || off_ >= size_)
+      return false;
+    len_ = (size_t)(size_ - off_ < window_ ? size_ - off_ : window_);
+    void *p = mmap(nullptr, len_, PROT_READ, MAP_PRIVATE, fd_, (off_t)off_);
+    if (p == MAP_FAILED) {
+      failed_ = true;
+      len_ = 0;
+      return false;
+    }
+    madvise(p, len_, MADV_SEQUENTIAL);
+    map_ = p;
+    off_ += len_;
+    data = (const uint8_t *)p;
+    n = len_;
+    return true;
+  }
+
+  bool failed() const { return failed_; }
+  size_t resident() const { return window_; }
+
+private:
+  void unmap() {
+    if (map_)
+      munmap(map_, len_);
+    map_ = nullptr;
+  }
+
+  int fd_ = -1;
+  size_t window_ = 0;
+  uint64_t size_ = 0, off_ = 0;
+  void *map_ = nullptr;
+  size_t len_ = 0;
+  bool failed_ = false;
+};
+
+// PackedTable token source over a reader. Characters that are not terminals
+// map to the error column, so the driver stops on them. A '$' byte is one of
+// them: only an exhausted reader reads as the end column, so a validator
+// never accepts a prefix followed by garbage.
+template <class Reader> class StreamSource {
+public:
+  StreamSource(Reader reader, const PackedTable &table) : reader_(std::move(reader)) {
+    for (int c = 0; c < 256; ++c)
+      map_[c] = table.column((char)c);
+    map_[(unsigned char)'$'] = table.errorColumn();
+    for (char c : {' ', '\t', '\n', '\r'})
+      if (map_[(unsigned char)c] == table.errorColumn())
+        map_[(unsigned char)c] = kSkip;
+    eof_ = table.endColumn();
+  }
+
+  // Called after each chunk is read (including the first)
+  void onChunk(std::function<void(const StreamProgress &)> f) { onChunk_ = std::move(f); }
+
+  uint8_t peek() {
+    if (!started_) {
+      started_ = true;
+      skip();
+    }
+    return cur_ == end_ ? eof_ : map_[*cur_];
+  }
+
+  void advance() {
+    ++cur_;
+    ++progress_.tokens;
+    skip();
+  }
+
+  size_t pos() const { return progress_.tokens; }
+  // Byte offset of the current token (or of the end of input)
+  uint64_t offset() const { return base_ + (cur_ - begin_); }
+  const StreamProgress &progress() const { return progress_; }
+  const Reader &reader() const { return reader_; }
+
+private:
+  static constexpr uint8_t kSkip = 0xFF;
+
+  // Moves past blanks, reading chunks as needed; cur_ == end_ afterwards
+  // only at the end of input
+  void skip() {
+    for (;;) {
+      while (cur_ != end_ && map_[*cur_] == kSkip)
+        ++cur_;
+      if (cur_ != end_ || done_)
+        return;
+      base_ += end_ - begin_;
+      size_t n = 0;
+      if (!reader_.next(begin_, n)) {
+        done_ = true;
+        begin_ = cur_ = end_ = nullptr;
+        return;
+      }
+      cur_ = begin_;
+      end_ = begin_ + n;
+      progress_.bytes += n;
+      ++progress_.chunks;
+      if (onChunk_)
+        onChunk_(progress_);
+    }
+  }
+
+  Reader reader_;
+  uint8_t map_[256];
+  uint8_t eof_;
+  const uint8_t *begin_ = nullptr, *cur_ = nullptr, *end_ = nullptr;
+  uint64_t base_ = 0;
+  bool started_ = false, done_ = false;
+  StreamProgress progress_;
+  std::function<void(const StreamProgress &)> onChunk_;
+};
+
+#endif
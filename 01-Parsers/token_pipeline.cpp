@@ -0,0 +1,510 @@
+// token_pipeline.cpp
+// Lexer -> parser pipeline without a text round trip: a C-subset lexer
+// writes table column ids straight into a TokenRing and the flat-table LR
+// driver (PackedTable::parseFrom) consumes them in place, on another thread
+// or in the same one. The grammar is the statement/expression subset below,
+// built into an SLR(1) table with GrammarModel (see model_table.h).
+//
+// Compile: g++ -O2 -pthread token_pipeline.cpp -o token_pipeline
+//   ./token_pipeline FILE            (lex + parse FILE on two threads)
+//   ./token_pipeline FILE --max-errors N
+//                                    (report every syntax error, up to N)
+//   ./token_pipeline --generate MB   (write a random MB-sized program to stdout)
+//   ./token_pipeline --bench MB      (generated MB-sized program, all modes)
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model_table.h"
+#include "token_ring.h"
+
+using namespace std;
+
+// Terminals: i identifier, n number, w while, f if, l else, r return, and
+// the punctuation itself. 'e' is an empty right side.
+const char *kGrammar[] = {
+    "B->BS",  "B->S",    "S->E;",    "S->{B}",   "S->w(E)S", "S->f(E){B}",
+    "S->f(E){B}l{B}",    "S->rE;",   "E->E,V",   "E->V",     "V->i=V",
+    "V->C",   "C->C|D",  "C->D",     "D->D&G",   "D->G",     "G->G^H",
+    "G->H",   "H->H~I",  "H->I",     "I->I<J",   "I->I>J",   "I->J",
+    "J->J+K", "J->J-K",  "J->K",     "K->K*M",   "K->K/M",   "K->K%M",
+    "K->M",   "M->-M",   "M->!M",    "M->N",     "N->N(X)",  "N->N[E]",
+    "N->N.i", "N->(E)",  "N->i",     "N->n",     "X->E",     "X->e"};
+
+// Error recovery resynchronizes at statement and block ends
+const char *kSync = ";}";
+
+// SLR(1) table of kGrammar in flat form
+PackedTable buildTable(int &conflicts) {
+  GrammarModel g;
+  for (const char *p : kGrammar)
+    addCharProduction(g, p);
+  g.rebuild();
+  conflicts = g.conflicts();
+  return packModel(g);
+}
+
+// ---------------------------------------------------------------------------
+// Lexer: C source -> one terminal per token. map[c] turns the terminal
+// character into whatever the sink stores (a table column, or c itself).
+
+enum CharClass : uint8_t { kOther, kSpace, kIdent, kDigit, kPunct, kSlash };
+
+struct CharClasses {
+  uint8_t cls[256];
+  CharClasses() {
+    memset(cls, kOther, sizeof cls);
+    for (unsigned char c : string(" \t\r\n\f\v"))
+      cls[c] = kSpace;
+    for (int c = 0; c < 256; ++c)
+      if (isalpha(c) || c == '_')
+        cls[c] = kIdent;
+    for (int c = '0'; c <= '9'; ++c)
+      cls[c] = kDigit;
+    for (unsigned char c : string(";{}(),=|&^~<>+-*%![]."))
+      cls[c] = kPunct;
+    cls[(unsigned char)'/'] = kSlash;
+  }
+};
+const CharClasses kClasses;
+
+inline char keywordOrIdent(const char *s, size_t n) {
+  switch (n) {
+  case 2:
+    return memcmp(s, "if", 2) == 0 ? 'f' : 'i';
+  case 4:
+    return memcmp(s, "else", 4) == 0 ? 'l' : 'i';
+  case 5:
+    return memcmp(s, "while", 5) == 0 ? 'w' : 'i';
+  case 6:
+    return memcmp(s, "return", 6) == 0 ? 'r' : 'i';
+  }
+  return 'i';
+}
+
+// Emits every token of [p, end) and then eof; false if the sink gave up
+template <class Sink>
+bool lex(const char *p, const char *end, const uint8_t *map, uint8_t eof, Sink &out) {
+  const uint8_t *cls = kClasses.cls;
+  while (p < end) {
+    unsigned char c = *p;
+    switch (cls[c]) {
+    case kSpace:
+      ++p;
+      continue;
+    case kIdent: {
+      const char *s = p;
+      while (++p < end && (cls[(unsigned char)*p] == kIdent || cls[(unsigned char)*p] == kDigit))
+        ;
+      if (!out.put(map[(unsigned char)keywordOrIdent(s, p - s)]))
+        return false;
+      continue;
+    }
+    case kDigit:
+      while (++p < end && (cls[(unsigned char)*p] == kDigit || *p == '.' ||
+                           cls[(unsigned char)*p] == kIdent))
+        ;
+      if (!out.put(map[(unsigned char)'n']))
+        return false;
+      continue;
+    case kSlash:
+      if (p + 1 < end && p[1] == '/') {
+        const void *nl = memchr(p, '\n', end - p);
+        p = nl ? (const char *)nl + 1 : end;
+        continue;
+      }
+      if (p + 1 < end && p[1] == '*') {
+        const char *q = p + 2;
+        while (q + 1 < end && !(q[0] == '*' && q[1] == '/'))
+          ++q;
+        p = q + 1 < end ? q + 2 : end;
+        continue;
+      }
+      break;
+    default:
+      break;
+    }
+    // punctuation, a lone '/', or a character no rule accepts (which maps to
+    // the error column and stops the parse there)
+    if (!out.put(map[c]))
+      return false;
+    ++p;
+  }
+  return out.put(eof);
+}
+
+struct VectorSink {
+  vector<uint8_t> &out;
+  bool put(uint8_t t) {
+    out.push_back(t);
+    return true;
+  }
+};
+
+struct TextSink {
+  string &out;
+  bool put(uint8_t t) {
+    out.push_back((char)t);
+    return true;
+  }
+};
+
+// Writes straight into the ring, committing every kBatch tokens so the
+// parser sees them early without paying an atomic store per token
+class RingSink {
+public:
+  static constexpr size_t kBatch = 4096;
+  explicit RingSink(TokenRing<uint8_t> &ring) : ring_(ring) {}
+  bool put(uint8_t t) {
+    if (cur_ == end_ && !next())
+      return false;
+    *cur_++ = t;
+    return true;
+  }
+  void finish() {
+    if (start_)
+      ring_.commit(cur_ - start_);
+    ring_.finish();
+  }
+  size_t tokens() const { return tokens_ + (cur_ - start_); }
+
+private:
+  bool next() {
+    if (start_) {
+      ring_.commit(cur_ - start_);
+      tokens_ += cur_ - start_;
+    }
+    size_t n = 0;
+    start_ = cur_ = ring_.reserve(n);
+    if (!start_ || ring_.closed()) {
+      start_ = cur_ = end_ = nullptr;
+      return false;
+    }
+    end_ = start_ + min(n, kBatch);
+    return true;
+  }
+
+  TokenRing<uint8_t> &ring_;
+  uint8_t *start_ = nullptr, *cur_ = nullptr, *end_ = nullptr;
+  size_t tokens_ = 0;
+};
+
+struct Run {
+  bool accepted = false;
+  size_t tokens = 0;
+  double ms = 0;
+  uint64_t producer_waits = 0, consumer_waits = 0;
+};
+
+// Lexer thread -> ring -> parser on this thread
+Run runPipelined(const PackedTable &table, const uint8_t *map, const string &src,
+                 size_t ring_tokens) {
+  Run r;
+  auto t0 = chrono::steady_clock::now();
+  TokenRing<uint8_t> ring(ring_tokens);
+  size_t lexed = 0;
+  thread lexer([&] {
+    RingSink sink(ring);
+    lex(src.data(), src.data() + src.size(), map, table.endColumn(), sink);
+    sink.finish();
+    lexed = sink.tokens();
+  });
+  vector<int> stack;
+  {
+    RingSource in(ring, table.errorColumn());
+    r.accepted = table.parseFrom(in, stack).accepted;
+  }
+  lexer.join();
+  r.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+  r.tokens = lexed;
+  r.producer_waits = ring.producerWaits();
+  r.consumer_waits = ring.consumerWaits();
+  return r;
+}
+
+// Lex everything into an array of columns, then parse it
+Run runSequential(const PackedTable &table, const uint8_t *map, const string &src) {
+  Run r;
+  auto t0 = chrono::steady_clock::now();
+  vector<uint8_t> cols;
+  cols.reserve(src.size() / 3);
+  VectorSink sink{cols};
+  lex(src.data(), src.data() + src.size(), map, table.endColumn(), sink);
+  vector<int> stack;
+  r.accepted = table.parse(cols, stack).accepted;
+  r.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+  r.tokens = cols.size();
+  return r;
+}
+
+// Lex into an array of columns, then parse it with error recovery, printing
+// each error (by token index) as it is found
+Run runRecovering(const PackedTable &table, const uint8_t *map, const string &src,
+                  long long max_errors, long long &errors) {
+  struct ColumnSource {
+    const vector<uint8_t> &cols;
+    size_t i = 0;
+    uint8_t peek() const { return cols[i]; }
+    void advance() { ++i; }
+    size_t pos() const { return i; }
+  };
+  Run r;
+  auto t0 = chrono::steady_clock::now();
+  vector<uint8_t> cols;
+  cols.reserve(src.size() / 3);
+  VectorSink sink{cols};
+  lex(src.data(), src.data() + src.size(), map, table.endColumn(), sink);
+  vector<int> stack;
+  ColumnSource in{cols};
+  PackedTable::Result res = table.parseRecovering(
+      in, stack, PackedTable::Recovery{kSync, max_errors},
+      [](const PackedTable::SyntaxError &e) {
+        cout << "error at token " << e.pos << ": " << PackedTable::describe(e) << "\n";
+      });
+  r.accepted = res.accepted;
+  errors = res.errors;
+  r.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+  r.tokens = cols.size();
+  return r;
+}
+
+// The old way: the lexer produces text, the driver re-encodes it
+Run runText(const PackedTable &table, const string &src) {
+  Run r;
+  uint8_t identity[256];
+  for (int c = 0; c < 256; ++c)
+    identity[c] = (uint8_t)c;
+  auto t0 = chrono::steady_clock::now();
+  string text;
+  TextSink sink{text};
+  lex(src.data(), src.data() + src.size(), identity, '$', sink);
+  text.pop_back(); // encode() appends its own '$'
+  vector<int> stack;
+  r.accepted = table.parse(table.encode(text), stack).accepted;
+  r.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+  r.tokens = text.size() + 1;
+  return r;
+}
+
+// ---------------------------------------------------------------------------
+// Random programs in the grammar's language, with comments and layout
+
+class ProgramGenerator {
+public:
+  explicit ProgramGenerator(unsigned seed) : rng_(seed) {}
+
+  string generate(size_t bytes) {
+    string out;
+    while (out.size() < bytes)
+      statement(out, 0);
+    return out;
+  }
+
+private:
+  int pick(int n) { return (int)(rng_() % n); }
+
+  void ident(string &out) {
+    static const char *names[] = {"x", "count", "buffer_size", "i", "node",
+                                  "total", "next_index", "tmp", "value", "result_code"};
+    out += names[pick(10)];
+    if (pick(4) == 0)
+      out += to_string(pick(100));
+  }
+
+  void indent(string &out, int depth) { out.append(2 * depth, ' '); }
+
+  void statement(string &out, int depth) {
+    indent(out, depth);
+    int k = depth < 4 ? pick(12) : 0;
+    if (k < 6) {
+      expr(out, 0);
+      out += ";\n";
+    } else if (k == 6) {
+      out += "{\n";
+      block(out, depth + 1);
+      indent(out, depth);
+      out += "}\n";
+    } else if (k == 7) {
+      out += "while (";
+      expr(out, 0);
+      out += ")\n";
+      statement(out, depth + 1);
+    } else if (k <= 9) {
+      out += "if (";
+      expr(out, 0);
+      out += ") {\n";
+      block(out, depth + 1);
+      indent(out, depth);
+      out += "}";
+      if (pick(2)) {
+        out += " else {\n";
+        block(out, depth + 1);
+        indent(out, depth);
+        out += "}";
+      }
+      out += "\n";
+    } else if (k == 10) {
+      out += "return ";
+      expr(out, 0);
+      out += ";\n";
+    } else {
+      // a comment is not a statement: one always follows
+      out += pick(2) ? "// keep the running total in range\n"
+                     : "/* reset the index once the buffer wraps around */\n";
+      statement(out, depth);
+    }
+  }
+
+  void block(string &out, int depth) {
+    int n = 1 + pick(4);
+    for (int k = 0; k < n; ++k)
+      statement(out, depth);
+  }
+
+  // E: assignments and comma lists over binary-operator chains
+  void expr(string &out, int depth) {
+    assignment(out, depth);
+    if (pick(10) == 0) {
+      out += ", ";
+      assignment(out, depth);
+    }
+  }
+
+  void assignment(string &out, int depth) {
+    if (pick(3) == 0) {
+      ident(out);
+      out += " = ";
+      assignment(out, depth);
+      return;
+    }
+    static const char *ops[] = {" + ", " - ", " * ", " / ", " % ", " < ", " > ",
+                                " & ", " | ", " ^ ", " ~ "};
+    operand(out, depth);
+    int n = pick(4);
+    for (int k = 0; k < n; ++k) {
+      out += ops[pick(11)];
+      operand(out, depth);
+    }
+  }
+
+  void operand(string &out, int depth) {
+    if (pick(10) == 0)
+      out += pick(2) ? "-" : "!";
+    int k = depth < 3 ? pick(8) : pick(6);
+    if (k < 4)
+      ident(out);
+    else if (k < 6)
+      out += to_string(rng_() % 100000);
+    else {
+      out += "(";
+      expr(out, depth + 1);
+      out += ")";
+    }
+    if (depth < 3 && pick(6) == 0) {
+      int post = pick(3);
+      if (post == 0) {
+        out += "(";
+        if (pick(3))
+          expr(out, depth + 1);
+        out += ")";
+      } else if (post == 1) {
+        out += "[";
+        expr(out, depth + 1);
+        out += "]";
+      } else {
+        out += ".";
+        ident(out);
+      }
+    }
+  }
+
+  mt19937 rng_;
+};
+
+void columnMap(const PackedTable &table, uint8_t *map) {
+  for (int c = 0; c < 256; ++c)
+    map[c] = table.column((char)c);
+}
+
+int bench(double mb) {
+  int conflicts = 0;
+  PackedTable table = buildTable(conflicts);
+  uint8_t map[256];
+  columnMap(table, map);
+  string src = ProgramGenerator(1344).generate((size_t)(mb * 1e6));
+  double size_mb = src.size() / 1e6;
+  cout << "PIPELINE BENCHMARK (" << fixed << setprecision(1) << size_mb << " MB source, "
+       << table.states() << " states, " << conflicts << " conflict(s), "
+       << thread::hardware_concurrency() << " hardware thread(s)):\n";
+
+  auto report = [&](const char *name, const Run &r) {
+    cout << name << (r.accepted ? "accepted" : "REJECTED") << ", " << r.tokens << " tokens, "
+         << setprecision(1) << r.ms << " ms, " << size_mb / (r.ms / 1e3) << " MB/s";
+  };
+  Run text = runText(table, src);
+  report("Text round trip:      ", text);
+  cout << "\n";
+  Run seq = runSequential(table, map, src);
+  report("Sequential ids:       ", seq);
+  cout << "\n";
+  for (size_t cap : {1024, 65536}) {
+    Run pipe = runPipelined(table, map, src, cap);
+    string name = "Ring of " + to_string(cap) + " tokens: ";
+    name.resize(22, ' ');
+    report(name.c_str(), pipe);
+    cout << " (lexer waited " << pipe.producer_waits << "x, parser " << pipe.consumer_waits
+         << "x)\n";
+    if (pipe.accepted != seq.accepted || pipe.tokens != seq.tokens)
+      return 1;
+  }
+  return text.accepted == seq.accepted ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  if (argc == 3 && string(argv[1]) == "--bench")
+    return bench(atof(argv[2]));
+  if (argc == 3 && string(argv[1]) == "--generate") {
+    cout << ProgramGenerator(random_device{}()).generate((size_t)(atof(argv[2]) * 1e6));
+    return 0;
+  }
+  long long max_errors = 0;
+  if (argc == 4 && string(argv[2]) == "--max-errors")
+    max_errors = max(1LL, atoll(argv[3]));
+  if ((argc != 2 && !max_errors) || argv[1][0] == '-') {
+    cerr << "Usage: " << argv[0] << " FILE [--max-errors N] | --generate MB | --bench MB\n";
+    return 1;
+  }
+
+  ifstream file(argv[1], ios::binary);
+  if (!file) {
+    cerr << "Could not open " << argv[1] << "\n";
+    return 1;
+  }
+  stringstream buf;
+  buf << file.rdbuf();
+  string src = buf.str();
+
+  int conflicts = 0;
+  PackedTable table = buildTable(conflicts);
+  uint8_t map[256];
+  columnMap(table, map);
+  long long errors = 0;
+  Run r = max_errors ? runRecovering(table, map, src, max_errors, errors)
+                     : runPipelined(table, map, src, 65536);
+  cout << (r.accepted ? "ACCEPTED" : "REJECTED");
+  if (errors)
+    cout << " with " << errors << " error(s)" << (errors >= max_errors ? " (limit reached)" : "");
+  cout << ": " << r.tokens << " tokens, " << fixed
+       << setprecision(2) << r.ms << " ms, " << src.size() / 1e6 / (r.ms / 1e3) << " MB/s\n";
+  return r.accepted ? 0 : 1;
+}
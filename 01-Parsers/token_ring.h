@@ -0,0 +1,158 @@
+// token_ring.h
+// Bounded single-producer/single-consumer ring of token ids, so a lexer
+// thread can feed a parse driver without going through text. Both sides
+// work in place on contiguous slices of the ring (no copy through a
+// temporary buffer); a full ring blocks the producer and an empty one
+// blocks the consumer, which bounds how far lexing can run ahead.
+//
+//   producer: T *p = ring.reserve(n); ...write up to n...; ring.commit(k);
+//             ring.finish();                     // end of stream
+//   consumer: const T *p = ring.acquire(n); ...read n...; ring.release(n);
+//             ring.close();                      // stop early (parse error)
+#ifndef TOKEN_RING_H
+#define TOKEN_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+template <class T> class TokenRing {
+public:
+  // capacity is rounded up to a power of two
+  explicit TokenRing(size_t capacity) {
+    size_t cap = 64;
+    while (cap < capacity)
+      cap *= 2;
+    buf_.resize(cap);
+    mask_ = cap - 1;
+  }
+
+  // Producer: a writable slice of at least one slot (at most up to the end
+  // of the buffer), stored in n; nullptr once the consumer has closed
+  T *reserve(size_t &n) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    for (int spins = 0;; ++spins) {
+      size_t free = buf_.size() - (head - tailCache_);
+      if (free > 0) {
+        size_t slot = head & mask_;
+        n = free < buf_.size() - slot ? free : buf_.size() - slot;
+        return &buf_[slot];
+      }
+      if (closed_.load(std::memory_order_relaxed))
+        return nullptr;
+      tailCache_ = tail_.load(std::memory_order_acquire);
+      if (buf_.size() - (head - tailCache_) == 0)
+        wait(spins, producerWaits_);
+    }
+  }
+
+  void commit(size_t n) {
+    head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+  }
+
+  void finish() { done_.store(true, std::memory_order_release); }
+
+  // Consumer: a readable slice of at least one slot, stored in n; nullptr
+  // when the producer has finished and everything was read
+  const T *acquire(size_t &n) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    for (int spins = 0;; ++spins) {
+      size_t avail = headCache_ - tail;
+      if (avail > 0) {
+        size_t slot = tail & mask_;
+        n = avail < buf_.size() - slot ? avail : buf_.size() - slot;
+        return &buf_[slot];
+      }
+      bool done = done_.load(std::memory_order_acquire);
+      headCache_ = head_.load(std::memory_order_acquire);
+      if (headCache_ == tail) {
+        if (done)
+          return nullptr;
+        wait(spins, consumerWaits_);
+      }
+    }
+  }
+
+  void release(size_t n) {
+    tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+  }
+
+  void close() { closed_.store(true, std::memory_order_relaxed); }
+  bool closed() const { return closed_.load(std::memory_order_relaxed); }
+
+  size_t capacity() const { return buf_.size(); }
+  // Times a side found the ring full/empty and had to wait
+  uint64_t producerWaits() const { return producerWaits_; }
+  uint64_t consumerWaits() const { return consumerWaits_; }
+
+private:
+  void wait(int spins, uint64_t &waits) {
+    // a short spin covers the other side being mid-batch; after that, give
+    // up the core (the other side may be waiting for it)
+    if (spins == 0)
+      ++waits;
+    if (spins < 64)
+      return;
+    std::this_thread::yield();
+  }
+
+  std::vector<T> buf_;
+  size_t mask_ = 0;
+  // producer's line
+  alignas(64) std::atomic<size_t> head_{0};
+  size_t tailCache_ = 0;
+  uint64_t producerWaits_ = 0;
+  // consumer's line
+  alignas(64) std::atomic<size_t> tail_{0};
+  size_t headCache_ = 0;
+  uint64_t consumerWaits_ = 0;
+  alignas(64) std::atomic<bool> done_{false};
+  std::atomic<bool> closed_{false};
+};
+
+// Token source for PackedTable::parseFrom over the consumer side of a ring.
+// The producer should end the stream with the '$' column; if it finishes
+// without one, the driver sees error_column and stops.
+class RingSource {
+public:
+  RingSource(TokenRing<uint8_t> &ring, uint8_t error_column)
+      : ring_(ring), eof_(error_column) {
+    refill();
+  }
+  // the parse is over: stop a producer that is still blocked on a full ring
+  ~RingSource() { ring_.close(); }
+
+  uint8_t peek() const { return *cur_; }
+  void advance() {
+    if (++cur_ == end_)
+      refill();
+  }
+  size_t pos() const { return base_ + (cur_ - start_); }
+
+private:
+  void refill() {
+    if (end_) {
+      ring_.release(end_ - start_);
+      base_ += end_ - start_;
+    }
+    size_t n = 0;
+    start_ = ring_.acquire(n);
+    if (!start_) {
+      // producer finished without '$': feed the error column forever
+      start_ = cur_ = &eof_;
+      end_ = nullptr;
+      return;
+    }
+    cur_ = start_;
+    end_ = start_ + n;
+  }
+
+  TokenRing<uint8_t> &ring_;
+  const uint8_t *start_ = nullptr, *cur_ = nullptr, *end_ = nullptr;
+  size_t base_ = 0;
+  uint8_t eof_;
+};
+
+#endif
@@ -1,5 +1,8 @@
-// Three-address code optimizer: performs constant folding and propagation. Compile: g++ ex16.cpp -o ex16 && ./ex16 < input.tac
+// Three-address code optimizer: performs constant folding and propagation. Compile: g++ -I../04-LexicalAnalysis ex16.cpp -o ex16 && ./ex16 < input.tac
+// Names are interned (interner.h): instructions hold symbol ids, per-variable state lives in
+// arrays indexed by id, and comparing two operands is an integer compare.
 #include <bits/stdc++.h>
+#include "interner.h"
 using namespace std;
 
 // Trim whitespace
@@ -22,10 +25,39 @@ bool isInteger(const string &s) {
 
 long long toInt(const string &s) { return stoll(s); }
 
+// Symbol table for every variable, temporary and literal operand
+intern_table symbols;
+vector<optional<long long>> literal; // per symbol: its value if the name is an integer
+
+uint32_t sym(const string &s) {
+    uint32_t id = intern(&symbols, s.data(), s.size());
+    if (id == INTERN_NONE) { cerr << "out of memory\n"; exit(1); }
+    if (id == literal.size())
+        literal.push_back(isInteger(s) ? optional<long long>(toInt(s)) : nullopt);
+    return id;
+}
+
+string text(uint32_t id) { return string(intern_name(&symbols, id), intern_length(&symbols, id)); }
+
+// Known values per variable, indexed by symbol id. A variable can be known to
+// hold no constant (present without a value), which is not the same as absent.
+struct ConstMap {
+    vector<optional<long long>> value;
+    vector<char> present;
+    bool count(uint32_t id) const { return id < present.size() && present[id]; }
+    optional<long long> &operator[](uint32_t id) {
+        if (id >= present.size()) { value.resize(id + 1); present.resize(id + 1); }
+        present[id] = 1;
+        return value[id];
+    }
+    void erase(uint32_t id) { if (count(id)) { present[id] = 0; value[id] = nullopt; } }
+};
+
 // IR instruction representation
 struct Instr {
     string raw;
-    string lhs, op1, op, op2;
+    uint32_t lhs = 0, op1 = 0, op2 = 0; // symbol ids
+    string op;
     bool isBinary = false;
     bool isAssign = false;
     bool other = false;
@@ -48,7 +80,7 @@ Instr parseLine(const string &ln) {
     auto eq = s.find('=');
     if (eq == string::npos) { ins.other = true; return ins; }
 
-    ins.lhs = trim(s.substr(0, eq));
+    ins.lhs = sym(trim(s.substr(0, eq)));
     string rhs = trim(s.substr(eq + 1));
 
     vector<string> tokens;
@@ -60,12 +92,12 @@ Instr parseLine(const string &ln) {
 
     if (tokens.size() == 3) {
         ins.isBinary = true;
-        ins.op1 = tokens[0];
+        ins.op1 = sym(tokens[0]);
         ins.op = tokens[1];
-        ins.op2 = tokens[2];
+        ins.op2 = sym(tokens[2]);
     } else if (tokens.size() == 1) {
         ins.isAssign = true;
-        ins.op1 = tokens[0];
+        ins.op1 = sym(tokens[0]);
     } else {
         ins.other = true;
     }
@@ -88,6 +120,7 @@ int main() {
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
 
+    intern_init(&symbols);
     vector<string> lines;
     string line;
     while (getline(cin, line))
@@ -97,12 +130,12 @@ int main() {
     for (auto &ln : lines)
         ins.push_back(parseLine(ln));
 
-    unordered_map<string, optional<long long>> cval;
+    ConstMap cval;
+    const uint32_t zero = sym("0");
 
-    auto getConst = [&](const string &s) -> optional<long long> {
-        if (isInteger(s)) return toInt(s);
-        auto it = cval.find(s);
-        if (it != cval.end()) return it->second;
+    auto getConst = [&](uint32_t id) -> optional<long long> {
+        if (literal[id]) return literal[id];
+        if (cval.count(id)) return cval.value[id];
         return nullopt;
     };
 
@@ -132,13 +165,12 @@ int main() {
                     else foldable = false;
 
                     if (foldable) {
-                        string newraw = I.lhs + " = " + to_string(res);
+                        string newraw = text(I.lhs) + " = " + to_string(res);
                         if (I.raw != newraw) { I.raw = newraw; changed = true; }
                         I.isBinary = false;
                         I.isAssign = true;
-                        I.op1 = to_string(res);
+                        I.op1 = sym(to_string(res));
                         I.op = "";
-                        I.op2 = "";
                         cval[I.lhs] = res;
                         continue;
                     }
@@ -146,106 +178,105 @@ int main() {
 
                 // Simplifications
                 if (I.op == "+" && ((c2 && *c2 == 0) || (c1 && *c1 == 0))) {
-                    string keep = (c2 && *c2 == 0) ? I.op1 : I.op2;
-                    string newraw = I.lhs + " = " + keep;
+                    uint32_t keep = (c2 && *c2 == 0) ? I.op1 : I.op2;
+                    string newraw = text(I.lhs) + " = " + text(keep);
                     if (I.raw != newraw) { I.raw = newraw; changed = true; }
                     I.isBinary = false;
                     I.isAssign = true;
                     I.op1 = keep;
-                    cval[I.lhs] = isInteger(keep) ? optional<long long>(toInt(keep)) : nullopt;
+                    cval[I.lhs] = literal[keep];
                     continue;
                 }
 
                 if (I.op == "-" && (c2 && *c2 == 0)) {
-                    string newraw = I.lhs + " = " + I.op1;
+                    string newraw = text(I.lhs) + " = " + text(I.op1);
                     if (I.raw != newraw) { I.raw = newraw; changed = true; }
                     I.isBinary = false;
                     I.isAssign = true;
-                    I.op1 = I.op1;
-                    cval[I.lhs] = isInteger(I.op1) ? optional<long long>(toInt(I.op1)) : nullopt;
+                    cval[I.lhs] = literal[I.op1];
                     continue;
                 }
 
                 if (I.op == "*") {
                     if ((c2 && *c2 == 1) || (c1 && *c1 == 1)) {
-                        string keep = (c2 && *c2 == 1) ? I.op1 : I.op2;
-                        string newraw = I.lhs + " = " + keep;
+                        uint32_t keep = (c2 && *c2 == 1) ? I.op1 : I.op2;
+                        string newraw = text(I.lhs) + " = " + text(keep);
                         if (I.raw != newraw) { I.raw = newraw; changed = true; }
                         I.isBinary = false;
                         I.isAssign = true;
                         I.op1 = keep;
-                        cval[I.lhs] = isInteger(keep) ? optional<long long>(toInt(keep)) : nullopt;
+                        cval[I.lhs] = literal[keep];
                         continue;
                     }
                     if ((c2 && *c2 == 0) || (c1 && *c1 == 0)) {
-                        string newraw = I.lhs + " = 0";
+                        string newraw = text(I.lhs) + " = 0";
                         if (I.raw != newraw) { I.raw = newraw; changed = true; }
                         I.isBinary = false;
                         I.isAssign = true;
-                        I.op1 = "0";
+                        I.op1 = zero;
                         cval[I.lhs] = 0;
                         continue;
                     }
                     if (c2 && *c2 > 0) {
                         int k;
                         if (isPowerOfTwo(*c2, k)) {
-                            string newraw = I.lhs + " = " + I.op1 + " << " + to_string(k);
+                            string newraw = text(I.lhs) + " = " + text(I.op1) + " << " + to_string(k);
                             if (I.raw != newraw) { I.raw = newraw; changed = true; }
-                            I.op = "<<"; I.op2 = to_string(k);
+                            I.op = "<<"; I.op2 = sym(to_string(k));
                             continue;
                         }
                     }
                     if (c1 && *c1 > 0) {
                         int k;
                         if (isPowerOfTwo(*c1, k)) {
-                            string newraw = I.lhs + " = " + I.op2 + " << " + to_string(k);
+                            string newraw = text(I.lhs) + " = " + text(I.op2) + " << " + to_string(k);
                             if (I.raw != newraw) { I.raw = newraw; changed = true; }
-                            I.op1 = I.op2; I.op = "<<"; I.op2 = to_string(k);
+                            I.op1 = I.op2; I.op = "<<"; I.op2 = sym(to_string(k));
                             continue;
                         }
                     }
                 }
 
                 if (I.op == "-" && I.op1 == I.op2) {
-                    string newraw = I.lhs + " = 0";
+                    string newraw = text(I.lhs) + " = 0";
                     if (I.raw != newraw) { I.raw = newraw; changed = true; }
                     I.isBinary = false;
                     I.isAssign = true;
-                    I.op1 = "0";
+                    I.op1 = zero;
                     cval[I.lhs] = 0;
                     continue;
                 }
 
                 // Substitute known constants
-                string left = I.op1, right = I.op2;
+                uint32_t left = I.op1, right = I.op2;
                 bool replaced = false;
-                if (!isInteger(left)) {
+                if (!literal[left]) {
                     auto c = getConst(left);
-                    if (c) { left = to_string(*c); replaced = true; }
+                    if (c) { left = sym(to_string(*c)); replaced = true; }
                 }
-                if (!isInteger(right)) {
+                if (!literal[right]) {
                     auto c = getConst(right);
-                    if (c) { right = to_string(*c); replaced = true; }
+                    if (c) { right = sym(to_string(*c)); replaced = true; }
                 }
                 if (replaced) {
-                    string newrhs = left + " " + I.op + " " + right;
-                    string newraw = I.lhs + " = " + newrhs;
+                    string newrhs = text(left) + " " + I.op + " " + text(right);
+                    string newraw = text(I.lhs) + " = " + newrhs;
                     if (I.raw != newraw) { I.raw = newraw; changed = true; }
                     I.op1 = left; I.op2 = right;
                 }
                 cval.erase(I.lhs);
             } else if (I.isAssign) {
-                if (isInteger(I.op1)) {
-                    long long v = toInt(I.op1);
+                if (literal[I.op1]) {
+                    long long v = *literal[I.op1];
                     if (!cval.count(I.lhs) || cval[I.lhs] != optional<long long>(v)) {
                         cval[I.lhs] = v;
                         changed = true;
                     }
                 } else {
-                    auto c = cval.find(I.op1);
-                    if (c != cval.end() && c->second.has_value()) {
-                        cval[I.lhs] = c->second;
-                        string newraw = I.lhs + " = " + to_string(*c->second);
+                    optional<long long> c = cval.count(I.op1) ? cval.value[I.op1] : nullopt;
+                    if (c.has_value()) {
+                        cval[I.lhs] = c;
+                        string newraw = text(I.lhs) + " = " + to_string(*c);
                         if (I.raw != newraw) { I.raw = newraw; changed = true; }
                     } else {
                         if (cval.count(I.lhs)) { cval.erase(I.lhs); changed = true; }
@@ -258,4 +289,5 @@ int main() {
     // Final output
     for (auto &I : ins)
         cout << I.raw << "\n";
+    intern_free(&symbols);
 }
@@ -1,8 +1,11 @@
-/* Parser for ex15: generates three-address code. Build: flex ex15.l && bison -d ex15.y && gcc ex15.tab.c lex.yy.c -o ex15 && ./ex15 */
+/* Parser for ex15: generates three-address code. Build: flex ex15.l && bison -d ex15.y && gcc -I../04-LexicalAnalysis ex15.tab.c lex.yy.c -o ex15 && ./ex15
+ * Every place (variable, temporary, constant) and label is an interned name from
+ * the symbols table, so places are shared and never copied or freed. */
 %{
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "interner.h"
 
 int yylex(void);
 void yyerror(const char *s);
@@ -10,26 +13,37 @@ void emit(const char* format, ...);
 
 int tempCount = 0;
 int labelCount = 0;
+intern_table symbols;
+
+/* Interned copy of a name built in buf */
+static const char *internName(const char *buf) {
+    uint32_t id = intern_cstr(&symbols, buf);
+    if (id == INTERN_NONE) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    return intern_name(&symbols, id);
+}
 
 /* Temporary and label generation */
-char *newTemp() {
+const char *newTemp() {
     char buf[16];
     sprintf(buf, "t%d", ++tempCount);
-    return strdup(buf);
+    return internName(buf);
 }
 
-char *newLabel() {
+const char *newLabel() {
     char buf[16];
     sprintf(buf, "L%d", ++labelCount);
-    return strdup(buf);
+    return internName(buf);
 }
 
 /* Label stack for control flow */
 #define LPSTACK_MAX 1024
-static char* label_stack[LPSTACK_MAX];
+static const char* label_stack[LPSTACK_MAX];
 static int label_top = 0;
 
-static void pushL(char *label) {
+static void pushL(const char *label) {
     if (label_top < LPSTACK_MAX)
         label_stack[label_top++] = label;
     else {
@@ -38,7 +52,7 @@ static void pushL(char *label) {
     }
 }
 
-static char* popL(void) {
+static const char* popL(void) {
     if (label_top <= 0) {
         fprintf(stderr, "label stack underflow\n");
         exit(1);
@@ -48,14 +62,16 @@ static char* popL(void) {
 %}
 
 %code requires {
+#include "interner.h"
 typedef struct {
-    char *place;
+    const char *place; /* interned */
 } node;
+extern intern_table symbols;
 }
 
 %union {
     int intval;
-    char *id;
+    uint32_t id; /* symbol id in symbols */
     node *nptr;
 }
 
@@ -100,9 +116,7 @@ expr_stmt:
 
 assignment:
       ID '=' expr {
-          emit("%s = %s", $1, $3->place);
-          free($1);
-          free($3->place);
+          emit("%s = %s", intern_name(&symbols, $1), $3->place);
           free($3);
       }
     ;
@@ -113,15 +127,13 @@ expr:
           $$ = malloc(sizeof(node));
           $$->place = newTemp();
           emit("%s = %s + %s", $$->place, $1->place, $3->place);
-          free($1->place); free($1);
-          free($3->place); free($3);
+          free($1); free($3);
       }
     | expr '-' term {
           $$ = malloc(sizeof(node));
           $$->place = newTemp();
           emit("%s = %s - %s", $$->place, $1->place, $3->place);
-          free($1->place); free($1);
-          free($3->place); free($3);
+          free($1); free($3);
       }
     ;
 
@@ -131,15 +143,13 @@ term:
           $$ = malloc(sizeof(node));
           $$->place = newTemp();
           emit("%s = %s * %s", $$->place, $1->place, $3->place);
-          free($1->place); free($1);
-          free($3->place); free($3);
+          free($1); free($3);
       }
     | term '/' factor {
           $$ = malloc(sizeof(node));
           $$->place = newTemp();
           emit("%s = %s / %s", $$->place, $1->place, $3->place);
-          free($1->place); free($1);
-          free($3->place); free($3);
+          free($1); free($3);
       }
     ;
 
@@ -148,63 +158,62 @@ factor:
           $$ = malloc(sizeof(node));
           char buf[32];
           sprintf(buf, "%d", $1);
-          $$->place = strdup(buf);
+          $$->place = internName(buf);
       }
     | ID {
           $$ = malloc(sizeof(node));
-          $$->place = strdup($1);
-          free($1);
+          $$->place = intern_name(&symbols, $1);
       }
     | '(' expr ')' { $$ = $2; }
     ;
 
 if_stmt:
       IF '(' b_expr ')' {
-          char *l_else = newLabel();
-          char *l_end = newLabel();
+          const char *l_else = newLabel();
+          const char *l_end = newLabel();
           emit("if %s == 0 goto %s", $3->place, l_else);
           pushL(l_end);
           pushL(l_else);
-          free($3->place); free($3);
+          free($3);
       }
       stmt ELSE {
-          char* l_else = popL();
-          char* l_end = popL();
+          const char *l_else = popL();
+          const char *l_end = popL();
           emit("goto %s", l_end);
           emit("%s:", l_else);
           pushL(l_end);
       }
       stmt {
-          char* l_end = popL();
+          const char *l_end = popL();
           emit("%s:", l_end);
       }
     | IF '(' b_expr ')' {
-          char *l_after = newLabel();
+          const char *l_after = newLabel();
           emit("if %s == 0 goto %s", $3->place, l_after);
           pushL(l_after);
-          free($3->place); free($3);
+          free($3);
       }
       stmt %prec IF_NO_ELSE {
-          char* l_after = popL();
+          const char *l_after = popL();
           emit("%s:", l_after);
       }
     ;
 
 while_stmt:
       {
-          char* l_start = newLabel();
+          const char *l_start = newLabel();
           emit("%s:", l_start);
           pushL(l_start);
       }
       WHILE '(' b_expr ')' {
-          char* l_end = newLabel();
+          const char *l_end = newLabel();
           emit("if %s == 0 goto %s", $4->place, l_end);
           pushL(l_end);
-          free($4->place); free($4);
+          free($4);
       }
       stmt {
-          char* l_end = popL();
-          char* l_start = popL();
+          const char *l_end = popL();
+          const char *l_start = popL();
           emit("goto %s", l_start);
           emit("%s:", l_end);
       }
@@ -215,43 +224,37 @@ b_expr:
           $$ = malloc(sizeof(node));
           $$->place = newTemp();
           emit("%s = %s == %s", $$->place, $1->place, $3->place);
-          free($1->place); free($1);
-          free($3->place); free($3);
+          free($1); free($3);
       }
     | expr NE expr {
           $$ = malloc(sizeof(node));
           $$->place = newTemp();
           emit("%s = %s != %s", $$->place, $1->place, $3->place);
-          free($1->place); free($1);
-          free($3->place); free($3);
+          free($1); free($3);
       }
     | expr '<' expr {
           $$ = malloc(sizeof(node));
           $$->place = newTemp();
           emit("%s = %s < %s", $$->place, $1->place, $3->place);
-          free($1->place); free($1);
-          free($3->place); free($3);
+          free($1); free($3);
       }
     | expr '>' expr {
           $$ = malloc(sizeof(node));
           $$->place = newTemp();
           emit("%s = %s > %s", $$->place, $1->place, $3->place);
-          free($1->place); free($1);
-          free($3->place); free($3);
+          free($1); free($3);
       }
     | expr LE expr {
           $$ = malloc(sizeof(node));
           $$->place = newTemp();
           emit("%s = %s <= %s", $$->place, $1->place, $3->place);
-          free($1->place); free($1);
-          free($3->place); free($3);
+          free($1); free($3);
       }
     | expr GE expr {
           $$ = malloc(sizeof(node));
           $$->place = newTemp();
           emit("%s = %s >= %s", $$->place, $1->place, $3->place);
-          free($1->place); free($1);
-          free($3->place); free($3);
+          free($1); free($3);
       }
     ;
 %%
@@ -268,6 +271,8 @@ void emit(const char* format, ...) {
 }
 
 int main(void) {
+    intern_init(&symbols);
     yyparse();
+    intern_free(&symbols);
     return 0;
 }
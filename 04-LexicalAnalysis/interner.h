@@ -0,0 +1,192 @@
+/* interner.h
+ * Identifier interning shared by the lexers (through token_stream.h), the
+ * TAC generator and the constant folding optimizer in 03-Optimization.
+ * Each distinct name is copied once into an arena and gets a dense id
+ * (0, 1, 2, ... in order of first sight), so names compare as integers and
+ * per-name data can live in plain arrays indexed by id. Header-only C, so
+ * the C++ tools and the C code flex and bison generate can all include it.
+ *
+ *   intern_table t; intern_init(&t);
+ *   uint32_t id = intern(&t, s, n);        INTERN_NONE only if out of memory
+ *   intern_name(&t, id)                    NUL-terminated; stays valid until intern_free
+ *   intern_length(&t, id), t.count
+ *   intern_free(&t);
+ *
+ * The table is open addressing with linear probing over (id + 1), holding
+ * each name's hash beside it so probes and rehashes rarely touch the bytes.
+ */
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERN_NONE 0xFFFFFFFFu
+#define INTERN_BLOCK_SIZE 65536
+
+/* Arena block; its bytes follow the header. Names never move once placed. */
+typedef struct intern_block
+{
+    struct intern_block *next;
+    size_t used, size;
+} intern_block;
+
+typedef struct
+{
+    const char **names; /* per id: the name in the arena */
+    uint32_t *lengths;
+    uint32_t *hashes;
+    uint32_t count, cap;
+    uint32_t *slots; /* id + 1, 0 for empty */
+    uint32_t slot_count;
+    intern_block *arena; /* block being filled, then older ones */
+} intern_table;
+
+static inline void intern_init(intern_table *t)
+{
+    memset(t, 0, sizeof(*t));
+}
+
+static inline void intern_free(intern_table *t)
+{
+    intern_block *b = t->arena, *next;
+    for (; b != NULL; b = next)
+    {
+        next = b->next;
+        free(b);
+    }
+    free(t->names);
+    free(t->lengths);
+    free(t->hashes);
+    free(t->slots);
+    memset(t, 0, sizeof(*t));
+}
+
+static inline uint32_t intern_hash(const char *s, size_t n)
+{
+    uint32_t h = 2166136261u;
+    size_t i;
+    for (i = 0; i < n; i++)
+        h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+/* Copies s[0..n) and a NUL into the arena; NULL if out of memory */
+static inline const char *intern_store(intern_table *t, const char *s, size_t n)
+{
+    intern_block *b = t->arena;
+    char *p;
+    if (b == NULL || b->size - b->used < n + 1)
+    {
+        size_t size = n + 1 > INTERN_BLOCK_SIZE ? n + 1 : INTERN_BLOCK_SIZE;
+        b = (intern_block *)malloc(sizeof(intern_block) + size);
+        if (b == NULL)
+            return NULL;
+        b->next = t->arena;
+        b->used = 0;
+        b->size = size;
+        t->arena = b;
+    }
+    p = (char *)(b + 1) + b->used;
+    memcpy(p, s, n);
+    p[n] = '\0';
+    b->used += n + 1;
+    return p;
+}
+
+/* Doubles the slot table, keeping the load factor under 1/2; 0 if out of memory */
+static inline int intern_rehash(intern_table *t)
+{
+    uint32_t count = t->slot_count ? t->slot_count * 2 : 1024, k, i;
+    uint32_t *slots = (uint32_t *)calloc(count, sizeof(uint32_t));
+    if (slots == NULL)
+        return 0;
+    for (k = 0; k < t->count; k++)
+    {
+        for (i = t->hashes[k] & (count - 1); slots[i]; i = (i + 1) & (count - 1))
+            ;
+        slots[i] = k + 1;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->slot_count = count;
+    return 1;
+}
+
+/* Id of s[0..n), or INTERN_NONE if it has not been interned */
+static inline uint32_t intern_find(const intern_table *t, const char *s, size_t n)
+{
+    uint32_t h, mask, i, id;
+    if (t->slot_count == 0)
+        return INTERN_NONE;
+    h = intern_hash(s, n);
+    mask = t->slot_count - 1;
+    for (i = h & mask; t->slots[i]; i = (i + 1) & mask)
+    {
+        id = t->slots[i] - 1;
+        if (t->hashes[id] == h && t->lengths[id] == n && !memcmp(t->names[id], s, n))
+            return id;
+    }
+    return INTERN_NONE;
+}
+
+/* Id of s[0..n), adding it on first sight; INTERN_NONE if out of memory */
+static inline uint32_t intern(intern_table *t, const char *s, size_t n)
+{
+    uint32_t h, mask, i, id;
+    const char *copy;
+    if (n > 0xFFFFFFFFu || t->count == INTERN_NONE - 1)
+        return INTERN_NONE;
+    if (t->count * 2 >= t->slot_count && !intern_rehash(t))
+        return INTERN_NONE;
+    h = intern_hash(s, n);
+    mask = t->slot_count - 1;
+    for (i = h & mask; t->slots[i]; i = (i + 1) & mask)
+    {
+        id = t->slots[i] - 1;
+        if (t->hashes[id] == h && t->lengths[id] == n && !memcmp(t->names[id], s, n))
+            return id;
+    }
+    if (t->count == t->cap)
+    {
+        uint32_t cap = t->cap ? t->cap * 2 : 1024;
+        void *p;
+        if ((p = realloc((void *)t->names, (size_t)cap * sizeof(char *))) != NULL)
+            t->names = (const char **)p;
+        if (p && (p = realloc(t->lengths, (size_t)cap * 4)) != NULL)
+            t->lengths = (uint32_t *)p;
+        if (p && (p = realloc(t->hashes, (size_t)cap * 4)) != NULL)
+            t->hashes = (uint32_t *)p;
+        if (p == NULL)
+            return INTERN_NONE;
+        t->cap = cap;
+    }
+    if ((copy = intern_store(t, s, n)) == NULL)
+        return INTERN_NONE;
+    id = t->count++;
+    t->names[id] = copy;
+    t->lengths[id] = (uint32_t)n;
+    t->hashes[id] = h;
+    t->slots[i] = id + 1;
+    return id;
+}
+
+/* Interns a NUL-terminated string */
+static inline uint32_t intern_cstr(intern_table *t, const char *s)
+{
+    return intern(t, s, strlen(s));
+}
+
+/* The name of id, NUL-terminated; id must come from this table */
+static inline const char *intern_name(const intern_table *t, uint32_t id)
+{
+    return t->names[id];
+}
+
+static inline uint32_t intern_length(const intern_table *t, uint32_t id)
+{
+    return t->lengths[id];
+}
+
+#endif
@@ -0,0 +1,206 @@
+// Keyword table generator: reads a keyword file (one word per line, '#' starts a comment) and writes a C header
+// with a minimal perfect hash over the words, so recognizing a keyword costs one hash and one compare.
+// Compile: g++ -O2 keyword_hash.cpp -o keyword_hash
+// ./keyword_hash keywords.txt > keywords.h                          (keyword_lookup, used by manual_lexer.cpp)
+// ./keyword_hash flex_keywords.txt --prefix flex_keyword > flex_keywords.h   (flex_keyword_lookup, flex_lexer.l)
+//
+// Hash and displace: each word's hash picks a bucket, and every bucket gets a displacement that moves its
+// words into free slots of a table exactly as long as the word list. The hash and slot functions below are
+// copied verbatim into the header, so the generator and the lexers always agree.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+using namespace std;
+
+static const char hashSource[] =
+    "static inline unsigned int PREFIX_hash(const char *s, size_t n, unsigned int seed)\n"
+    "{\n"
+    "    unsigned int h = seed ^ (unsigned int)n;\n"
+    "    for (size_t i = 0; i < n; i++)\n"
+    "        h = (h ^ (unsigned char)s[i]) * 16777619u;\n"
+    "    return h;\n"
+    "}\n"
+    "static inline unsigned int PREFIX_slot(unsigned int h, unsigned int displace, unsigned int size)\n"
+    "{\n"
+    "    h += displace * 0x9E3779B9u;\n"
+    "    h ^= h >> 15;\n"
+    "    h *= 0x2C1B3C6Du;\n"
+    "    h ^= h >> 13;\n"
+    "    return h % size;\n"
+    "}\n";
+
+// Same functions as hashSource, for the search
+static unsigned int wordHash(const char *s, size_t n, unsigned int seed)
+{
+    unsigned int h = seed ^ (unsigned int)n;
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+static unsigned int wordSlot(unsigned int h, unsigned int displace, unsigned int size)
+{
+    h += displace * 0x9E3779B9u;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 13;
+    return h % size;
+}
+
+struct PerfectHash
+{
+    unsigned int seed, buckets;
+    vector<unsigned int> displace; // per bucket
+    vector<int> word;              // per slot: index into the word list
+};
+
+// Places the largest buckets first; false if some bucket finds no displacement
+static bool place(const vector<string> &words, unsigned int seed, unsigned int buckets, PerfectHash &ph)
+{
+    unsigned int n = words.size();
+    vector<vector<int>> members(buckets);
+    vector<unsigned int> hashes(n);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        hashes[i] = wordHash(words[i].data(), words[i].size(), seed);
+        members[hashes[i] % buckets].push_back(i);
+    }
+    vector<unsigned int> order(buckets);
+    for (unsigned int b = 0; b < buckets; b++)
+        order[b] = b;
+    stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b)
+                { return members[a].size() > members[b].size(); });
+    ph.seed = seed;
+    ph.buckets = buckets;
+    ph.displace.assign(buckets, 0);
+    ph.word.assign(n, -1);
+    vector<unsigned int> slots;
+    for (unsigned int b : order)
+    {
+        if (members[b].empty())
+            break;
+        bool placed = false;
+        for (unsigned int d = 0; d < 65536 && !placed; d++)
+        {
+            slots.clear();
+            placed = true;
+            for (int w : members[b])
+            {
+                unsigned int s = wordSlot(hashes[w], d, n);
+                if (ph.word[s] != -1 || find(slots.begin(), slots.end(), s) != slots.end())
+                {
+                    placed = false;
+                    break;
+                }
+                slots.push_back(s);
+            }
+            if (placed)
+            {
+                ph.displace[b] = d;
+                for (size_t k = 0; k < slots.size(); k++)
+                    ph.word[slots[k]] = members[b][k];
+            }
+        }
+        if (!placed)
+            return false;
+    }
+    return true;
+}
+
+static void emit(const vector<string> &words, const PerfectHash &ph, const string &prefix, const char *source)
+{
+    string guard = prefix + "s_h";
+    for (char &c : guard)
+        c = toupper((unsigned char)c);
+    size_t minLen = words[0].size(), maxLen = 0;
+    for (const string &w : words)
+    {
+        minLen = min(minLen, w.size());
+        maxLen = max(maxLen, w.size());
+    }
+    const char *p = prefix.c_str();
+    printf("/* Generated by keyword_hash from %s; do not edit. */\n", source);
+    printf("#ifndef %s\n#define %s\n\n#include <stddef.h>\n#include <string.h>\n\n", guard.c_str(), guard.c_str());
+    printf("#define %s_COUNT %zu\n\n", guard.substr(0, guard.size() - 3).c_str(), words.size());
+    printf("/* Keywords in slot order */\nstatic const char *const %s_names[] = {", p);
+    for (size_t s = 0; s < words.size(); s++)
+        printf("%s%s\"%s\"", s ? "," : "", s % 8 ? " " : "\n    ", words[ph.word[s]].c_str());
+    printf("};\nstatic const unsigned char %s_lengths[] = {", p);
+    for (size_t s = 0; s < words.size(); s++)
+        printf("%s%s%zu", s ? "," : "", s % 16 ? " " : "\n    ", words[ph.word[s]].size());
+    printf("};\nstatic const unsigned short %s_displace[] = {", p);
+    for (size_t b = 0; b < ph.buckets; b++)
+        printf("%s%s%u", b ? "," : "", b % 16 ? " " : "\n    ", ph.displace[b]);
+    printf("};\n\n");
+    string code = hashSource;
+    for (size_t at; (at = code.find("PREFIX")) != string::npos;)
+        code.replace(at, 6, prefix);
+    fputs(code.c_str(), stdout);
+    printf("\n/* Slot of the keyword s[0..n) in %s_names, or -1 if s is not a keyword */\n", p);
+    printf("static inline int %s_lookup(const char *s, size_t n)\n{\n", p);
+    printf("    unsigned int h, slot;\n");
+    printf("    if (n < %zu || n > %zu)\n        return -1;\n", minLen, maxLen);
+    printf("    h = %s_hash(s, n, %uu);\n", p, ph.seed);
+    printf("    slot = %s_slot(h, %s_displace[h %% %uu], %zuu);\n", p, p, ph.buckets, words.size());
+    printf("    return %s_lengths[slot] == n && !memcmp(%s_names[slot], s, n) ? (int)slot : -1;\n}\n\n", p, p);
+    printf("#endif\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *file = NULL;
+    string prefix = "keyword";
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--prefix") && i + 1 < argc)
+            prefix = argv[++i];
+        else
+            file = argv[i];
+    }
+    if (file == NULL)
+    {
+        fprintf(stderr, "Usage: %s KEYWORD_FILE [--prefix NAME] > header.h\n", argv[0]);
+        return 1;
+    }
+    FILE *in = fopen(file, "r");
+    if (in == NULL)
+    {
+        fprintf(stderr, "Could not open %s\n", file);
+        return 1;
+    }
+    vector<string> words;
+    char line[256];
+    while (fgets(line, sizeof(line), in))
+    {
+        char *end = line + strcspn(line, "#\r\n");
+        while (end > line && (end[-1] == ' ' || end[-1] == '\t'))
+            end--;
+        char *start = line + strspn(line, " \t");
+        if (start >= end)
+            continue;
+        string w(start, end);
+        if (w.size() > 255)
+        {
+            fprintf(stderr, "Keyword too long: %s\n", w.c_str());
+            return 1;
+        }
+        if (find(words.begin(), words.end(), w) == words.end())
+            words.push_back(w);
+    }
+    fclose(in);
+    if (words.empty())
+    {
+        fprintf(stderr, "No keywords in %s\n", file);
+        return 1;
+    }
+    // About two words per bucket; a new seed is tried whenever a bucket cannot be placed
+    unsigned int buckets = (words.size() + 1) / 2;
+    PerfectHash ph;
+    for (unsigned int seed = 2166136261u;; seed = seed * 747796405u + 2891336453u)
+        if (place(words, seed, buckets, ph))
+            break;
+    emit(words, ph, prefix, file);
+    return 0;
+}
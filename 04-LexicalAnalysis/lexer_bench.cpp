@@ -0,0 +1,715 @@
+// Lexer benchmark: generates C sources of a chosen size and times the lexers on them.
+// Compile: g++ -O2 lexer_bench.cpp -o lexer_bench
+// ./lexer_bench [--size MB[,MB...]] [--reps N] [--seed S] [--csv FILE] [--keep DIR] [NAME=PATH...]
+// ./lexer_bench --generate MB OUT.c [--seed S]   only write a corpus
+//
+// Lexers, each skipped if its binary is missing (NAME=PATH points one elsewhere):
+//   manual_lexer               ./manual_lexer FILE -o -
+//   flex_lexer                 ./flex_lexer FILE
+//   flex_lexer_mmap            ./flex_lexer FILE --mmap
+//   flex_lexer_fast            ./flex_lexer_fast FILE --mmap          (flex -Cf build, see flex_lexer.l)
+//   advanced_pattern_matcher   ../05-PatternMatching/ex9 FILE
+// Every run writes to /dev/null; the report is the best of REPS runs. The lexers print different things
+// per token (flex_lexer, for one, skips brackets and arithmetic operators), so tokens/s is measured against
+// one reference count per corpus, the tokens of manual_lexer's binary stream (-b, see token_stream.h),
+// and is n/a when manual_lexer is missing. Each lexer's output lines are counted too, as a size of its
+// output. Instructions come from a hardware counter when perf events are available, and peak RSS is the
+// child's, including any output it buffers (manual_lexer's 1 MB writer). One CSV row per lexer and size
+// is appended to FILE (default lexer_bench.csv), so results can be tracked across commits.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#endif
+#include <string>
+#include <vector>
+#include "token_stream.h"
+using namespace std;
+
+static double seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift64*, so a seed gives the same corpus everywhere
+struct Rng
+{
+    unsigned long long s;
+    unsigned next()
+    {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return (unsigned)((s * 2685821657736338717ull) >> 32);
+    }
+    unsigned below(unsigned n) { return next() % n; }
+    bool chance(unsigned percent) { return below(100) < percent; }
+};
+
+// ---- Corpus generator ----
+
+static const char *const words[] = {
+    "buffer", "length", "count", "index", "node", "value", "state", "parser", "token", "symbol",
+    "table", "entry", "offset", "result", "context", "config", "stream", "handle", "cache", "queue",
+    "request", "header", "payload", "checksum", "thread", "window", "block", "record", "cursor", "limit"};
+static const char *const types[] = {"int", "char", "long", "short", "float", "double", "unsigned int",
+                                    "size_t", "const char *", "struct node *", "unsigned char", "void *"};
+static const char *const binaryOps[] = {"+", "-", "*", "/", "%", "<<", ">>", "&", "|", "^",
+                                        "&&", "||", "==", "!=", "<", ">", "<=", ">="};
+static const char *const assignOps[] = {"=", "+=", "-=", "*=", "|=", "&=", "<<="};
+static const char *const headers[] = {"stdio.h", "stdlib.h", "string.h", "stdint.h", "errno.h", "unistd.h"};
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+struct Gen
+{
+    Rng rng;
+    string out;
+    void put(const char *s) { out += s; }
+    void indent(int depth) { out.append(depth * 4, ' '); }
+    // One to four words, snake_case or camelCase: short locals up to long descriptive names
+    void identifier()
+    {
+        int parts = 1 + rng.below(4);
+        bool camel = rng.chance(30);
+        for (int i = 0; i < parts; i++)
+        {
+            string w = words[rng.below(COUNT(words))];
+            if (i > 0 && camel)
+                w[0] = (char)(w[0] - 'a' + 'A');
+            else if (i > 0)
+                out += '_';
+            out += w;
+        }
+        if (rng.chance(10))
+            out += to_string(rng.below(100));
+    }
+    void number()
+    {
+        char buf[32];
+        switch (rng.below(5))
+        {
+        case 0:
+            snprintf(buf, sizeof(buf), "0x%X", rng.next() & 0xFFFF);
+            break;
+        case 1:
+            snprintf(buf, sizeof(buf), "%u.%u", rng.below(1000), rng.below(100));
+            break;
+        case 2:
+            snprintf(buf, sizeof(buf), "%ue-%u", 1 + rng.below(9), 1 + rng.below(9));
+            break;
+        default:
+            snprintf(buf, sizeof(buf), "%u", rng.below(rng.chance(50) ? 10 : 100000));
+        }
+        out += buf;
+    }
+    void stringLiteral()
+    {
+        out += '"';
+        int n = 1 + rng.below(6);
+        for (int i = 0; i < n; i++)
+        {
+            out += i ? " " : "";
+            out += words[rng.below(COUNT(words))];
+        }
+        out += rng.chance(40) ? ": %d\\n\"" : "\"";
+    }
+    void operand()
+    {
+        unsigned k = rng.below(10);
+        if (k < 6)
+            identifier();
+        else if (k < 9)
+            number();
+        else
+        {
+            identifier();
+            put("(");
+            identifier();
+            put(")");
+        }
+    }
+    void expression(int terms)
+    {
+        operand();
+        for (int i = 1; i < terms; i++)
+        {
+            out += ' ';
+            out += binaryOps[rng.below(COUNT(binaryOps))];
+            out += ' ';
+            if (rng.chance(15))
+            {
+                put("(");
+                expression(2);
+                put(")");
+            }
+            else
+                operand();
+        }
+    }
+    void lineComment(int depth)
+    {
+        indent(depth);
+        put("// ");
+        int n = 3 + rng.below(8);
+        for (int i = 0; i < n; i++)
+        {
+            out += i ? " " : "";
+            out += words[rng.below(COUNT(words))];
+        }
+        out += '\n';
+    }
+    void statement(int depth)
+    {
+        unsigned k = rng.below(100);
+        if (k < 8)
+            lineComment(depth);
+        if (k < 30)
+        {
+            indent(depth);
+            out += types[rng.below(COUNT(types))];
+            out += ' ';
+            identifier();
+            put(" = ");
+            expression(1 + rng.below(3));
+            put(";\n");
+        }
+        else if (k < 55)
+        {
+            indent(depth);
+            identifier();
+            out += ' ';
+            out += assignOps[rng.below(COUNT(assignOps))];
+            out += ' ';
+            expression(1 + rng.below(4));
+            put(";\n");
+        }
+        else if (k < 65)
+        {
+            indent(depth);
+            put(rng.chance(50) ? "printf(" : "fprintf(stderr, ");
+            stringLiteral();
+            put(", ");
+            identifier();
+            put(");\n");
+        }
+        else if (k < 75 && depth < 4)
+        {
+            indent(depth);
+            put("if (");
+            expression(3);
+            put(")\n");
+            block(depth);
+            if (rng.chance(40))
+            {
+                indent(depth);
+                put("else\n");
+                block(depth);
+            }
+        }
+        else if (k < 83 && depth < 4)
+        {
+            indent(depth);
+            const char *v = "ijkl" + depth % 4;
+            put("for (int ");
+            out += *v;
+            put(" = 0; ");
+            out += *v;
+            put(" < ");
+            operand();
+            put("; ");
+            out += *v;
+            put("++)\n");
+            block(depth);
+        }
+        else if (k < 88 && depth < 4)
+        {
+            indent(depth);
+            put("while (");
+            expression(2);
+            put(")\n");
+            block(depth);
+        }
+        else if (k < 92)
+        {
+            indent(depth);
+            put("return ");
+            expression(1 + rng.below(3));
+            put(";\n");
+        }
+        else
+        {
+            indent(depth);
+            identifier();
+            put("(");
+            expression(1);
+            put(", ");
+            stringLiteral();
+            put(");\n");
+        }
+    }
+    void block(int depth)
+    {
+        indent(depth);
+        put("{\n");
+        int n = 1 + rng.below(5);
+        for (int i = 0; i < n; i++)
+            statement(depth + 1);
+        indent(depth);
+        put("}\n");
+    }
+    void blockComment()
+    {
+        put("/*\n");
+        int lines = 1 + rng.below(4);
+        for (int l = 0; l < lines; l++)
+        {
+            put(" *");
+            int n = 4 + rng.below(8);
+            for (int i = 0; i < n; i++)
+            {
+                out += ' ';
+                out += words[rng.below(COUNT(words))];
+            }
+            out += '\n';
+        }
+        put(" */\n");
+    }
+    void topLevel()
+    {
+        unsigned k = rng.below(100);
+        if (k < 10)
+        {
+            put("#include <");
+            out += headers[rng.below(COUNT(headers))];
+            put(">\n");
+        }
+        else if (k < 20)
+        {
+            put("#define ");
+            identifier();
+            out += ' ';
+            number();
+            out += '\n';
+        }
+        else if (k < 28)
+        {
+            put("struct ");
+            identifier();
+            put("\n{\n");
+            int n = 2 + rng.below(5);
+            for (int i = 0; i < n; i++)
+            {
+                indent(1);
+                out += types[rng.below(COUNT(types))];
+                out += ' ';
+                identifier();
+                put(";\n");
+            }
+            put("};\n\n");
+        }
+        else
+        {
+            if (rng.chance(50))
+                blockComment();
+            put(rng.chance(40) ? "static " : "");
+            out += types[rng.below(COUNT(types))];
+            out += ' ';
+            identifier();
+            put("(");
+            int params = rng.below(4);
+            for (int i = 0; i < params; i++)
+            {
+                out += i ? ", " : "";
+                out += types[rng.below(COUNT(types))];
+                out += ' ';
+                identifier();
+            }
+            put(")\n");
+            block(0);
+            out += '\n';
+        }
+    }
+};
+
+// Writes about bytes of C to path; false if it cannot be written
+static bool generateCorpus(const char *path, size_t bytes, unsigned long long seed)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL)
+        return false;
+    Gen g;
+    g.rng.s = seed * 0x9E3779B97F4A7C15ull + 1;
+    size_t written = 0;
+    bool ok = true;
+    while (written < bytes && ok)
+    {
+        g.out.clear();
+        while (g.out.size() < (1 << 16))
+            g.topLevel();
+        size_t n = min(g.out.size(), bytes - written);
+        // End on a line boundary so the last construct is not cut mid-token
+        if (n < g.out.size())
+            while (n > 0 && g.out[n - 1] != '\n')
+                n--;
+        if (n == 0)
+            break;
+        ok = fwrite(g.out.data(), 1, n, f) == n;
+        written += n;
+    }
+    return fclose(f) == 0 && ok;
+}
+
+// ---- Running the lexers ----
+
+struct Lexer
+{
+    const char *name;
+    string path;
+    vector<string> args; // "{}" is replaced by the input file
+};
+
+struct RunResult
+{
+    double seconds;
+    long peakRssKb;
+    long long instructions; // -1 if no counter
+    long long lines;        // output newlines, when counted
+    bool ok;
+};
+
+// Instruction counter for pid, starting at its exec; -1 where perf events are unavailable
+static int openInstructionCounter(pid_t pid)
+{
+#if defined(__linux__) && defined(SYS_perf_event_open)
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0);
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+// Runs lexer on input with stdout to /dev/null, or counted through a pipe if countLines
+static RunResult runLexer(const Lexer &lx, const char *input, bool countLines)
+{
+    RunResult r = {0, 0, -1, 0, false};
+    vector<string> args;
+    args.push_back(lx.path);
+    for (const string &a : lx.args)
+        args.push_back(a == "{}" ? string(input) : a);
+    vector<char *> argv;
+    for (string &a : args)
+        argv.push_back(&a[0]);
+    argv.push_back(NULL);
+
+    int go[2], out[2] = {-1, -1};
+    if (pipe(go) != 0)
+        return r;
+    if (countLines && pipe(out) != 0)
+    {
+        close(go[0]);
+        close(go[1]);
+        return r;
+    }
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        for (int fd : {go[0], go[1], out[0], out[1]})
+            if (fd >= 0)
+                close(fd);
+        return r;
+    }
+    if (pid == 0)
+    {
+        // Wait until the parent has attached the counter, then become the lexer
+        char c;
+        close(go[1]);
+        if (read(go[0], &c, 1) != 1)
+            _exit(127);
+        close(go[0]);
+        int null = open("/dev/null", O_RDWR);
+        dup2(null, 0);
+        dup2(countLines ? out[1] : null, 1);
+        dup2(null, 2);
+        if (countLines)
+        {
+            close(out[0]);
+            close(out[1]);
+        }
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    close(go[0]);
+    if (countLines)
+        close(out[1]);
+    int counter = openInstructionCounter(pid);
+    double t0 = seconds();
+    if (write(go[1], "g", 1) != 1)
+        kill(pid, SIGKILL);
+    close(go[1]);
+    if (countLines)
+    {
+        static char buf[1 << 16];
+        ssize_t n;
+        while ((n = read(out[0], buf, sizeof(buf))) > 0)
+            for (ssize_t i = 0; i < n; i++)
+                r.lines += buf[i] == '\n';
+        close(out[0]);
+    }
+    int status;
+    struct rusage ru;
+    if (wait4(pid, &status, 0, &ru) != pid)
+        return r;
+    r.seconds = seconds() - t0;
+    r.peakRssKb = ru.ru_maxrss;
+    if (counter >= 0)
+    {
+        long long count;
+        if (read(counter, &count, sizeof(count)) == (ssize_t)sizeof(count))
+            r.instructions = count;
+        close(counter);
+    }
+    r.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return r;
+}
+
+static bool executable(const string &path)
+{
+    return access(path.c_str(), X_OK) == 0;
+}
+
+// Tokens in corpus by manual_lexer's binary stream, written next to it and removed; -1 if it fails
+static long long referenceTokens(const string &manualLexer, const char *corpus)
+{
+    string tok = string(corpus) + ".tok";
+    Lexer ref = {"manual_lexer -b", manualLexer, {"{}", "-b", tok}};
+    ts_stream ts;
+    const char *err;
+    long long count = -1;
+    if (executable(manualLexer) && runLexer(ref, corpus, false).ok && ts_open(&ts, tok.c_str(), &err) == 0)
+    {
+        count = ts.count;
+        ts_close(&ts);
+    }
+    unlink(tok.c_str());
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    vector<double> sizes;
+    int reps = 3;
+    unsigned long long seed = 1;
+    const char *csvPath = "lexer_bench.csv", *keepDir = NULL, *generatePath = NULL;
+    vector<Lexer> lexers = {
+        {"manual_lexer", "./manual_lexer", {"{}", "-o", "-"}},
+        {"flex_lexer", "./flex_lexer", {"{}"}},
+        {"flex_lexer_mmap", "./flex_lexer", {"{}", "--mmap"}},
+        {"flex_lexer_fast", "./flex_lexer_fast", {"{}", "--mmap"}},
+        {"advanced_pattern_matcher", "../05-PatternMatching/ex9", {"{}"}},
+    };
+    for (int i = 1; i < argc; i++)
+    {
+        const char *eq = strchr(argv[i], '=');
+        if (!strcmp(argv[i], "--size") && i + 1 < argc)
+        {
+            for (char *p = argv[++i]; *p;)
+            {
+                char *end;
+                sizes.push_back(strtod(p, &end));
+                p = *end == ',' ? end + 1 : end + strlen(end);
+            }
+        }
+        else if (!strcmp(argv[i], "--generate") && i + 2 < argc)
+        {
+            sizes.assign(1, atof(argv[++i]));
+            generatePath = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--reps") && i + 1 < argc)
+            reps = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--csv") && i + 1 < argc)
+            csvPath = argv[++i];
+        else if (!strcmp(argv[i], "--keep") && i + 1 < argc)
+            keepDir = argv[++i];
+        else if (eq != NULL && argv[i][0] != '-')
+        {
+            string name(argv[i], eq - argv[i]);
+            bool found = false;
+            // flex_lexer=PATH also moves the --mmap run of the same binary
+            for (Lexer &lx : lexers)
+                if (name == lx.name || (name == "flex_lexer" && !strcmp(lx.name, "flex_lexer_mmap")))
+                {
+                    lx.path = eq + 1;
+                    found = true;
+                }
+            if (!found)
+            {
+                fprintf(stderr, "Unknown lexer %s\n", name.c_str());
+                return 1;
+            }
+        }
+        else
+        {
+            fprintf(stderr,
+                    "Usage: %s [--size MB[,MB...]] [--reps N] [--seed S] [--csv FILE] [--keep DIR] [NAME=PATH...]\n"
+                    "       %s --generate MB OUT.c [--seed S]\n",
+                    argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (sizes.empty())
+        sizes = {1, 16};
+    if (generatePath != NULL)
+    {
+        if (!generateCorpus(generatePath, (size_t)(sizes[0] * 1e6), seed))
+        {
+            fprintf(stderr, "Could not write %s\n", generatePath);
+            return 1;
+        }
+        return 0;
+    }
+
+    vector<Lexer> present;
+    for (const Lexer &lx : lexers)
+    {
+        if (executable(lx.path))
+            present.push_back(lx);
+        else
+            printf("skipping %s: %s not built\n", lx.name, lx.path.c_str());
+    }
+    if (present.empty())
+    {
+        fprintf(stderr, "No lexer binaries found; build them first (see README.md)\n");
+        return 1;
+    }
+
+    char tmpl[] = "/tmp/lexer_bench.XXXXXX";
+    const char *dir = keepDir;
+    if (dir == NULL && (dir = mkdtemp(tmpl)) == NULL)
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    const char *csvHeader = "unix_time,lexer,corpus_bytes,seed,reps,seconds,mb_per_s,tokens,tokens_per_s,"
+                            "instructions_per_byte,peak_rss_kb\n";
+    struct stat st;
+    bool newCsv = stat(csvPath, &st) != 0 || st.st_size == 0;
+    FILE *csv = fopen(csvPath, newCsv ? "w" : "r+");
+    if (csv == NULL)
+    {
+        fprintf(stderr, "Could not open %s\n", csvPath);
+        return 1;
+    }
+    // Rows only go under the same columns
+    char header[256];
+    if (!newCsv && (fgets(header, sizeof(header), csv) == NULL || strcmp(header, csvHeader) != 0))
+    {
+        fprintf(stderr, "%s has other columns; pick a new file with --csv\n", csvPath);
+        fclose(csv);
+        return 1;
+    }
+    fseek(csv, 0, SEEK_END);
+    if (newCsv)
+        fputs(csvHeader, csv);
+    long long now = (long long)time(NULL);
+    int failures = 0;
+
+    for (double mb : sizes)
+    {
+        char corpus[4096];
+        snprintf(corpus, sizeof(corpus), "%s/corpus_%gMB_seed%llu.c", dir, mb, seed);
+        if (stat(corpus, &st) != 0 && !generateCorpus(corpus, (size_t)(mb * 1e6), seed))
+        {
+            fprintf(stderr, "Could not write %s\n", corpus);
+            return 1;
+        }
+        stat(corpus, &st);
+        double bytes = (double)st.st_size;
+        long long tokens = referenceTokens(lexers[0].path, corpus); // lexers[0] is manual_lexer
+        printf("\n%s: %.1f MB", corpus, bytes / 1e6);
+        if (tokens >= 0)
+            printf(", %lld tokens (manual_lexer -b)", tokens);
+        printf(", best of %d\n", reps);
+        printf("%-26s %9s %10s %12s %12s %11s\n", "lexer", "MB/s", "Mtokens/s", "output lines", "instr/byte",
+               "peak RSS");
+        for (const Lexer &lx : present)
+        {
+            RunResult counted = runLexer(lx, corpus, true);
+            if (!counted.ok)
+            {
+                printf("%-26s failed\n", lx.name);
+                failures++;
+                continue;
+            }
+            RunResult best = {0, 0, -1, 0, false};
+            long peakRss = counted.peakRssKb;
+            for (int r = 0; r < reps; r++)
+            {
+                RunResult run = runLexer(lx, corpus, false);
+                if (!run.ok)
+                    continue;
+                peakRss = max(peakRss, run.peakRssKb);
+                if (!best.ok || run.seconds < best.seconds)
+                    best = run;
+            }
+            if (!best.ok)
+            {
+                printf("%-26s failed\n", lx.name);
+                failures++;
+                continue;
+            }
+            char ipb[32] = "n/a", ipbCsv[32] = "";
+            if (best.instructions >= 0)
+            {
+                snprintf(ipb, sizeof(ipb), "%.1f", best.instructions / bytes);
+                snprintf(ipbCsv, sizeof(ipbCsv), "%.3f", best.instructions / bytes);
+            }
+            char tps[32] = "n/a", tokensCsv[32] = "", tpsCsv[32] = "";
+            if (tokens >= 0)
+            {
+                snprintf(tps, sizeof(tps), "%.2f", tokens / best.seconds / 1e6);
+                snprintf(tokensCsv, sizeof(tokensCsv), "%lld", tokens);
+                snprintf(tpsCsv, sizeof(tpsCsv), "%.0f", tokens / best.seconds);
+            }
+            printf("%-26s %9.1f %10s %12lld %12s %8ld KB\n", lx.name, bytes / best.seconds / 1e6, tps,
+                   counted.lines, ipb, peakRss);
+            fprintf(csv, "%lld,%s,%.0f,%llu,%d,%.6f,%.3f,%s,%s,%s,%ld\n", now, lx.name, bytes, seed, reps,
+                    best.seconds, bytes / best.seconds / 1e6, tokensCsv, tpsCsv, ipbCsv, peakRss);
+        }
+    }
+    fclose(csv);
+    if (keepDir == NULL)
+    {
+        for (double mb : sizes)
+        {
+            char corpus[4096];
+            snprintf(corpus, sizeof(corpus), "%s/corpus_%gMB_seed%llu.c", dir, mb, seed);
+            unlink(corpus);
+        }
+        rmdir(dir);
+    }
+    printf("\nResults appended to %s\n", csvPath);
+    return failures ? 1 : 0;
+}
@@ -1,9 +1,34 @@
-// Lexical analyzer: tokenizes C code into keywords, identifiers, operators, literals. Compile: g++ i.cpp -o i && ./i
+// Lexical analyzer: tokenizes C code into keywords, identifiers, operators, literals.
+// Compile: ./keyword_hash keywords.txt > keywords.h && g++ -O2 -pthread manual_lexer.cpp -o manual_lexer && ./manual_lexer
+// ./manual_lexer FILE [-o OUT] [--skip-comments]  tokenize FILE into OUT (default output.txt, - for stdout)
+// ./manual_lexer FILE -b OUT.tok      write a binary token stream instead (see token_stream.h, token_dump.cpp)
+// ./manual_lexer FILE ... -j N        lex on N threads (0: one per core); output is the same as with one
+// ./manual_lexer --check FILE         compare the DFA scanner with the reference scanner line by line,
+//                                     and the block scanner with nextToken on the whole file
+// ./manual_lexer --bench FILE [REPS]  throughput of both scanners
+// ./manual_lexer --bench-simd FILE [REPS]      scalar against SSE2/AVX2 scanning loops
+// ./manual_lexer --bench-keywords FILE [REPS]  the strcmp chain against the perfect hash, on FILE's words
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "keywords.h" // ./keyword_hash keywords.txt > keywords.h
+#include "token_stream.h"
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
 bool isDelimiter(char ch)
 {
     return (ch == ' ' || ch == '+' || ch == '-' || ch == '*' ||
@@ -79,7 +104,8 @@ char *subString(char *str, int left, int right)
     subStr[right - left + 1] = '\0';
     return subStr;
 }
-void parse(char *str, FILE *outputFile)
+// The original delimiter/strcmp scanner, kept for --check and --bench
+void parseReference(char *str, FILE *outputFile)
 {
     int left = 0, right = 0;
     int len = strlen(str);
@@ -159,110 +185,1292 @@ void parse(char *str, FILE *outputFile)
     }
     return;
 }
-void parseAndPrint(char *str)
+// Table-driven scanner. Every byte maps to a character class and a DFA over
+// the classes finds the end of each lexeme; tokens are (kind, offset, length)
+// views into the input, so nothing is copied or allocated while scanning.
+// Words are maximal runs of non-delimiter bytes, as in parseReference.
+enum TokenKind
 {
-    int left = 0, right = 0;
-    int len = strlen(str);
-    bool expectingIdentifier = false;
-    while (right <= len && left <= right)
+    TOK_KEYWORD,
+    TOK_IDENTIFIER,
+    TOK_INVALID_IDENTIFIER,
+    TOK_INTEGER,
+    TOK_REAL,
+    TOK_OPERATOR,
+    TOK_PUNCTUATION
+};
+struct Token
+{
+    unsigned char kind;
+    unsigned int offset;
+    unsigned int length;
+};
+enum CharClass
+{
+    CC_SPACE,
+    CC_WORD, // any byte that is not a digit, '.', blank or delimiter
+    CC_DIGIT,
+    CC_DOT,
+    CC_OPERATOR,
+    CC_PUNCT,
+    CC_COUNT
+};
+enum DfaState
+{
+    S_START,
+    S_SPACE,
+    S_OPERATOR,
+    S_PUNCT,
+    S_IDENT,
+    S_INTEGER,
+    S_REAL,
+    S_DOT_REAL, // a real starting with '.', which is a name if letters follow
+    S_BAD,      // starts with a digit but is not a number
+    S_COUNT,
+    S_DONE = S_COUNT
+};
+static const unsigned char transition[S_COUNT][CC_COUNT] = {
+    //              SPACE    WORD     DIGIT      DOT     OPERATOR    PUNCT
+    /* START    */ {S_SPACE, S_IDENT, S_INTEGER, S_DOT_REAL, S_OPERATOR, S_PUNCT},
+    /* SPACE    */ {S_SPACE, S_DONE, S_DONE, S_DONE, S_DONE, S_DONE},
+    /* OPERATOR */ {S_DONE, S_DONE, S_DONE, S_DONE, S_DONE, S_DONE},
+    /* PUNCT    */ {S_DONE, S_DONE, S_DONE, S_DONE, S_DONE, S_DONE},
+    /* IDENT    */ {S_DONE, S_IDENT, S_IDENT, S_IDENT, S_DONE, S_DONE},
+    /* INTEGER  */ {S_DONE, S_BAD, S_INTEGER, S_REAL, S_DONE, S_DONE},
+    /* REAL     */ {S_DONE, S_BAD, S_REAL, S_REAL, S_DONE, S_DONE},
+    /* DOT_REAL */ {S_DONE, S_IDENT, S_DOT_REAL, S_DOT_REAL, S_DONE, S_DONE},
+    /* BAD      */ {S_DONE, S_BAD, S_BAD, S_BAD, S_DONE, S_DONE},
+};
+// The first n bytes at s (n <= 8) as an integer, the rest zero; reads 8
+static inline uint64_t wordPrefix(const unsigned char *s, size_t n)
+{
+    uint64_t x;
+    memcpy(&x, s, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return x & ~(~0ULL >> (8 * n));
+#else
+    return x & (~0ULL >> (64 - 8 * n));
+#endif
+}
+struct KeywordSlot
+{
+    uint64_t prefix;
+    unsigned char length; // 0: empty
+};
+// The class matrix above expanded to one row of 256 bytes per state, so the
+// scan loop does a single lookup per input byte. Keywords of up to 8 bytes
+// also go into a 256-slot table keyed by their bytes as one integer, with a
+// multiplier picked at startup so that no two share a slot: with 8 bytes
+// readable, a lookup is one load, a multiply and one compare. The search is
+// bounded: past a few dozen keywords a collision-free multiplier gets rare,
+// and the lookup falls back to the perfect hash.
+struct ScannerTables
+{
+    unsigned char cls[256];
+    unsigned char next[S_COUNT][256];
+    unsigned int keywordLengths[256]; // bit n: some keyword of length n starts with this byte
+    KeywordSlot keywordSlots[256];
+    uint64_t keywordMultiplier;
+    bool shortKeywords; // every keyword is in the slot table
+    ScannerTables()
     {
-
-        if (!isDelimiter(str[right]))
-
-            right++;
-
-        if (isDelimiter(str[right]) && left == right)
+        for (int c = 0; c < 256; c++)
+            cls[c] = CC_WORD;
+        for (int c = '0'; c <= '9'; c++)
+            cls[c] = CC_DIGIT;
+        cls['.'] = CC_DOT;
+        for (const char *p = " \t\n\r\v\f"; *p; p++)
+            cls[(unsigned char)*p] = CC_SPACE;
+        for (const char *p = "+-*/<>="; *p; p++)
+            cls[(unsigned char)*p] = CC_OPERATOR;
+        for (const char *p = ",;()[]{}"; *p; p++)
+            cls[(unsigned char)*p] = CC_PUNCT;
+        for (int st = 0; st < S_COUNT; st++)
+            for (int c = 0; c < 256; c++)
+                next[st][c] = transition[st][cls[c]];
+        memset(keywordLengths, 0, sizeof(keywordLengths));
+        for (int k = 0; k < KEYWORD_COUNT; k++)
+            if (keyword_lengths[k] < 32)
+                keywordLengths[(unsigned char)keyword_names[k][0]] |= 1u << keyword_lengths[k];
+        shortKeywords = true;
+        for (int k = 0; k < KEYWORD_COUNT; k++)
+            shortKeywords = shortKeywords && keyword_lengths[k] >= 1 && keyword_lengths[k] <= 8;
+        keywordMultiplier = 0x9E3779B97F4A7C15ull;
+        for (int tries = 1; shortKeywords && !placeKeywords(); tries++)
         {
+            if (tries == 1 << 16)
+                shortKeywords = false;
+            keywordMultiplier = (keywordMultiplier * 6364136223846793005ull + 1442695040888963407ull) | 1;
+        }
+    }
+    unsigned int keywordSlot(uint64_t prefix) const
+    {
+        return (unsigned int)((prefix * keywordMultiplier) >> 56);
+    }
+    bool placeKeywords()
+    {
+        memset(keywordSlots, 0, sizeof(keywordSlots));
+        for (int k = 0; k < KEYWORD_COUNT; k++)
+        {
+            unsigned char padded[8] = {0};
+            size_t n = keyword_lengths[k];
+            if (n == 0 || n > 8)
+                continue;
+            memcpy(padded, keyword_names[k], n);
+            uint64_t prefix = wordPrefix(padded, n);
+            KeywordSlot &slot = keywordSlots[keywordSlot(prefix)];
+            if (slot.length != 0)
+                return false;
+            slot.prefix = prefix;
+            slot.length = (unsigned char)n;
+        }
+        return true;
+    }
+};
+static const ScannerTables tables;
+// Whether s[0..n) is in keywords.txt; readable is how many bytes from s on
+// may be read. With 8 readable bytes and no keyword longer than 8, this is
+// the slot table alone: a longer word compares its first 8 bytes and then
+// fails on the length. Otherwise the first-byte/length mask and then the
+// generated perfect hash.
+static inline bool isKeywordSpan(const char *s, unsigned int n, size_t readable)
+{
+    if (readable >= 8 && tables.shortKeywords)
+    {
+        uint64_t prefix = wordPrefix((const unsigned char *)s, n < 8 ? n : 8);
+        const KeywordSlot &slot = tables.keywordSlots[tables.keywordSlot(prefix)];
+        return (slot.prefix == prefix) & (slot.length == n);
+    }
+    return n < 32 && (tables.keywordLengths[(unsigned char)s[0]] >> n & 1) && keyword_lookup(s, n) >= 0;
+}
+// Run-length primitives behind the lexer's hot loops. The scalar versions
+// follow the class table; the SSE2 and AVX2 versions test 16 or 32 bytes at
+// a time against the same sets written as byte ranges, and finish the last
+// partial block with the scalar code. The best set is picked at startup.
+struct ScanKernels
+{
+    const char *name;
+    size_t (*spaceRun)(const unsigned char *p, size_t n);   // length of the blank run at p
+    size_t (*wordRun)(const unsigned char *p, size_t n);    // bytes before a blank, operator or punctuation
+    size_t (*commentEnd)(const unsigned char *p, size_t n); // offset of the first "*/", or n
+    size_t (*newlines)(const unsigned char *p, size_t n);
+    // Bit i of *word is set if p[i] can be part of a word (not a blank or
+    // delimiter), of *delim if it is an operator or punctuation; 64 bytes
+    void (*classify)(const unsigned char *p, uint64_t *word, uint64_t *delim);
+};
+static size_t spaceRunScalar(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+    while (i < n && tables.cls[p[i]] == CC_SPACE)
+        i++;
+    return i;
+}
+static size_t wordRunScalar(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+    while (i < n && tables.cls[p[i]] != CC_SPACE && tables.cls[p[i]] < CC_OPERATOR)
+        i++;
+    return i;
+}
+static size_t commentEndScalar(const unsigned char *p, size_t n)
+{
+    for (size_t i = 0; i + 1 < n; i++)
+        if (p[i] == '*' && p[i + 1] == '/')
+            return i;
+    return n;
+}
+static size_t newlinesScalar(const unsigned char *p, size_t n)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++)
+        count += p[i] == '\n';
+    return count;
+}
+// The masks of p[0..n), n <= 64; bits from n up are clear
+static void classifyScalar(const unsigned char *p, size_t n, uint64_t *word, uint64_t *delim)
+{
+    uint64_t w = 0, d = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned char c = tables.cls[p[i]];
+        w |= (uint64_t)(c != CC_SPACE && c < CC_OPERATOR) << i;
+        d |= (uint64_t)(c >= CC_OPERATOR) << i;
+    }
+    *word = w;
+    *delim = d;
+}
+static void classifyBlockScalar(const unsigned char *p, uint64_t *word, uint64_t *delim)
+{
+    classifyScalar(p, 64, word, delim);
+}
+static const ScanKernels scalarKernels = {"scalar", spaceRunScalar, wordRunScalar, commentEndScalar, newlinesScalar,
+                                          classifyBlockScalar};
 
-            if (isOperator(str[right]))
-
-                printf("'%c' IS AN OPERATOR\n", str[right]);
+#if defined(__x86_64__) || defined(__i386__)
+// Blanks are 9-13 and ' '; the delimiters add ( ) * + , - (40-45), '/',
+// ; < = > (59-62), [ ] { }. Keep these in step with ScannerTables.
+static inline __m128i inRange128(__m128i x, char lo, char hi)
+{
+    __m128i d = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(hi - lo)), d);
+}
+static inline __m128i spaceMask128(__m128i x)
+{
+    return _mm_or_si128(inRange128(x, 9, 13), _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+}
+static inline __m128i delimiterMask128(__m128i x)
+{
+    __m128i m = _mm_or_si128(spaceMask128(x), inRange128(x, '(', '-'));
+    m = _mm_or_si128(m, inRange128(x, ';', '>'));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('/')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('[')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8(']')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('{')));
+    return _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('}')));
+}
+static size_t spaceRunSse2(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        unsigned int m = ~_mm_movemask_epi8(spaceMask128(_mm_loadu_si128((const __m128i *)(p + i)))) & 0xFFFF;
+        if (m)
+            return i + __builtin_ctz(m);
+    }
+    return i + spaceRunScalar(p + i, n - i);
+}
+static size_t wordRunSse2(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        unsigned int m = _mm_movemask_epi8(delimiterMask128(_mm_loadu_si128((const __m128i *)(p + i))));
+        if (m)
+            return i + __builtin_ctz(m);
+    }
+    return i + wordRunScalar(p + i, n - i);
+}
+static size_t commentEndSse2(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 17 <= n; i += 16)
+    {
+        __m128i star = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), _mm_set1_epi8('*'));
+        __m128i slash = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i + 1)), _mm_set1_epi8('/'));
+        unsigned int m = _mm_movemask_epi8(_mm_and_si128(star, slash));
+        if (m)
+            return i + __builtin_ctz(m);
+    }
+    return i + commentEndScalar(p + i, n - i);
+}
+static size_t newlinesSse2(const unsigned char *p, size_t n)
+{
+    size_t i = 0, count = 0;
+    for (; i + 16 <= n; i += 16)
+        count += __builtin_popcount(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), _mm_set1_epi8('\n'))));
+    return count + newlinesScalar(p + i, n - i);
+}
+static void classifySse2(const unsigned char *p, uint64_t *word, uint64_t *delim)
+{
+    uint64_t w = 0, d = 0;
+    for (int k = 0; k < 4; k++)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)(p + 16 * k));
+        unsigned int blank = _mm_movemask_epi8(spaceMask128(x));
+        unsigned int any = _mm_movemask_epi8(delimiterMask128(x));
+        w |= (uint64_t)(~any & 0xFFFF) << (16 * k);
+        d |= (uint64_t)(any & ~blank) << (16 * k);
+    }
+    *word = w;
+    *delim = d;
+}
+static const ScanKernels sse2Kernels = {"sse2", spaceRunSse2, wordRunSse2, commentEndSse2, newlinesSse2, classifySse2};
 
-            right++;
+#define AVX2 __attribute__((target("avx2")))
+AVX2 static inline __m256i inRange256(__m256i x, char lo, char hi)
+{
+    __m256i d = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(hi - lo)), d);
+}
+AVX2 static inline __m256i spaceMask256(__m256i x)
+{
+    return _mm256_or_si256(inRange256(x, 9, 13), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+}
+AVX2 static inline __m256i delimiterMask256(__m256i x)
+{
+    __m256i m = _mm256_or_si256(spaceMask256(x), inRange256(x, '(', '-'));
+    m = _mm256_or_si256(m, inRange256(x, ';', '>'));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('/')));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('[')));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(']')));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('{')));
+    return _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('}')));
+}
+AVX2 static size_t spaceRunAvx2(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        unsigned int m = ~(unsigned int)_mm256_movemask_epi8(spaceMask256(_mm256_loadu_si256((const __m256i *)(p + i))));
+        if (m)
+            return i + __builtin_ctz(m);
+    }
+    return i + spaceRunSse2(p + i, n - i);
+}
+AVX2 static size_t wordRunAvx2(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        unsigned int m = _mm256_movemask_epi8(delimiterMask256(_mm256_loadu_si256((const __m256i *)(p + i))));
+        if (m)
+            return i + __builtin_ctz(m);
+    }
+    return i + wordRunSse2(p + i, n - i);
+}
+AVX2 static size_t commentEndAvx2(const unsigned char *p, size_t n)
+{
+    size_t i = 0;
+    for (; i + 33 <= n; i += 32)
+    {
+        __m256i star = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i)), _mm256_set1_epi8('*'));
+        __m256i slash = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i + 1)), _mm256_set1_epi8('/'));
+        unsigned int m = _mm256_movemask_epi8(_mm256_and_si256(star, slash));
+        if (m)
+            return i + __builtin_ctz(m);
+    }
+    return i + commentEndSse2(p + i, n - i);
+}
+AVX2 static size_t newlinesAvx2(const unsigned char *p, size_t n)
+{
+    size_t i = 0, count = 0;
+    for (; i + 32 <= n; i += 32)
+        count += __builtin_popcount(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i)), _mm256_set1_epi8('\n'))));
+    return count + newlinesSse2(p + i, n - i);
+}
+AVX2 static void classifyAvx2(const unsigned char *p, uint64_t *word, uint64_t *delim)
+{
+    __m256i lo = _mm256_loadu_si256((const __m256i *)p), hi = _mm256_loadu_si256((const __m256i *)(p + 32));
+    uint64_t blank = (uint32_t)_mm256_movemask_epi8(spaceMask256(lo)) |
+                     (uint64_t)(uint32_t)_mm256_movemask_epi8(spaceMask256(hi)) << 32;
+    uint64_t any = (uint32_t)_mm256_movemask_epi8(delimiterMask256(lo)) |
+                   (uint64_t)(uint32_t)_mm256_movemask_epi8(delimiterMask256(hi)) << 32;
+    *word = ~any;
+    *delim = any & ~blank;
+}
+static const ScanKernels avx2Kernels = {"avx2", spaceRunAvx2, wordRunAvx2, commentEndAvx2, newlinesAvx2, classifyAvx2};
+#endif
 
-            left = right;
+// Kernel sets this CPU can run, slowest first
+int availableKernels(const ScanKernels **out)
+{
+    int n = 0;
+    out[n++] = &scalarKernels;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        out[n++] = &sse2Kernels;
+    if (__builtin_cpu_supports("avx2"))
+        out[n++] = &avx2Kernels;
+#endif
+    return n;
+}
+ScanKernels bestKernels()
+{
+    const ScanKernels *sets[3];
+    return *sets[availableKernels(sets) - 1];
+}
+static ScanKernels scan = bestKernels();
+struct Lexer
+{
+    const char *src;
+    size_t len, pos;
+    bool expectingIdentifier; // the previous word was a keyword
+    bool skipComments;        // treat // and /* */ comments as blanks
+};
+void lexerInit(Lexer *lx, const char *src, size_t len)
+{
+    lx->src = src;
+    lx->len = len;
+    lx->pos = 0;
+    lx->expectingIdentifier = false;
+    lx->skipComments = false;
+}
+// Whatever follows a keyword is read as a declared name
+unsigned char declaredNameKind(unsigned char first)
+{
+    return first >= '0' && first <= '9' ? TOK_INVALID_IDENTIFIER : TOK_IDENTIFIER;
+}
+// Token kind of each state a word can end in
+static const unsigned char wordStateKind[S_COUNT] = {
+    TOK_INVALID_IDENTIFIER, TOK_INVALID_IDENTIFIER, TOK_OPERATOR, TOK_PUNCTUATION, TOK_IDENTIFIER,
+    TOK_INTEGER, TOK_REAL, TOK_REAL, TOK_INVALID_IDENTIFIER};
+// Kind of the word s[0..n) that the DFA ended in state, with readable bytes
+// from s on; keeps the lexer's keyword state (*expecting) up to date. A
+// keyword sets it and any other word clears it, so it is simply whether
+// this word was a keyword; written as selects, since keywords come too
+// irregularly for a branch to predict.
+static inline unsigned char wordKind(bool *expecting, const unsigned char *s, size_t n, size_t readable, int state)
+{
+    bool keyword = state == S_IDENT && isKeywordSpan((const char *)s, (unsigned int)n, readable);
+    unsigned char kind = *expecting ? declaredNameKind(s[0]) : wordStateKind[state];
+    *expecting = keyword;
+    return keyword ? (unsigned char)TOK_KEYWORD : kind;
+}
+// State the DFA ends in after the word s[0..n)
+static inline int wordState(const unsigned char *s, size_t n)
+{
+    int state = tables.next[S_START][s[0]];
+    for (size_t i = 1; i < n; i++)
+        state = tables.next[state][s[i]];
+    return state;
+}
+// Fills tok with the next token; false at the end of input
+static inline bool nextToken(Lexer *lx, Token *tok)
+{
+    const unsigned char *s = (const unsigned char *)lx->src;
+    size_t pos = lx->pos, len = lx->len;
+    while (pos < len)
+    {
+        size_t start = pos;
+        int state = tables.next[S_START][s[pos++]];
+        if (state == S_SPACE)
+        {
+            // Most blank runs are a single space; only longer ones (line
+            // breaks and indentation) are worth a kernel call
+            if (pos < len && tables.cls[s[pos]] == CC_SPACE)
+                pos += scan.spaceRun(s + pos, len - pos);
+            continue;
         }
-        else if (isDelimiter(str[right]) && left != right || (right == len && left != right))
+        if (lx->skipComments && s[start] == '/' && pos < len && (s[pos] == '/' || s[pos] == '*'))
         {
-
-            char *subStr = subString(str, left, right - 1);
-
-            if (isKeyword(subStr))
+            if (s[pos] == '/')
             {
-
-                printf("'%s' IS A KEYWORD\n", subStr);
-
-                expectingIdentifier = true;
+                const void *nl = memchr(s + pos, '\n', len - pos);
+                pos = nl ? (const unsigned char *)nl - s : len;
             }
-            else if (expectingIdentifier)
+            else
             {
-
-                if (validIdentifier(subStr))
-                {
-
-                    printf("'%s' IS A VALID IDENTIFIER\n", subStr);
-                }
-                else
-                {
-
-                    printf("'%s' IS NOT A VALID IDENTIFIER\n", subStr);
-                }
-
-                expectingIdentifier = false;
+                pos += 1 + scan.commentEnd(s + pos + 1, len - pos - 1);
+                pos = pos + 2 < len ? pos + 2 : len; // unterminated: to the end
             }
-            else if (isInteger(subStr))
+            continue;
+        }
+        if (state == S_IDENT)
+            pos += scan.wordRun(s + pos, len - pos);
+        else
+        {
+            const unsigned char *row = tables.next[state];
+            while (pos < len)
             {
-
-                printf("'%s' IS AN INTEGER\n", subStr);
+                // Most transitions stay in the same state; running those in a
+                // tight loop keeps the state out of the per-byte dependency chain
+                while (row[s[pos]] == state && ++pos < len)
+                    ;
+                if (pos == len || row[s[pos]] == S_DONE)
+                    break;
+                state = row[s[pos++]];
+                row = tables.next[state];
             }
-            else if (isRealNumber(subStr))
+        }
+        tok->offset = (unsigned int)start;
+        tok->length = (unsigned int)(pos - start);
+        lx->pos = pos;
+        if (state == S_OPERATOR || state == S_PUNCT)
+            tok->kind = state == S_OPERATOR ? TOK_OPERATOR : TOK_PUNCTUATION;
+        else
+            tok->kind = wordKind(&lx->expectingIdentifier, s + start, tok->length, len - start, state);
+        return true;
+    }
+    lx->pos = pos;
+    return false;
+}
+// Offset just past the comment opening at q ("//" ends at its newline)
+size_t skipComment(const char *data, size_t len, size_t q)
+{
+    if (data[q + 1] == '/')
+    {
+        const char *nl = (const char *)memchr(data + q + 2, '\n', len - q - 2);
+        return nl ? nl - data : len;
+    }
+    size_t e = q + 2 + scan.commentEnd((const unsigned char *)data + q + 2, len - q - 2);
+    return e + 2 < len ? e + 2 : len;
+}
+// Tokenizes the rest of lx's input, calling sink(&tok) for every token
+// nextToken would return, 64 bytes at a time. A block's word and delimiter
+// masks give all its token starts at once (each delimiter, and each word
+// byte after a non-word byte), so blanks cost nothing per byte and the loop
+// branches per token rather than per run. A word that reaches the end of a
+// block is finished with wordRun and the next block starts after it, so a
+// block never begins inside a word; the same goes for skipped comments.
+template <class Sink>
+static inline void lexRange(Lexer *lx, Sink sink)
+{
+    const unsigned char *s = (const unsigned char *)lx->src;
+    size_t len = lx->len, base = lx->pos;
+    bool expecting = lx->expectingIdentifier; // locals, so they stay in registers
+    const bool skipComments = lx->skipComments;
+    Token tok;
+    while (base < len)
+    {
+        uint64_t word, delim;
+        if (len - base >= 64)
+            scan.classify(s + base, &word, &delim);
+        else
+            classifyScalar(s + base, len - base, &word, &delim);
+        uint64_t starts = delim | (word & ~(word << 1));
+        size_t next = base + 64;
+        while (starts)
+        {
+            unsigned int i = __builtin_ctzll(starts);
+            size_t start = base + i;
+            starts &= starts - 1;
+            tok.offset = (unsigned int)start;
+            if (delim >> i & 1)
             {
-
-                printf("'%s' IS A REAL NUMBER\n", subStr);
+                if (skipComments && s[start] == '/' && start + 1 < len &&
+                    (s[start + 1] == '/' || s[start + 1] == '*'))
+                {
+                    next = skipComment(lx->src, len, start);
+                    break;
+                }
+                tok.length = 1;
+                tok.kind = tables.cls[s[start]] == CC_OPERATOR ? TOK_OPERATOR : TOK_PUNCTUATION;
+                sink(&tok);
+                continue;
             }
-            else if (validIdentifier(subStr) && !isDelimiter(str[right - 1]))
+            uint64_t rest = ~word >> i; // zero if the word runs past the block
+            size_t n = rest ? __builtin_ctzll(rest) : 64 - i + scan.wordRun(s + base + 64, len - base - 64);
+            tok.length = (unsigned int)n;
+            tok.kind = wordKind(&expecting, s + start, n, len - start,
+                                tables.cls[s[start]] == CC_WORD ? S_IDENT : wordState(s + start, n));
+            sink(&tok);
+            if (!rest)
             {
-
-                printf("'%s' IS A VALID IDENTIFIER\n", subStr);
+                next = start + n;
+                break;
             }
-            else if (!validIdentifier(subStr) && !isDelimiter(str[right - 1]))
+        }
+        base = next;
+    }
+    lx->pos = len;
+    lx->expectingIdentifier = expecting;
+}
+// Same lines as parseReference prints; punctuation is not reported
+static const char *const tokenSuffix[] = {
+    "' IS A KEYWORD\n", "' IS A VALID IDENTIFIER\n", "' IS NOT A VALID IDENTIFIER\n",
+    "' IS AN INTEGER\n", "' IS A REAL NUMBER\n", "' IS AN OPERATOR\n", ""};
+static const unsigned char tokenSuffixLength[] = {15, 24, 28, 16, 19, 17, 0};
+// The suffixes again, zero-padded to 32 bytes so writeToken copies them
+// with fixed-size moves
+static const char tokenSuffixPadded[][32] = {
+    "' IS A KEYWORD\n", "' IS A VALID IDENTIFIER\n", "' IS NOT A VALID IDENTIFIER\n",
+    "' IS AN INTEGER\n", "' IS A REAL NUMBER\n", "' IS AN OPERATOR\n", ""};
+void printToken(FILE *out, const char *src, const Token *tok)
+{
+    if (tok->kind == TOK_PUNCTUATION)
+        return;
+    putc('\'', out);
+    fwrite(src + tok->offset, 1, tok->length, out);
+    fputs(tokenSuffix[tok->kind], out);
+}
+// Output through one large buffer and write(2), in place of per-token stdio
+struct Writer
+{
+    int fd;
+    char *buf;
+    size_t used, cap;
+    bool failed;
+};
+void writerInit(Writer *w, int fd, size_t cap)
+{
+    w->fd = fd;
+    w->buf = (char *)malloc(cap);
+    w->used = 0;
+    w->cap = cap;
+    w->failed = false;
+}
+void writerFlush(Writer *w)
+{
+    size_t done = 0;
+    while (done < w->used && !w->failed)
+    {
+        ssize_t n = write(w->fd, w->buf + done, w->used - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            w->failed = true;
+        else
+            done += n;
+    }
+    w->used = 0;
+}
+void writerPut(Writer *w, const char *data, size_t n)
+{
+    if (w->used + n > w->cap)
+    {
+        writerFlush(w);
+        if (n > w->cap)
+        {
+            // Larger than the whole buffer: write it straight through
+            char *saved = w->buf;
+            w->buf = (char *)data;
+            w->used = n;
+            writerFlush(w);
+            w->buf = saved;
+            return;
+        }
+    }
+    memcpy(w->buf + w->used, data, n);
+    w->used += n;
+}
+void writerClose(Writer *w)
+{
+    writerFlush(w);
+    free(w->buf);
+}
+// One room check per token; the suffix is copied as 32 bytes and the
+// padding past it is overwritten by the next token. Punctuation is written
+// too and then not counted, which is cheaper than a branch on the kind.
+// readable is how many bytes of src may be read from the token on: with 32
+// or more, a token up to that long is copied as 32 bytes too. Fields are
+// read into locals first, since the stores through p could alias them.
+static inline void writeToken(Writer *w, const char *src, const Token *tok, size_t readable = 0)
+{
+    size_t length = tok->length, kind = tok->kind;
+    size_t room = 1 + length + sizeof(tokenSuffixPadded[0]);
+    if (w->cap - w->used < room)
+    {
+        writerFlush(w);
+        if (w->cap < room)
+        {
+            if (tok->kind == TOK_PUNCTUATION)
+                return;
+            writerPut(w, "'", 1);
+            writerPut(w, src + tok->offset, tok->length);
+            writerPut(w, tokenSuffix[tok->kind], tokenSuffixLength[tok->kind]);
+            return;
+        }
+    }
+    size_t used = w->used;
+    char *p = w->buf + used;
+    const char *text = src + tok->offset;
+    *p = '\'';
+    if (length <= 32 && readable >= 32)
+        memcpy(p + 1, text, 32);
+    else
+        memcpy(p + 1, text, length);
+    memcpy(p + 1 + length, tokenSuffixPadded[kind], sizeof(tokenSuffixPadded[0]));
+    w->used = used + ((1 + length + tokenSuffixLength[kind]) & -(size_t)(kind != TOK_PUNCTUATION));
+}
+// First "//" or "/*" starting in [pos, limit), or limit. Every '/' outside a
+// comment starts a token, so this sees comments exactly as nextToken does.
+size_t nextCommentOpen(const char *data, size_t len, size_t pos, size_t limit)
+{
+    while (pos < limit)
+    {
+        const char *q = (const char *)memchr(data + pos, '/', limit - pos);
+        if (q == NULL)
+            return limit;
+        pos = q - data;
+        if (pos + 1 < len && (data[pos + 1] == '/' || data[pos + 1] == '*'))
+            return pos;
+        pos++;
+    }
+    return limit;
+}
+// Tokenizes a whole buffer in one pass, calling sink(window, base, tok) with
+// tok's offset relative to window = data + base. Token offsets are 32-bit,
+// so inputs past 1 GB are scanned in windows that end just after a blank,
+// where no token can straddle the cut; the lexer state carries over. When
+// comments are skipped, a cut inside one moves past its end, found as
+// resyncPoints finds it, since a comment is not a token the next window
+// could pick up halfway.
+template <class Sink>
+size_t lexBuffer(const char *data, size_t len, bool skipComments, Sink sink)
+{
+    const size_t window = (size_t)1 << 30;
+    const unsigned char *s = (const unsigned char *)data;
+    size_t start = 0, tokens = 0;
+    Lexer lx;
+    lexerInit(&lx, data, 0);
+    lx.skipComments = skipComments;
+    while (start < len)
+    {
+        size_t end = len - start > window ? start + window : len;
+        size_t pos = start; // everything before pos has been checked; pos is outside comments
+        for (;;)
+        {
+            while (end < len && tables.cls[s[end - 1]] != CC_SPACE)
+                end++;
+            size_t open = skipComments ? nextCommentOpen(data, len, pos, end) : end;
+            if (open == end)
+                break;
+            pos = skipComment(data, len, open);
+            end = std::max(end, pos);
+        }
+        lx.src = data + start;
+        lx.len = end - start;
+        lx.pos = 0;
+        lexRange(&lx, [&](const Token *tok)
+                 {
+            sink(lx.src, start, tok);
+            tokens++; });
+        start = end;
+    }
+    return tokens;
+}
+size_t tokenizeBuffer(const char *data, size_t len, Writer *out, bool skipComments)
+{
+    return lexBuffer(data, len, skipComments, [&](const char *window, size_t base, const Token *tok)
+                     { writeToken(out, window, tok, len - base - tok->offset); });
+}
+// Parallel lexing. The file is cut into chunks just after newlines that a
+// pre-pass has checked are outside any comment, so no token or comment
+// crosses a cut. Threads lex the chunks speculatively, each as if no keyword
+// came before; the in-order join then corrects the first word of any chunk
+// that really follows a keyword, the only state the lexer carries between
+// tokens. Output is byte-for-byte the sequential output.
+struct LexChunk
+{
+    size_t begin, end;
+    std::vector<Token> tokens; // offsets relative to begin
+    long firstWord;            // first token that is not an operator or punctuation, or -1
+    bool endsExpecting;        // lexer state at the end, from a fresh start
+    std::string text;
+};
+// Chunk boundaries: 0, the resync points near k * len / chunks, len
+std::vector<size_t> resyncPoints(const char *data, size_t len, size_t chunks, bool skipComments)
+{
+    std::vector<size_t> cuts(1, 0);
+    size_t pos = 0; // everything before pos has been checked; pos is outside comments
+    for (size_t k = 1; k < chunks && pos < len; k++)
+    {
+        size_t target = std::max(pos, len / chunks * k);
+        while (target < len)
+        {
+            const char *nl = (const char *)memchr(data + target, '\n', len - target);
+            if (nl == NULL)
+                break;
+            size_t cut = nl - data + 1;
+            size_t open = skipComments ? nextCommentOpen(data, len, pos, cut) : cut;
+            if (open == cut)
             {
-
-                printf("'%s' IS NOT A VALID IDENTIFIER\n", subStr);
+                if (cut < len)
+                    cuts.push_back(cut);
+                pos = cut;
+                break;
             }
+            pos = skipComment(data, len, open);
+            target = std::max(target, pos);
+        }
+        if (target >= len)
+            break;
+    }
+    cuts.push_back(len);
+    return cuts;
+}
+void lexChunk(const char *data, LexChunk *c, bool skipComments)
+{
+    Lexer lx;
+    lexerInit(&lx, data + c->begin, c->end - c->begin);
+    lx.skipComments = skipComments;
+    c->firstWord = -1;
+    lexRange(&lx, [&](const Token *tok)
+             {
+        if (c->firstWord < 0 && tok->kind != TOK_OPERATOR && tok->kind != TOK_PUNCTUATION)
+            c->firstWord = (long)c->tokens.size();
+        c->tokens.push_back(*tok); });
+    c->endsExpecting = lx.expectingIdentifier;
+}
+void appendToken(std::string &out, const char *src, const Token *tok)
+{
+    if (tok->kind == TOK_PUNCTUATION)
+        return;
+    out += '\'';
+    out.append(src + tok->offset, tok->length);
+    out.append(tokenSuffix[tok->kind], tokenSuffixLength[tok->kind]);
+}
+// Runs f(k) for every chunk index on up to threads threads
+template <class F>
+void forEachChunk(size_t chunks, int threads, F f)
+{
+    std::atomic<size_t> next(0);
+    auto work = [&]()
+    {
+        for (size_t k; (k = next++) < chunks;)
+            f(k);
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads && (size_t)t < chunks; t++)
+        pool.emplace_back(work);
+    work();
+    for (std::thread &t : pool)
+        t.join();
+}
+// Tokenizes data on threads threads, writing text to out or, if binary is
+// not NULL, adding the tokens to it; returns the token count
+size_t tokenizeParallel(const char *data, size_t len, bool skipComments, int threads, Writer *out,
+                        ts_writer *binary)
+{
+    // A few chunks per thread evens out the load; chunks stay under 1 GB
+    // so token offsets fit in 32 bits
+    size_t chunks = std::max((size_t)threads * 4, len / ((size_t)1 << 30) + 1);
+    std::vector<size_t> cuts = resyncPoints(data, len, chunks, skipComments);
+    std::vector<LexChunk> parts(cuts.size() - 1);
+    for (size_t k = 0; k < parts.size(); k++)
+    {
+        parts[k].begin = cuts[k];
+        parts[k].end = cuts[k + 1];
+    }
+    forEachChunk(parts.size(), threads, [&](size_t k)
+                 { lexChunk(data, &parts[k], skipComments); });
 
-            free(subStr);
+    bool expecting = false;
+    size_t tokens = 0;
+    for (LexChunk &c : parts)
+    {
+        if (c.firstWord >= 0)
+        {
+            Token &t = c.tokens[c.firstWord];
+            if (expecting && t.kind != TOK_KEYWORD)
+                t.kind = declaredNameKind(data[c.begin + t.offset]);
+            expecting = c.endsExpecting;
+        }
+        tokens += c.tokens.size();
+    }
 
-            left = right;
+    if (binary != NULL)
+    {
+        for (LexChunk &c : parts)
+            for (const Token &t : c.tokens)
+            {
+                bool named = t.kind == TOK_KEYWORD || t.kind == TOK_IDENTIFIER;
+                ts_writer_add(binary, t.kind, c.begin + t.offset, t.length,
+                              named ? data + c.begin + t.offset : NULL, t.length);
+            }
+        return tokens;
+    }
+    forEachChunk(parts.size(), threads, [&](size_t k)
+                 {
+        LexChunk &c = parts[k];
+        c.text.reserve((c.end - c.begin) * 3);
+        for (const Token &t : c.tokens)
+            appendToken(c.text, data + c.begin, &t);
+        std::vector<Token>().swap(c.tokens); });
+    for (LexChunk &c : parts)
+    {
+        writerPut(out, c.text.data(), c.text.size());
+        std::string().swap(c.text);
+    }
+    return tokens;
+}
+struct TokenizeOptions
+{
+    const char *outputPath; // "-" for stdout
+    bool skipComments;
+    bool binary;            // write a token stream instead of text
+    int threads;            // above 1: lex in parallel chunks
+};
+// Writes the tokens of data as a binary token stream (token_stream.h), with
+// keywords and identifiers interned; false if the input does not fit it
+static const char *const tokenKindNames[] = {
+    "KEYWORD", "IDENTIFIER", "INVALID_IDENTIFIER", "INTEGER", "REAL", "OPERATOR", "PUNCTUATION"};
+bool saveTokenStream(const char *data, size_t len, const TokenizeOptions *opt, size_t *tokens)
+{
+    ts_writer w;
+    ts_writer_init(&w);
+    if (opt->threads > 1)
+        *tokens = tokenizeParallel(data, len, opt->skipComments, opt->threads, NULL, &w);
+    else
+        *tokens = lexBuffer(data, len, opt->skipComments, [&](const char *window, size_t base, const Token *tok)
+                            {
+            bool named = tok->kind == TOK_KEYWORD || tok->kind == TOK_IDENTIFIER;
+            ts_writer_add(&w, tok->kind, base + tok->offset, tok->length,
+                          named ? window + tok->offset : NULL, tok->length); });
+    bool ok = ts_writer_save(&w, opt->outputPath, tokenKindNames,
+                             sizeof(tokenKindNames) / sizeof(tokenKindNames[0]), len) == 0;
+    ts_writer_free(&w);
+    return ok;
+}
+void parse(const char *str, size_t len, FILE *outputFile)
+{
+    Lexer lx;
+    lexerInit(&lx, str, len);
+    lexRange(&lx, [&](const Token *tok)
+             { printToken(outputFile, str, tok); });
+}
+void parse(char *str, FILE *outputFile)
+{
+    parse(str, strlen(str), outputFile);
+}
+void parseAndPrint(char *str)
+{
+    parse(str, stdout);
+}
+char *readWholeFile(const char *filename, size_t *len)
+{
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *buf = (char *)malloc(size + 1);
+    *len = fread(buf, 1, size, file);
+    buf[*len] = '\0';
+    fclose(file);
+    return buf;
+}
+// Calls f(line) for each line with its newline removed and other blanks
+// turned into spaces, the only blank parseReference treats as a delimiter
+template <class F>
+void forEachLine(const char *buf, size_t len, char *line, F f)
+{
+    size_t start = 0;
+    while (start < len)
+    {
+        size_t end = start;
+        while (end < len && buf[end] != '\n')
+            end++;
+        for (size_t i = start; i < end; i++)
+            line[i - start] = tables.cls[(unsigned char)buf[i]] == CC_SPACE ? ' ' : buf[i];
+        line[end - start] = line[end - start + 1] = '\0'; // parseReference reads one past the end
+        f(line);
+        start = end + 1;
+    }
+}
+int checkAgainstReference(const char *filename)
+{
+    size_t len;
+    char *buf = readWholeFile(filename, &len);
+    if (buf == NULL)
+    {
+        printf("Could not open %s\n", filename);
+        return 1;
+    }
+    char *line = (char *)malloc(len + 2);
+    char *expected = NULL, *actual = NULL;
+    size_t expectedLen = 0, actualLen = 0;
+    FILE *ref = open_memstream(&expected, &expectedLen);
+    FILE *dfa = open_memstream(&actual, &actualLen);
+    int lines = 0;
+    forEachLine(buf, len, line, [&](char *l)
+                {
+        parseReference(l, ref);
+        parse(l, dfa);
+        lines++; });
+    fclose(ref);
+    fclose(dfa);
+    bool same = expectedLen == actualLen && !memcmp(expected, actual, expectedLen);
+    printf("%d lines: %s (%zu vs %zu bytes of output)\n", lines,
+           same ? "outputs match" : "OUTPUTS DIFFER", expectedLen, actualLen);
+    // The block scanner against nextToken over the whole file, where blocks
+    // cross lines and comments can span them
+    for (int skip = 0; skip < 2 && len < ((size_t)1 << 32); skip++)
+    {
+        std::vector<Token> single, block;
+        Lexer lx;
+        Token tok;
+        lexerInit(&lx, buf, len);
+        lx.skipComments = skip;
+        while (nextToken(&lx, &tok))
+            single.push_back(tok);
+        lexerInit(&lx, buf, len);
+        lx.skipComments = skip;
+        lexRange(&lx, [&](const Token *t)
+                 { block.push_back(*t); });
+        size_t k = 0;
+        while (k < single.size() && k < block.size() && single[k].kind == block[k].kind &&
+               single[k].offset == block[k].offset && single[k].length == block[k].length)
+            k++;
+        bool match = k == single.size() && k == block.size();
+        printf("%zu tokens%s: block scanner %s", single.size(), skip ? " (comments skipped)" : "",
+               match ? "matches nextToken\n" : "DIFFERS from nextToken");
+        if (!match)
+            printf(" at token %zu\n", k);
+        same = same && match;
+    }
+    free(expected);
+    free(actual);
+    free(line);
+    free(buf);
+    return same ? 0 : 1;
+}
+double seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+int benchmark(const char *filename, int reps)
+{
+    size_t len;
+    char *buf = readWholeFile(filename, &len);
+    if (buf == NULL)
+    {
+        printf("Could not open %s\n", filename);
+        return 1;
+    }
+    char *line = (char *)malloc(len + 2);
+    FILE *sink = fopen("/dev/null", "w");
+    static char sinkBuffer[1 << 16];
+    setvbuf(sink, sinkBuffer, _IOFBF, sizeof(sinkBuffer));
+    double mb = len * (double)reps / 1e6;
+
+    double t0 = seconds();
+    for (int r = 0; r < reps; r++)
+        forEachLine(buf, len, line, [&](char *l)
+                    { parseReference(l, sink); });
+    double tRef = seconds() - t0;
+
+    Writer w;
+    writerInit(&w, fileno(sink), 1 << 20);
+    t0 = seconds();
+    for (int r = 0; r < reps; r++)
+        tokenizeBuffer(buf, len, &w, false);
+    writerFlush(&w);
+    double tPrint = seconds() - t0;
+    writerClose(&w);
+
+    size_t tokens = 0, single = 0;
+    Lexer lx;
+    Token tok;
+    t0 = seconds();
+    for (int r = 0; r < reps; r++)
+    {
+        lexerInit(&lx, buf, len);
+        lexRange(&lx, [&](const Token *)
+                 { tokens++; });
+    }
+    double tScan = seconds() - t0;
+    t0 = seconds();
+    for (int r = 0; r < reps; r++)
+    {
+        lexerInit(&lx, buf, len);
+        while (nextToken(&lx, &tok))
+            single++;
+    }
+    double tSingle = seconds() - t0;
+    fclose(sink);
+
+    printf("%.1f MB x %d, %zu tokens per pass\n", len / 1e6, reps, tokens / reps);
+    printf("  reference scanner + fprintf  %8.1f MB/s\n", mb / tRef);
+    printf("  block scanner + output       %8.1f MB/s  (%.1fx)\n", mb / tPrint, tRef / tPrint);
+    printf("  block scanner, tokens only   %8.1f MB/s  (%.1fx)\n", mb / tScan, tRef / tScan);
+    printf("  DFA nextToken, tokens only   %8.1f MB/s  (%.1fx)%s\n", mb / tSingle, tRef / tSingle,
+           single == tokens ? "" : "  (TOKEN COUNTS DIFFER)");
+    free(line);
+    free(buf);
+    return 0;
+}
+// Times isKeyword's strcmp chain against the perfect hash on every
+// identifier and keyword in FILE, in order
+int benchmarkKeywords(const char *filename, int reps)
+{
+    size_t len;
+    char *buf = readWholeFile(filename, &len);
+    if (buf == NULL)
+    {
+        printf("Could not open %s\n", filename);
+        return 1;
+    }
+    // Words are copied once, NUL-terminated, for isKeyword
+    char *words = (char *)malloc(len + 1);
+    Token *spans = (Token *)malloc(sizeof(Token) * (len / 2 + 1));
+    size_t count = 0, used = 0;
+    Lexer lx;
+    Token tok;
+    lexerInit(&lx, buf, len);
+    while (nextToken(&lx, &tok))
+        if (tok.kind == TOK_KEYWORD || tok.kind == TOK_IDENTIFIER)
+        {
+            memcpy(words + used, buf + tok.offset, tok.length);
+            spans[count].offset = used;
+            spans[count++].length = tok.length;
+            used += tok.length;
+            words[used++] = '\0';
         }
+
+    size_t hitsChain = 0, hitsHash = 0;
+    double t0 = seconds();
+    for (int r = 0; r < reps; r++)
+        for (size_t i = 0; i < count; i++)
+            hitsChain += isKeyword(words + spans[i].offset);
+    double tChain = seconds() - t0;
+    t0 = seconds();
+    for (int r = 0; r < reps; r++)
+        for (size_t i = 0; i < count; i++)
+            hitsHash += keyword_lookup(words + spans[i].offset, spans[i].length) >= 0;
+    double tHash = seconds() - t0;
+
+    double lookups = (double)count * reps;
+    printf("%zu words, %zu keywords%s\n", count, hitsHash / reps,
+           hitsChain == hitsHash ? "" : " (THE TWO DISAGREE)");
+    printf("  strcmp chain   %6.1f ns/word\n", tChain / lookups * 1e9);
+    printf("  perfect hash   %6.1f ns/word  (%.1fx)\n", tHash / lookups * 1e9, tChain / tHash);
+    free(spans);
+    free(words);
+    free(buf);
+    return hitsChain == hitsHash ? 0 : 1;
+}
+// Microbenchmark of the scan kernels: each set counts newlines, finds every
+// "*/" and tokenizes FILE (comments skipped), and must agree with the scalar
+// set on every count
+int benchmarkKernels(const char *filename, int reps)
+{
+    size_t len;
+    char *buf = readWholeFile(filename, &len);
+    if (buf == NULL)
+    {
+        printf("Could not open %s\n", filename);
+        return 1;
     }
-    return;
+    const unsigned char *s = (const unsigned char *)buf;
+    const ScanKernels *sets[3];
+    int count = availableKernels(sets);
+    ScanKernels saved = scan;
+    size_t expected[3] = {0, 0, 0};
+    bool agree = true;
+    double mb = len * (double)reps / 1e6, base[3] = {0, 0, 0};
+    printf("%.1f MB x %d\n%-8s %19s %19s %19s\n", len / 1e6, reps, "", "newlines", "comment ends", "tokenize");
+    for (int k = 0; k < count; k++)
+    {
+        scan = *sets[k];
+        size_t got[3] = {0, 0, 0};
+        double t[3];
+        double t0 = seconds();
+        for (int r = 0; r < reps; r++)
+            got[0] = scan.newlines(s, len);
+        t[0] = seconds() - t0;
+        t0 = seconds();
+        for (int r = 0; r < reps; r++)
+        {
+            got[1] = 0;
+            for (size_t pos = 0; (pos += scan.commentEnd(s + pos, len - pos)) < len; pos += 2)
+                got[1]++;
+        }
+        t[1] = seconds() - t0;
+        Lexer lx;
+        t0 = seconds();
+        for (int r = 0; r < reps; r++)
+        {
+            got[2] = 0;
+            lexerInit(&lx, buf, len);
+            lx.skipComments = true;
+            lexRange(&lx, [&](const Token *)
+                     { got[2]++; });
+        }
+        t[2] = seconds() - t0;
+        printf("%-8s", scan.name);
+        for (int i = 0; i < 3; i++)
+        {
+            if (k == 0)
+            {
+                expected[i] = got[i];
+                base[i] = t[i];
+            }
+            agree = agree && got[i] == expected[i];
+            printf(" %7.0f MB/s", mb / t[i]);
+            if (k > 0)
+                printf(" %5.1fx", base[i] / t[i]);
+            else
+                printf("       ");
+        }
+        printf("\n");
+    }
+    printf("%zu newlines, %zu comment ends, %zu tokens: %s\n", expected[0], expected[1], expected[2],
+           agree ? "all kernel sets agree" : "KERNEL SETS DISAGREE");
+    scan = saved;
+    free(buf);
+    return agree ? 0 : 1;
 }
 void tokenizeFromArray(char *statement)
 {
     parseAndPrint(statement);
 }
-void tokenizeFromFile(char *filename)
+// Maps the whole file and tokenizes it in one pass; "-" writes to stdout.
+// Returns 0, or 1 if the file could not be read or the output written.
+int tokenizeFromFile(const char *filename, const TokenizeOptions *opt)
 {
-    FILE *file, *outputFile;
-    char line[256];
-    file = fopen(filename, "r");
-    outputFile = fopen("output.txt", "w");
-    if (file == NULL || outputFile == NULL)
+    const char *outputPath = opt->outputPath;
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
     {
-
-        printf("Could not open file.\n");
-
-        return;
+        printf("Could not open %s\n", filename);
+        if (fd >= 0)
+            close(fd);
+        return 1;
     }
-    while (fgets(line, sizeof(line), file))
+    size_t len = (size_t)st.st_size;
+    const char *data = "";
+    if (len > 0)
     {
-
-        parse(line, outputFile);
+        void *p = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            printf("Could not map %s\n", filename);
+            close(fd);
+            return 1;
+        }
+        madvise(p, len, MADV_SEQUENTIAL);
+        data = (const char *)p;
     }
-    fclose(file);
-    fclose(outputFile);
-    printf("Tokenized Output is stored in output.txt\n");
+    bool toStdout = !strcmp(outputPath, "-");
+    int out = toStdout || opt->binary ? 1 : open(outputPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int status = 0;
+    if (opt->binary)
+    {
+        size_t tokens;
+        if (saveTokenStream(data, len, opt, &tokens))
+            printf("Tokenized %zu bytes (%zu tokens); token stream is stored in %s\n", len, tokens, outputPath);
+        else
+        {
+            printf("Could not write %s (the binary format holds files under 4 GB and tokens under 64 KB)\n",
+                   outputPath);
+            status = 1;
+        }
+    }
+    else if (out < 0)
+    {
+        printf("Could not open %s\n", outputPath);
+        status = 1;
+    }
+    else
+    {
+        Writer w;
+        writerInit(&w, out, 1 << 20);
+        size_t tokens = opt->threads > 1 ? tokenizeParallel(data, len, opt->skipComments, opt->threads, &w, NULL)
+                                         : tokenizeBuffer(data, len, &w, opt->skipComments);
+        writerClose(&w);
+        if (w.failed)
+        {
+            printf("Could not write %s\n", outputPath);
+            status = 1;
+        }
+        else if (!toStdout)
+            printf("Tokenized %zu bytes, %zu lines (%zu tokens); output is stored in %s\n", len,
+                   scan.newlines((const unsigned char *)data, len), tokens, outputPath);
+        if (!toStdout)
+            close(out);
+    }
+    if (len > 0)
+        munmap((void *)data, len);
+    close(fd);
+    return status;
+}
+// Reads an output path for the menu; a blank line keeps output.txt
+void askOutputPath(char *path, size_t size)
+{
+    printf("Output file (Enter for output.txt): ");
+    if (!fgets(path, size, stdin))
+        path[0] = '\0';
+    path[strcspn(path, "\n")] = '\0';
+    if (path[0] == '\0')
+        strcpy(path, "output.txt");
 }
 void tokenizeFromUserInput()
 {
@@ -286,10 +1494,44 @@ void tokenizeFromUserInput()
         lineCount++;
     }
     fclose(file);
-    tokenizeFromFile("input.txt");
+    char outputPath[256];
+    askOutputPath(outputPath, sizeof(outputPath));
+    TokenizeOptions opt = {outputPath, false, false, 1};
+    tokenizeFromFile("input.txt", &opt);
 }
-int main()
+int main(int argc, char **argv)
 {
+    if (argc >= 3 && !strcmp(argv[1], "--check"))
+        return checkAgainstReference(argv[2]);
+    if (argc >= 3 && !strcmp(argv[1], "--bench"))
+        return benchmark(argv[2], argc >= 4 ? atoi(argv[3]) : 5);
+    if (argc >= 3 && !strcmp(argv[1], "--bench-simd"))
+        return benchmarkKernels(argv[2], argc >= 4 ? atoi(argv[3]) : 5);
+    if (argc >= 3 && !strcmp(argv[1], "--bench-keywords"))
+        return benchmarkKeywords(argv[2], argc >= 4 ? atoi(argv[3]) : 5);
+    if (argc >= 2 && strncmp(argv[1], "--", 2))
+    {
+        TokenizeOptions opt = {"output.txt", false, false, 1};
+        for (int i = 2; i < argc; i++)
+        {
+            if (!strcmp(argv[i], "-o") && i + 1 < argc)
+                opt.outputPath = argv[++i];
+            else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+            {
+                opt.outputPath = argv[++i];
+                opt.binary = true;
+            }
+            else if (!strcmp(argv[i], "-j") && i + 1 < argc)
+            {
+                opt.threads = atoi(argv[++i]);
+                if (opt.threads <= 0)
+                    opt.threads = (int)std::max(1u, std::thread::hardware_concurrency());
+            }
+            else if (!strcmp(argv[i], "--skip-comments"))
+                opt.skipComments = true;
+        }
+        return tokenizeFromFile(argv[1], &opt);
+    }
 
     int choice;
     char statement[256];
@@ -317,10 +1559,13 @@ int main()
 
             break;
         case 2:
-
-            tokenizeFromFile("input.txt");
-
+        {
+            char outputPath[256];
+            askOutputPath(outputPath, sizeof(outputPath));
+            TokenizeOptions opt = {outputPath, false, false, 1};
+            tokenizeFromFile("input.txt", &opt);
             break;
+        }
         case 3:
 
             tokenizeFromUserInput();
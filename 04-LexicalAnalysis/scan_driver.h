@@ -0,0 +1,377 @@
+/* scan_driver.h
+ * Multi-file driver for the reentrant flex scanners (flex_lexer.l and the
+ * 05-PatternMatching tools). Each input file gets its own scanner, files are
+ * shared out to a pool of threads, and the output is printed in command-line
+ * order, so the result does not depend on the thread count. The first file
+ * not yet printed scans straight to stdout; a file handed out while an
+ * earlier one is still running is collected in memory and printed once the
+ * files before it are. With one thread or one file nothing is held back.
+ * Header-only C on pthreads; build with -pthread.
+ *
+ * The driver opens each file; a tool supplies scan(in, out, arg), which runs
+ * its own yyscan_t over in (SCAN_ATTACH) with yyout = out, writes its report
+ * to out and returns 0, or nonzero on failure. arg is passed through
+ * unchanged and must only be read, since the scans run at the same time.
+ *
+ *   scan_options opt;
+ *   if (scan_parse_args(argc, argv, 1, &opt) == 0)   FILE... [-j N] [--mmap] [--check]
+ *       return scan_run(&opt, scan, arg);
+ *
+ * With --mmap each file is mapped copy-on-write with two NUL bytes after its
+ * end, the end-of-buffer sentinels flex expects, and handed to the scanner
+ * with yy_scan_buffer: flex scans the mapping in place instead of read()ing
+ * into its own buffer and refilling it. flex writes a NUL after each token
+ * while it runs an action, so the mapping must be writable; MAP_PRIVATE keeps
+ * those writes out of the file.
+ *
+ * --check is the driver's self-test: it scans the files one after another,
+ * then several times with one thread per file, and reports whether every
+ * concurrent output matches the sequential one.
+ */
+#ifndef SCAN_DRIVER_H
+#define SCAN_DRIVER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SCAN_CHECK_ROUNDS 5
+
+typedef struct
+{
+    const char *path;
+    FILE *file;      /* read through stdio, or */
+    char *base;      /* mapped: base[size] and base[size + 1] are NUL */
+    size_t size;
+    size_t map_size;
+} scan_input;
+
+typedef int (*scan_fn)(scan_input *in, FILE *out, void *arg);
+
+/* Points a reentrant scanner at in; 0, or -1 if flex rejects the buffer.
+ * A macro so that it expands in the scanner's own file, next to the
+ * yy_scan_buffer and yyset_in flex generates there. */
+#define SCAN_ATTACH(in, scanner)                                                                    \
+    ((in)->base != NULL ? (yy_scan_buffer((in)->base, (in)->size + 2, scanner) != NULL ? 0 : -1) \
+                        : (yyset_in((in)->file, scanner), 0))
+
+typedef struct
+{
+    char *text; /* everything the scan wrote, if it did not go to stdout */
+    size_t size;
+    int status; /* scan's return value */
+    int done;
+} scan_result;
+
+typedef struct
+{
+    const char *const *paths;
+    int count;
+    int map;
+    scan_fn scan;
+    void *arg;
+    scan_result *results;
+    int stream;  /* print files in order as they finish */
+    int next;    /* next file to hand out, under lock */
+    int printed; /* files before this one are on stdout, under lock */
+    int failed;  /* files that could not be read, under lock */
+    pthread_mutex_t lock;
+} scan_jobs;
+
+typedef struct
+{
+    const char **paths; /* points into argv */
+    int count;
+    int threads;
+    int map;   /* --mmap */
+    int check;
+} scan_options;
+
+static inline int scan_default_threads(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+/* Opens path, mapped if map is set (regular files only) or as a FILE;
+ * 0, or -1 with errno set */
+static inline int scan_input_open(scan_input *in, const char *path, int map)
+{
+    struct stat st;
+    long page;
+    void *base;
+    int fd;
+    memset(in, 0, sizeof(*in));
+    in->path = path;
+    if (!map)
+        return (in->file = fopen(path, "r")) != NULL ? 0 : -1;
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return -1;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        if ((in->file = fdopen(fd, "r")) != NULL)
+            return 0;
+        close(fd);
+        return -1;
+    }
+    in->size = (size_t)st.st_size;
+    page = sysconf(_SC_PAGESIZE);
+    in->map_size = (in->size + 2 + page - 1) / page * page;
+    /* Zero pages cover the file and the sentinels; the file goes over the
+     * front, so the sentinels exist even when it ends on a page boundary */
+    base = mmap(NULL, in->map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base != MAP_FAILED && in->size > 0 &&
+        mmap(base, in->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        munmap(base, in->map_size);
+        base = MAP_FAILED;
+    }
+    close(fd);
+    if (base == MAP_FAILED)
+        return -1;
+    in->base = (char *)base;
+    in->base[in->size] = in->base[in->size + 1] = '\0';
+    return 0;
+}
+
+static inline void scan_input_close(scan_input *in)
+{
+    if (in->base != NULL)
+        munmap(in->base, in->map_size);
+    else if (in->file != NULL && in->file != stdin)
+        fclose(in->file);
+    memset(in, 0, sizeof(*in));
+}
+
+/* Scans file k into out; the scan's return value, or -1 if it cannot be opened */
+static inline int scan_to(scan_jobs *j, int k, FILE *out)
+{
+    scan_input in;
+    int status;
+    if (scan_input_open(&in, j->paths[k], j->map) != 0)
+        return -1;
+    status = j->scan(&in, out, j->arg);
+    scan_input_close(&in);
+    return status;
+}
+
+/* Scans file k into memory */
+static inline void scan_one(scan_jobs *j, int k)
+{
+    scan_result *r = &j->results[k];
+    FILE *out = open_memstream(&r->text, &r->size);
+    if (out == NULL)
+    {
+        r->status = -1;
+        return;
+    }
+    r->status = scan_to(j, k, out);
+    if (fclose(out) != 0 && r->status == 0)
+        r->status = -1;
+}
+
+/* Prints the files that are finished and next in order; call under lock */
+static inline void scan_print_done(scan_jobs *j)
+{
+    scan_result *r;
+    while (j->printed < j->count && (r = &j->results[j->printed])->done)
+    {
+        fwrite(r->text, 1, r->size, stdout);
+        free(r->text);
+        r->text = NULL;
+        if (r->status != 0)
+        {
+            fflush(stdout);
+            fprintf(stderr, "Could not read %s\n", j->paths[j->printed]);
+            j->failed++;
+        }
+        j->printed++;
+    }
+}
+
+static inline void *scan_worker(void *p)
+{
+    scan_jobs *j = (scan_jobs *)p;
+    int k, head;
+    for (;;)
+    {
+        pthread_mutex_lock(&j->lock);
+        k = j->next++;
+        head = j->stream && k == j->printed;
+        pthread_mutex_unlock(&j->lock);
+        if (k >= j->count)
+            return NULL;
+        /* Nothing else writes to stdout until this file is done */
+        if (head)
+            j->results[k].status = scan_to(j, k, stdout);
+        else
+            scan_one(j, k);
+        if (j->stream)
+        {
+            pthread_mutex_lock(&j->lock);
+            j->results[k].done = 1;
+            scan_print_done(j);
+            pthread_mutex_unlock(&j->lock);
+        }
+    }
+}
+
+static inline void scan_results_free(scan_result *results, int count)
+{
+    int k;
+    for (k = 0; k < count; k++)
+        free(results[k].text);
+    free(results);
+}
+
+/* Scans every file on up to threads threads; with stream set, prints them
+ * as they finish and counts failures in j->failed. 0, or -1 if out of memory.
+ * Free j->results with scan_results_free. */
+static inline int scan_pool(scan_jobs *j, const char *const *paths, int count, int threads, int map, scan_fn scan,
+                            void *arg, int stream)
+{
+    pthread_t *pool;
+    int started = 0, t;
+    j->paths = paths;
+    j->count = count;
+    j->map = map;
+    j->scan = scan;
+    j->arg = arg;
+    j->stream = stream;
+    j->next = j->printed = j->failed = 0;
+    j->results = (scan_result *)calloc(count > 0 ? count : 1, sizeof(scan_result));
+    if (j->results == NULL)
+        return -1;
+    if (threads > count)
+        threads = count;
+    pool = (pthread_t *)malloc((threads > 1 ? threads : 1) * sizeof(pthread_t));
+    if (pool == NULL)
+    {
+        free(j->results);
+        j->results = NULL;
+        return -1;
+    }
+    pthread_mutex_init(&j->lock, NULL);
+    /* The calling thread is the last worker; fewer threads if some fail to start */
+    for (t = 1; t < threads; t++)
+        if (pthread_create(&pool[started], NULL, scan_worker, j) == 0)
+            started++;
+    scan_worker(j);
+    for (t = 0; t < started; t++)
+        pthread_join(pool[t], NULL);
+    pthread_mutex_destroy(&j->lock);
+    free(pool);
+    return 0;
+}
+
+/* Scans every file into memory on up to threads threads; NULL if out of
+ * memory. Free the results with scan_results_free. */
+static inline scan_result *scan_all(const char *const *paths, int count, int threads, int map, scan_fn scan,
+                                    void *arg)
+{
+    scan_jobs j;
+    return scan_pool(&j, paths, count, threads, map, scan, arg, 0) == 0 ? j.results : NULL;
+}
+
+/* Prints each file's output in order; returns the number of files that failed */
+static inline int scan_files(const char *const *paths, int count, int threads, int map, scan_fn scan, void *arg)
+{
+    scan_jobs j;
+    if (scan_pool(&j, paths, count, threads, map, scan, arg, 1) != 0)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return count;
+    }
+    scan_results_free(j.results, count);
+    return j.failed;
+}
+
+/* Compares concurrent scans of the files with sequential ones; 0 if all match */
+static inline int scan_check(const char *const *paths, int count, int threads, int map, scan_fn scan, void *arg)
+{
+    scan_result *expected = scan_all(paths, count, 1, map, scan, arg), *actual;
+    int round, k, differ = 0;
+    if (expected == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    if (threads < count)
+        threads = count;
+    for (round = 0; round < SCAN_CHECK_ROUNDS; round++)
+    {
+        if ((actual = scan_all(paths, count, threads, map, scan, arg)) == NULL)
+        {
+            fprintf(stderr, "Out of memory\n");
+            differ++;
+            break;
+        }
+        for (k = 0; k < count; k++)
+            if (actual[k].status != expected[k].status || actual[k].size != expected[k].size ||
+                memcmp(actual[k].text, expected[k].text, expected[k].size) != 0)
+            {
+                printf("  round %d: %s differs from its sequential scan\n", round + 1, paths[k]);
+                differ++;
+            }
+        scan_results_free(actual, count);
+    }
+    printf("%d files, %d concurrent rounds on %d threads: %s\n", count, SCAN_CHECK_ROUNDS, threads,
+           differ ? "OUTPUTS DIFFER" : "outputs match sequential scans");
+    scan_results_free(expected, count);
+    return differ ? 1 : 0;
+}
+
+/* Collects argv[first..] into o: file names, -j N (0: one per core), --mmap
+ * and --check; returns 0, or -1 after printing a message for a bad -j */
+static inline int scan_parse_args(int argc, char **argv, int first, scan_options *o)
+{
+    int i;
+    o->paths = (const char **)malloc((argc > 0 ? argc : 1) * sizeof(char *));
+    o->count = 0;
+    o->threads = 0;
+    o->map = 0;
+    o->check = 0;
+    if (o->paths == NULL)
+        return -1;
+    for (i = first; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-j"))
+        {
+            char *end;
+            if (i + 1 >= argc || (o->threads = (int)strtol(argv[++i], &end, 10)) < 0 || *end != '\0')
+            {
+                fprintf(stderr, "-j takes a thread count\n");
+                free(o->paths);
+                o->paths = NULL;
+                return -1;
+            }
+        }
+        else if (!strcmp(argv[i], "--mmap"))
+            o->map = 1;
+        else if (!strcmp(argv[i], "--check"))
+            o->check = 1;
+        else
+            o->paths[o->count++] = argv[i];
+    }
+    if (o->threads == 0)
+        o->threads = scan_default_threads();
+    return 0;
+}
+
+/* Runs o's files through scan (or checks them); frees o's file list.
+ * Returns a process exit status. */
+static inline int scan_run(scan_options *o, scan_fn scan, void *arg)
+{
+    int status = o->check ? scan_check(o->paths, o->count, o->threads, o->map, scan, arg)
+                          : scan_files(o->paths, o->count, o->threads, o->map, scan, arg) != 0;
+    free(o->paths);
+    o->paths = NULL;
+    return status;
+}
+
+#endif
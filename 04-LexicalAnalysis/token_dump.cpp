@@ -0,0 +1,119 @@
+// Prints a binary token stream written by manual_lexer -b (format in token_stream.h).
+// Compile: g++ -O2 token_dump.cpp -o token_dump
+// ./token_dump FILE.tok                  header and one line per token (index, kind, offset, length, name)
+// ./token_dump FILE.tok --source SRC     also print each token's text from the source file
+// ./token_dump FILE.tok --stats          token counts per kind, distinct names and read speed
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "token_stream.h"
+
+static double seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Maps the source file the stream was made from; NULL if it cannot be read
+static const char *mapSource(const char *path, size_t *len)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        return NULL;
+    }
+    *len = (size_t)st.st_size;
+    void *p = *len ? mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0) : (void *)"";
+    close(fd);
+    return p == MAP_FAILED ? NULL : (const char *)p;
+}
+
+static void printStats(const ts_stream *ts)
+{
+    unsigned long long perKind[256] = {0}, named = 0;
+    for (uint32_t i = 0; i < ts->count; i++)
+    {
+        perKind[ts->kinds[i]]++;
+        named += ts->ids[i] != TS_NO_ID;
+    }
+    for (int k = 0; k < 256; k++)
+        if (perKind[k])
+            printf("  %-20s %12llu\n", ts_kind_name(ts, k), perKind[k]);
+    printf("  %llu named tokens, %u distinct names\n", named, ts->symbols);
+
+    // One pass over every array, as a later phase reading the stream would
+    int reps = 10;
+    unsigned long long sum = 0;
+    double t0 = seconds();
+    for (int r = 0; r < reps; r++)
+        for (uint32_t i = 0; i < ts->count; i++)
+            sum += ts->kinds[i] + ts->offsets[i] + ts->lengths[i] + ts->ids[i];
+    double t = seconds() - t0;
+    double bytes = (double)ts->count * 11 * reps;
+    printf("  read all fields: %.0f M tokens/s, %.0f MB/s (checksum %llu)\n", ts->count * (double)reps / t / 1e6,
+           bytes / t / 1e6, sum);
+}
+
+int main(int argc, char **argv)
+{
+    const char *file = NULL, *sourcePath = NULL;
+    bool stats = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--source") && i + 1 < argc)
+            sourcePath = argv[++i];
+        else if (!strcmp(argv[i], "--stats"))
+            stats = true;
+        else
+            file = argv[i];
+    }
+    if (file == NULL)
+    {
+        fprintf(stderr, "Usage: %s FILE.tok [--source SRC] [--stats]\n", argv[0]);
+        return 1;
+    }
+    ts_stream ts;
+    const char *err;
+    if (ts_open(&ts, file, &err) != 0)
+    {
+        fprintf(stderr, "%s: %s\n", file, err);
+        return 1;
+    }
+    size_t sourceLen = 0;
+    const char *source = NULL;
+    if (sourcePath != NULL)
+    {
+        source = mapSource(sourcePath, &sourceLen);
+        if (source == NULL || sourceLen != ts.header->source_size)
+        {
+            fprintf(stderr, "%s is not the source of %s\n", sourcePath, file);
+            return 1;
+        }
+    }
+    printf("%s: %u tokens, %u names, %u kinds, source %llu bytes\n", file, ts.count, ts.symbols, ts.kind_count,
+           (unsigned long long)ts.header->source_size);
+    if (stats)
+    {
+        printStats(&ts);
+        ts_close(&ts);
+        return 0;
+    }
+    for (uint32_t i = 0; i < ts.count; i++)
+    {
+        printf("%8u  %-20s %10u %5u", i, ts_kind_name(&ts, ts.kinds[i]), ts.offsets[i], ts.lengths[i]);
+        size_t n;
+        const char *name = ts_name(&ts, ts.ids[i], &n);
+        if (name != NULL)
+            printf("  #%-6u %.*s", ts.ids[i], (int)n, name);
+        else if (source != NULL && (uint64_t)ts.offsets[i] + ts.lengths[i] <= sourceLen)
+            printf("  %-7s %.*s", "", (int)ts.lengths[i], source + ts.offsets[i]);
+        printf("\n");
+    }
+    ts_close(&ts);
+    return 0;
+}
@@ -0,0 +1,331 @@
+/* token_stream.h
+ * Binary token stream written by the lexers and read back by later phases
+ * without re-parsing text. Header-only C, so both manual_lexer.cpp and the
+ * C scanner flex generates can include it.
+ *
+ * Layout (little-endian; every section starts on an 8-byte boundary):
+ *   ts_header
+ *   kinds    u8[count]        lexer-defined token kind
+ *   offsets  u32[count]       byte offset of the token in the source
+ *   lengths  u16[count]       byte length
+ *   ids      u32[count]       interned name id, or TS_NO_ID
+ *   symbols  u32[symbols + 1] start of each name in the name bytes (+ end)
+ *   names    bytes            interned names, back to back, no terminators
+ *   kind names                kind_count NUL-terminated strings
+ *
+ * The arrays are parallel (struct of arrays), so a pass over one field reads
+ * only that field, and ts_open maps the file and points straight into it.
+ * Names are interned with interner.h, so ids follow order of first sight.
+ *
+ *   ts_writer w; ts_writer_init(&w);
+ *   ts_writer_add(&w, kind, offset, length, name, name_len);   (name may be NULL)
+ *   ts_writer_save(&w, "out.tok", kind_names, kind_count, source_size);
+ *
+ *   ts_stream ts;
+ *   if (ts_open(&ts, "out.tok", &err) == 0)
+ *       for (i = 0; i < ts.count; i++) ... ts.kinds[i], ts.offsets[i], ts_name(&ts, ts.ids[i], &len)
+ *   ts_close(&ts);
+ */
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "interner.h"
+
+#define TS_MAGIC "TOKS"
+#define TS_VERSION 1
+#define TS_NO_ID 0xFFFFFFFFu
+#define TS_MAX_LENGTH 0xFFFFu
+#define TS_MAX_OFFSET 0xFFFFFFFFu
+
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t count;      /* tokens */
+    uint32_t symbols;    /* distinct interned names */
+    uint32_t kind_count; /* entries in the kind name table */
+    uint32_t reserved;
+    uint64_t source_size;
+    /* Section offsets from the start of the file */
+    uint64_t kinds, offsets, lengths, ids, symbol_starts, names, kind_names;
+    uint64_t file_size;
+} ts_header;
+
+typedef struct
+{
+    uint8_t *kinds;
+    uint32_t *offsets;
+    uint16_t *lengths;
+    uint32_t *ids;
+    uint32_t count, cap;
+    intern_table names; /* ids are the interner's */
+    int failed;         /* set when a token does not fit the format */
+} ts_writer;
+
+static inline void ts_writer_init(ts_writer *w)
+{
+    memset(w, 0, sizeof(*w));
+    intern_init(&w->names);
+}
+
+static inline void ts_writer_free(ts_writer *w)
+{
+    free(w->kinds);
+    free(w->offsets);
+    free(w->lengths);
+    free(w->ids);
+    intern_free(&w->names);
+    memset(w, 0, sizeof(*w));
+}
+
+/* Appends a token; name (if not NULL) is interned and its id recorded.
+ * Returns 0 and sets failed if the token does not fit the format. */
+static inline int ts_writer_add(ts_writer *w, unsigned kind, uint64_t offset, size_t length, const char *name,
+                         size_t name_len)
+{
+    uint32_t cap, id = TS_NO_ID;
+    if (w->failed)
+        return 0;
+    if (kind > 0xFF || offset > TS_MAX_OFFSET || length > TS_MAX_LENGTH || w->count == 0xFFFFFFFFu)
+    {
+        w->failed = 1;
+        return 0;
+    }
+    if (w->count == w->cap)
+    {
+        void *p;
+        cap = w->cap ? w->cap * 2 : 4096;
+        if ((p = realloc(w->kinds, cap)) != NULL)
+            w->kinds = (uint8_t *)p;
+        if (p && (p = realloc(w->offsets, (size_t)cap * 4)) != NULL)
+            w->offsets = (uint32_t *)p;
+        if (p && (p = realloc(w->lengths, (size_t)cap * 2)) != NULL)
+            w->lengths = (uint16_t *)p;
+        if (p && (p = realloc(w->ids, (size_t)cap * 4)) != NULL)
+            w->ids = (uint32_t *)p;
+        if (p == NULL)
+        {
+            w->failed = 1;
+            return 0;
+        }
+        w->cap = cap;
+    }
+    if (name != NULL && (id = intern(&w->names, name, name_len)) == INTERN_NONE)
+    {
+        w->failed = 1;
+        return 0;
+    }
+    w->kinds[w->count] = (uint8_t)kind;
+    w->offsets[w->count] = (uint32_t)offset;
+    w->lengths[w->count] = (uint16_t)length;
+    w->ids[w->count] = id;
+    w->count++;
+    return 1;
+}
+
+static inline uint64_t ts_align(uint64_t n)
+{
+    return (n + 7) & ~(uint64_t)7;
+}
+
+static inline int ts_write_all(FILE *f, const void *p, size_t n, uint64_t *at)
+{
+    static const char zeros[8] = {0};
+    size_t pad = (size_t)(ts_align(*at + n) - (*at + n));
+    if ((n && fwrite(p, 1, n, f) != n) || (pad && fwrite(zeros, 1, pad, f) != pad))
+        return 0;
+    *at += n + pad;
+    return 1;
+}
+
+/* Writes the stream to path; returns 0 on success, -1 on failure */
+static inline int ts_writer_save(const ts_writer *w, const char *path, const char *const *kind_names,
+                          uint32_t kind_count, uint64_t source_size)
+{
+    ts_header h;
+    uint64_t at = 0, kind_bytes = 0, names_size = 0;
+    uint32_t k, symbols = w->names.count, *starts;
+    FILE *f;
+    int ok;
+    if (w->failed)
+        return -1;
+    /* Name starts in id order; the names themselves are copied from the arena */
+    starts = (uint32_t *)malloc(((size_t)symbols + 1) * 4);
+    if (starts == NULL)
+        return -1;
+    for (k = 0; k < symbols; k++)
+    {
+        starts[k] = (uint32_t)names_size;
+        names_size += w->names.lengths[k];
+    }
+    starts[symbols] = (uint32_t)names_size;
+    if (names_size > 0xFFFFFFFFu)
+    {
+        free(starts);
+        return -1;
+    }
+    for (k = 0; k < kind_count; k++)
+        kind_bytes += strlen(kind_names[k]) + 1;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TS_MAGIC, 4);
+    h.version = TS_VERSION;
+    h.count = w->count;
+    h.symbols = symbols;
+    h.kind_count = kind_count;
+    h.source_size = source_size;
+    h.kinds = ts_align(sizeof(h));
+    h.offsets = h.kinds + ts_align(w->count);
+    h.lengths = h.offsets + ts_align((uint64_t)w->count * 4);
+    h.ids = h.lengths + ts_align((uint64_t)w->count * 2);
+    h.symbol_starts = h.ids + ts_align((uint64_t)w->count * 4);
+    h.names = h.symbol_starts + ts_align(((uint64_t)symbols + 1) * 4);
+    h.kind_names = h.names + ts_align(names_size);
+    h.file_size = h.kind_names + ts_align(kind_bytes);
+    f = fopen(path, "wb");
+    if (f == NULL)
+    {
+        free(starts);
+        return -1;
+    }
+    ok = ts_write_all(f, &h, sizeof(h), &at) && ts_write_all(f, w->kinds, w->count, &at) &&
+         ts_write_all(f, w->offsets, (size_t)w->count * 4, &at) &&
+         ts_write_all(f, w->lengths, (size_t)w->count * 2, &at) &&
+         ts_write_all(f, w->ids, (size_t)w->count * 4, &at) &&
+         ts_write_all(f, starts, ((size_t)symbols + 1) * 4, &at);
+    free(starts);
+    for (k = 0; ok && k < symbols; k++)
+        ok = fwrite(w->names.names[k], 1, w->names.lengths[k], f) == w->names.lengths[k];
+    at += names_size;
+    ok = ok && ts_write_all(f, NULL, 0, &at);
+    for (k = 0; ok && k < kind_count; k++)
+        ok = fwrite(kind_names[k], 1, strlen(kind_names[k]) + 1, f) == strlen(kind_names[k]) + 1;
+    at += kind_bytes;
+    ok = ok && ts_write_all(f, NULL, 0, &at);
+    if (fclose(f) != 0)
+        ok = 0;
+    return ok && at == h.file_size ? 0 : -1;
+}
+
+/* A stream mapped read-only; the arrays point into the mapping */
+typedef struct
+{
+    const ts_header *header;
+    uint32_t count, symbols, kind_count;
+    const uint8_t *kinds;
+    const uint32_t *offsets;
+    const uint16_t *lengths;
+    const uint32_t *ids;
+    const uint32_t *symbol_starts;
+    const char *names;
+    const char *kind_names;
+    void *map;
+    size_t map_size;
+} ts_stream;
+
+/* Maps and validates path; returns 0, or -1 with a reason in err if given */
+static inline int ts_open(ts_stream *ts, const char *path, const char **err)
+{
+    struct stat st;
+    const ts_header *h;
+    const char *reason = NULL;
+    int fd = open(path, O_RDONLY);
+    memset(ts, 0, sizeof(*ts));
+    if (fd < 0 || fstat(fd, &st) != 0)
+        reason = "cannot open file";
+    else if ((size_t)st.st_size < sizeof(ts_header))
+        reason = "file too short";
+    else if ((ts->map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+    {
+        ts->map = NULL;
+        reason = "cannot map file";
+    }
+    if (fd >= 0)
+        close(fd);
+    if (reason == NULL)
+    {
+        ts->map_size = (size_t)st.st_size;
+        h = (const ts_header *)ts->map;
+        if (memcmp(h->magic, TS_MAGIC, 4) != 0)
+            reason = "not a token stream";
+        else if (h->version != TS_VERSION)
+            reason = "unsupported version";
+        else if (h->file_size != ts->map_size || h->kinds < sizeof(ts_header) ||
+                 h->offsets < h->kinds + h->count || h->lengths < h->offsets + (uint64_t)h->count * 4 ||
+                 h->ids < h->lengths + (uint64_t)h->count * 2 ||
+                 h->symbol_starts < h->ids + (uint64_t)h->count * 4 ||
+                 h->names < h->symbol_starts + ((uint64_t)h->symbols + 1) * 4 || h->kind_names < h->names ||
+                 h->kind_names > h->file_size)
+            reason = "corrupt section table";
+        else
+        {
+            const char *base = (const char *)ts->map;
+            ts->header = h;
+            ts->count = h->count;
+            ts->symbols = h->symbols;
+            ts->kind_count = h->kind_count;
+            ts->kinds = (const uint8_t *)(base + h->kinds);
+            ts->offsets = (const uint32_t *)(base + h->offsets);
+            ts->lengths = (const uint16_t *)(base + h->lengths);
+            ts->ids = (const uint32_t *)(base + h->ids);
+            ts->symbol_starts = (const uint32_t *)(base + h->symbol_starts);
+            ts->names = base + h->names;
+            ts->kind_names = base + h->kind_names;
+            if (ts->symbol_starts[ts->symbols] > h->kind_names - h->names)
+                reason = "corrupt name table";
+        }
+    }
+    if (reason != NULL)
+    {
+        if (ts->map)
+            munmap(ts->map, ts->map_size);
+        memset(ts, 0, sizeof(*ts));
+        if (err)
+            *err = reason;
+        return -1;
+    }
+    return 0;
+}
+
+static inline void ts_close(ts_stream *ts)
+{
+    if (ts->map)
+        munmap(ts->map, ts->map_size);
+    memset(ts, 0, sizeof(*ts));
+}
+
+/* Bytes of interned name id (not NUL-terminated), or NULL for TS_NO_ID */
+static inline const char *ts_name(const ts_stream *ts, uint32_t id, size_t *len)
+{
+    if (id >= ts->symbols)
+    {
+        *len = 0;
+        return NULL;
+    }
+    *len = ts->symbol_starts[id + 1] - ts->symbol_starts[id];
+    return ts->names + ts->symbol_starts[id];
+}
+
+/* Name of a token kind from the stream's own table, or "?" */
+static inline const char *ts_kind_name(const ts_stream *ts, unsigned kind)
+{
+    const char *p = ts->kind_names, *end = (const char *)ts->map + ts->map_size;
+    unsigned k;
+    if (kind >= ts->kind_count)
+        return "?";
+    for (k = 0; k < kind && p < end; k++)
+    {
+        const char *z = (const char *)memchr(p, '\0', end - p);
+        p = z ? z + 1 : end;
+    }
+    return p < end ? p : "?";
+}
+
+#endif